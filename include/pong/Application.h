@@ -5,7 +5,10 @@
 #include "pong/InputDevice.h"
 #include "pong/Game.h"
 #include "pong/Renderer.h"
+#include "pong/JobSystem.h"
+#include "pong/Profiler.h"
 
+#include <chrono>
 #include <iostream>
 #include <cassert>
 
@@ -14,7 +17,10 @@ namespace pong
     class Application
     {
     private:
-        static const uint32_t c_fps = 60;
+        // Simulation runs at a fixed rate, rendering follows the display
+        static constexpr uint32_t c_simulationRate = 60;
+        static constexpr float c_fixedDeltaTime = 1.0f / c_simulationRate;
+        static constexpr float c_maxFrameTime = 0.25f;
         static Application *s_instance;
 
         Renderer m_renderer;
@@ -22,6 +28,15 @@ namespace pong
         Connection m_connection;
         InputDevice m_inputDevice;
         AudioPlayer m_audioPlayer;
+        JobSystem m_jobSystem;
+
+        // Job timings, printed about once a second with ?profile=true or PONG_PROFILE=1
+        Profiler m_profiler;
+        bool m_profiling = false;
+        float m_profileTime = 0.0f;
+
+        std::chrono::steady_clock::time_point m_lastFrameTime;
+        float m_accumulator = 0.0f;
 
     public:
         Application()
@@ -42,10 +57,13 @@ namespace pong
         static Connection &GetConnection() { return s_instance->m_connection; }
         static InputDevice &GetInputDevice() { return s_instance->m_inputDevice; }
         static AudioPlayer &GetAudioPlayer() { return s_instance->m_audioPlayer; }
+        static JobSystem &GetJobSystem() { return s_instance->m_jobSystem; }
+        static Profiler &GetProfiler() { return s_instance->m_profiler; }
 
         void Initialize();
-        void Update(float deltaTime);
+        void Update(float frameTime);
         void Render();
+        void UpdateProfiler(float frameTime);
         void Terminate();
 
         void Run(const DeviceContext &context);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "pong/Messages.h"
+
+#include <cstdint>
+
+namespace pong
+{
+    // Dead reckons the ball while snapshots are late. The ball keeps flying along its last velocity and
+    // reflects off the top and bottom walls, for at most the configured horizon, after which it holds.
+    // When snapshots return the difference to the authoritative ball is blended out instead of snapped.
+    // Positions are in server units, the ball height follows from position and velocity in the game.
+    class BallExtrapolator
+    {
+    public:
+        struct Config
+        {
+            float horizon = 0.25f;    // Seconds of extrapolation before the ball holds
+            float blendRate = 15.0f;  // Correction decay per second, about 0.2 s to blend out
+            float snapDistance = 100.0f;
+            float arenaWidth = 800.0f;
+            float arenaHeight = 600.0f;
+            float ballRadius = 10.0f;
+        };
+
+        struct Stats
+        {
+            float extrapolationTime = 0.0f; // Of the current or last stall
+            float correction = 0.0f;        // Error when the last stall ended, server units
+            float maxCorrection = 0.0f;
+            float remainingCorrection = 0.0f;
+            uint32_t stalls = 0;
+            uint32_t snaps = 0;
+        };
+
+    private:
+        Config m_config;
+
+        Ball m_ball;
+        Ball m_stallStart;
+        glm::vec2 m_correction = {};
+        bool m_initialized = false;
+        bool m_stalled = false;
+        float m_stallTime = 0.0f;
+
+        Stats m_stats;
+
+    public:
+        BallExtrapolator() = default;
+        ~BallExtrapolator() = default;
+
+        void Initialize(const Config &config);
+
+        // Analytic position after time seconds, with wall reflections
+        Ball Advance(const Ball &ball, float time) const;
+
+        // Follows the authoritative ball, or extrapolates from the last one while stalled
+        const Ball &Update(const Ball &authoritative, bool stalled, float deltaTime);
+
+        void Reset() { m_initialized = false; }
+        const Stats &GetStats() const { return m_stats; }
+    };
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "pong/BallExtrapolator.h"
+#include "pong/Messages.h"
+#include "pong/JobSystem.h"
+#include "pong/WireFormat.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace pong
+{
+    // How well a bot plays, distances are in server units
+    struct BotDifficulty
+    {
+        float reactionTime = 0.2f; // Seconds between looks at the ball, the bot acts on its last look until the next
+        float aimError = 30.0f;    // Largest miss of the predicted intercept, drawn again on every look
+        float deadZone = 4.0f;     // Paddle holds when this close to its target
+    };
+
+    // What a bot sees of its match, in server units
+    struct BotObservation
+    {
+        Ball ball;
+        glm::vec2 paddle = {}; // Top left corner of the bot's paddle
+        bool valid = false;    // False until the bot has a paddle, keys are released meanwhile
+    };
+
+    // Bots that move to where they predict the ball crosses their paddle. The prediction reflects the ball
+    // off the walls with the same analytic model as the client's ball extrapolation. Per bot state lives in
+    // parallel arrays and all bots decide in one batch, split into chunks over the job system.
+    class BotBatch
+    {
+    public:
+        struct Config
+        {
+            float arenaWidth = wire::c_arenaWidth;
+            float arenaHeight = wire::c_arenaHeight;
+            float ballRadius = 10.0f;
+            float paddleWidth = 10.0f;
+            float paddleHeight = 100.0f;
+            float upDirection = -1.0f;
+            size_t grain = 512; // Bots per chunk handed to a worker
+        };
+
+    private:
+        Config m_config;
+        BallExtrapolator m_flight; // Only the const Advance is used, so workers share it
+
+        // Per bot, indexed by the id returned from Add
+        std::vector<BotDifficulty> m_difficulty;
+        std::vector<float> m_lookTimer; // Until the next look at the ball
+        std::vector<float> m_target;    // Planned top of the paddle
+        std::vector<uint32_t> m_random; // Xorshift state
+        std::vector<uint32_t> m_sequence;
+
+        // Arguments of the batch being decided
+        const BotObservation *m_observations = nullptr;
+        InputMessage *m_decisions = nullptr;
+        float m_deltaTime = 0.0f;
+        uint64_t m_timestamp = 0;
+
+        static void DecideRange(size_t begin, size_t end, void *userData);
+        void Decide(uint32_t bot);
+        float PredictIntercept(const BotObservation &observation) const;
+
+    public:
+        BotBatch() = default;
+        ~BotBatch() = default;
+
+        void Initialize(const Config &config);
+
+        uint32_t Add(const BotDifficulty &difficulty, uint32_t seed);
+        void Clear();
+
+        // Reads one observation and writes one decision per bot, both indexed by bot id. Timestamp is copied
+        // into the decisions, in milliseconds like the client's inputs. Without a job system it runs inline.
+        void DecideAll(const BotObservation *observations, InputMessage *decisions, float deltaTime, uint64_t timestamp, JobSystem *jobs);
+
+        uint32_t size() const { return uint32_t(m_difficulty.size()); }
+    };
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace pong
+{
+    // Append-only network capture. Layout, all little-endian:
+    //   Header  u8[4] "PCAP", u32 version, u64 indexOffset, u32 indexCount, u32 recordCount, u64 startTime (us)
+    //   Record  u8 direction, u8[3] reserved, u32 size, u64 time (us since startTime), u8[size] payload
+    //   Index   indexCount * (u64 time, u64 offset of the record), one entry every c_indexInterval records
+    // The index and counts are written on Close. A capture that was never closed has indexOffset 0
+    // and is read by scanning the records.
+    namespace capture
+    {
+        static constexpr uint8_t c_magic[4] = {'P', 'C', 'A', 'P'};
+        static constexpr uint32_t c_version = 1;
+        static constexpr size_t c_headerSize = 32;
+        static constexpr size_t c_recordHeaderSize = 16;
+        static constexpr uint32_t c_indexInterval = 256;
+        static constexpr uint32_t c_maxRecordSize = 1 << 20;
+    }
+
+    enum class CaptureDirection : uint8_t
+    {
+        Received = 0,
+        Sent = 1,
+    };
+
+    struct CaptureRecord
+    {
+        CaptureDirection direction = CaptureDirection::Received;
+        double time = 0.0; // Seconds since the start of the capture
+        std::vector<uint8_t> payload;
+    };
+
+    class CaptureWriter
+    {
+    private:
+        struct IndexEntry
+        {
+            uint64_t time = 0;
+            uint64_t offset = 0;
+        };
+
+        std::FILE *m_file = nullptr;
+        double m_startTime = 0.0;
+        uint64_t m_offset = 0;
+        uint32_t m_recordCount = 0;
+        std::vector<IndexEntry> m_index;
+
+    public:
+        CaptureWriter() = default;
+        ~CaptureWriter() { Close(); }
+
+        CaptureWriter(const CaptureWriter &) = delete;
+        CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+        // Times passed to Write are on the same clock as startTime, in seconds
+        bool Open(const std::string &path, double startTime);
+        void Close();
+
+        // Not thread safe, all transports deliver and send on the game loop thread
+        bool Write(CaptureDirection direction, double time, const uint8_t *data, size_t size);
+
+        bool IsOpen() const { return m_file != nullptr; }
+        uint32_t GetRecordCount() const { return m_recordCount; }
+    };
+
+    class CaptureReader
+    {
+    private:
+        struct IndexEntry
+        {
+            double time = 0.0;
+            uint64_t offset = 0;
+        };
+
+        std::FILE *m_file = nullptr;
+        double m_startTime = 0.0;
+        uint32_t m_recordCount = 0;
+        uint64_t m_recordsEnd = UINT64_MAX;
+        std::vector<IndexEntry> m_index;
+
+    public:
+        CaptureReader() = default;
+        ~CaptureReader() { Close(); }
+
+        CaptureReader(const CaptureReader &) = delete;
+        CaptureReader &operator=(const CaptureReader &) = delete;
+
+        bool Open(const std::string &path);
+        void Close();
+
+        // Returns false at the end of the capture or on a truncated record
+        bool Next(CaptureRecord &record);
+        // Positions the reader at or before the first record at time, using the index when there is one
+        bool Seek(double time);
+
+        double GetStartTime() const { return m_startTime; }
+        uint32_t GetRecordCount() const { return m_recordCount; }
+        bool HasIndex() const { return !m_index.empty(); }
+    };
+}
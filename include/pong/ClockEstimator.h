@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace pong
+{
+    // Round trip time and server clock offset estimate. Samples come from input acknowledgements (round
+    // trip only) and ping exchanges (round trip and offset). Queueing only ever adds delay, so the
+    // estimate uses the minimum round trip over a sliding window, NTP style, and the offset measured
+    // together with it.
+    class ClockEstimator
+    {
+    public:
+        struct Stats
+        {
+            float roundTrip = 0.1f;       // Seconds, minimum over the window
+            float smoothedRoundTrip = 0.1f;
+            float jitter = 0.0f;          // Mean deviation between consecutive round trips
+            double offset = 0.0;          // Server clock minus local clock, in seconds
+            bool hasOffset = false;
+            uint32_t samples = 0;
+        };
+
+    private:
+        static constexpr uint32_t c_windowSize = 16;
+        static constexpr double c_windowTime = 10.0;
+        static constexpr float c_smoothingGain = 1.0f / 8.0f;
+        static constexpr float c_jitterGain = 1.0f / 16.0f;
+
+        struct Sample
+        {
+            double time = 0.0;
+            float roundTrip = 0.0f;
+            double offset = 0.0;
+            bool hasOffset = false;
+        };
+
+        std::array<Sample, c_windowSize> m_window = {};
+        uint32_t m_next = 0;
+        uint32_t m_count = 0;
+        float m_lastRoundTrip = -1.0f;
+
+        Stats m_stats;
+
+        void AddSample(const Sample &sample);
+
+    public:
+        ClockEstimator() = default;
+        ~ClockEstimator() = default;
+
+        // Local send and receive time of a message the server echoed
+        void AddRoundTrip(double sendTime, double receiveTime);
+        // Ping exchange: local send, server receive, server send and local receive time
+        void AddExchange(double clientSend, double serverReceive, double serverSend, double clientReceive);
+
+        double ToServerTime(double localTime) const { return localTime + m_stats.offset; }
+        const Stats &GetStats() const { return m_stats; }
+    };
+}
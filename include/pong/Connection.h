@@ -1,102 +1,146 @@
 #pragma once
 
-#include <emscripten/emscripten.h>
-#include <emscripten/websocket.h>
-#include <glm/glm.hpp>
-
+#include "pong/Capture.h"
+#include "pong/ClockEstimator.h"
+#include "pong/EventJournal.h"
+#include "pong/Messages.h"
+#include "pong/NetworkSimulator.h"
+#include "pong/Transport.h"
+#include "pong/WireFormat.h"
+
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <cstdint>
 
 namespace pong
 {
-    enum class GameState : uint8_t
-    {
-        WaitingForPlayers = 0,
-        Starting = 1,
-        Running = 2,
-        InBetweenRounds = 3,
-        GameOver = 4,
-    };
-
-    struct Head
-    {
-        uint32_t playerId = 0;
-        uint32_t sequenceNumber = 0;
-    };
-
-    struct Player
-    {
-        uint32_t playerId = 0;
-        int32_t score = 0;
-        glm::vec2 position = {};
-    };
-
-    struct Ball
-    {
-        glm::vec2 position = {};
-        glm::vec2 velocity = {};
-    };
-
-    struct Events
-    {
-        bool hasHit = false;
-        bool playerWasHit = false;
-        bool hasSmashed = false;
-        bool newRound = false;
-    };
-
-    struct GameStateMessage
-    {
-        Head head;
-        std::vector<Player> players;
-        Ball ball;
-        Events events;
-        GameState state;
-        bool handeled = false;
-    };
-
-    struct InputMessage
-    {
-        bool upPressed = false;
-        bool downPressed = false;
-        uint32_t sequenceNumber = 0;
-        uint64_t timestamp = 0;
-    };
-
-    struct InputState
-    {
-        bool upPressed = false;
-        bool downPressed = false;
-    };
+    // Url of the server game to join, gameOffset counts from the game id of the page or environment
+    std::string GetServerUrl(uint32_t gameOffset, bool spectate);
 
     class Connection
     {
+    public:
+        struct ReceiveStats
+        {
+            uint32_t frames = 0;
+            uint64_t bytes = 0;
+            uint32_t dropped = 0;  // Game loop was a whole queue behind
+            uint32_t rejected = 0; // Malformed, or a delta against a baseline we no longer have
+            uint32_t stale = 0;    // Arrived after a newer snapshot, reordered or duplicated
+            uint32_t protocolVersion = 0; // 0 until the first game state decodes
+        };
+
+        struct InputStats
+        {
+            float sendRate = 0.0f;       // Packets per second
+            float bytesPerSecond = 0.0f;
+            float redundancy = 0.0f;     // Average inputs per packet
+            uint32_t packets = 0;
+            uint64_t bytes = 0;
+        };
+
     private:
-        const uint32_t c_maxMessages = 10;
+        const float c_inputTickRate = 30.0f;
+        const float c_statsWindow = 1.0f;
+        const float c_pingInterval = 1.0f;
+
+        struct PongSample
+        {
+            PingExchange exchange;
+            double receiveTime = 0.0;
+        };
 
-        EMSCRIPTEN_WEBSOCKET_T m_socket;
+        std::unique_ptr<ITransport> m_transport;
+        CaptureWriter m_capture;
+        SimulatedTransport *m_simulator = nullptr; // Owned by m_transport, null unless network conditions are simulated
 
         uint32_t m_sequenceNumber = 0;
-        std::mutex m_mutex;
-        std::vector<GameStateMessage> m_messages;
+        SpscRing<GameStateMessage, c_messageQueueSize> m_incoming; // Filled by the socket callback
+        MessageHistory m_messages;                                 // Only touched by the game loop
+        EventJournal m_events;                                     // Events of every snapshot, in arrival order
+        std::atomic<uint32_t> m_rejectedMessages = 0;
+        std::atomic<uint32_t> m_staleMessages = 0;
+        std::atomic<uint32_t> m_receivedFrames = 0;
+        std::atomic<uint64_t> m_receivedBytes = 0;
+        std::atomic<uint32_t> m_protocolVersion = 0; // Settled by the first game state that decodes
+
+        // Socket side state of the v2 protocol
+        SnapshotBaselines m_baselines;
+        QuantizedSnapshot m_snapshot;
+        uint32_t m_tick = 0;
+        uint16_t m_lastSnapshotId = wire::c_noBaseline;
+        SpscRing<PongSample, 8> m_pongs;
+
+        ClockEstimator m_clock;
+        uint32_t m_pingId = 0;
+        float m_pingTimer = 0.0f;
+        uint32_t m_lastEchoedInput = UINT32_MAX;
 
         InputState m_inputState;
+        InputState m_latchedState; // Keys pressed at any point during the current input tick
+        float m_inputAccumulator = 0.0f;
+
+        InputStats m_inputStats;
+        float m_statsTime = 0.0f;
+        uint32_t m_windowPackets = 0;
+        uint32_t m_windowInputs = 0;
+        uint32_t m_windowBytes = 0;
+        InputHistory m_pendingInputs; // Sent but not yet acknowledged, oldest first
 
     public:
         Connection() = default;
         ~Connection() = default;
 
+        // Connects to the server from the page or environment and starts capturing if asked to
         void Initialize();
+        void Initialize(const std::string &url);
+
+        static void OnReceive(const uint8_t *data, size_t size, void *userData);
+
+        // Records every received and sent frame until stopped
+        bool StartCapture(const std::string &path);
+        void StopCapture() { m_capture.Close(); }
+
+        // Transport clock, all message timestamps are on this clock
+        double GetTime() const { return m_transport != nullptr ? m_transport->GetTime() : GetReceiveClock(); }
+        // Per direction counters of the simulated link, null when conditions are not simulated
+        const SimulatedTransport *GetNetworkSimulator() const { return m_simulator; }
+
+        bool IsOpen() const { return m_transport != nullptr && m_transport->IsOpen(); }
+        void Send(const uint8_t *data, size_t size);
 
-        GameStateMessage ParseMessage(const uint8_t *message, size_t length);
-        std::vector<GameStateMessage> GetMessages() const { return m_messages; }
-        GameStateMessage *GetLatestMessage() const { return m_messages.size() > 0 ? const_cast<GameStateMessage *>(&m_messages.back()) : nullptr; }
-        GameStateMessage *PopLatestMessage();
-        void AddMessage(const GameStateMessage &message);
+        // Receive callback of the transport, runs on the game loop thread from Poll or from the browser's
+        // socket events. Decoding does not allocate, but v2 snapshots are acked from here and the frame
+        // is appended to the capture file when one is open.
+        void ReceiveMessage(const uint8_t *message, size_t length);
+        // Polls the transport, then moves received messages into the history, pointers into the history stay valid until the next poll
+        void PollMessages();
 
+        const MessageHistory &GetMessages() const { return m_messages; }
+        GameStateMessage *GetLatestMessage() { return m_messages.empty() ? nullptr : &m_messages.back(); }
+        ReceiveStats GetReceiveStats() const;
+
+        // Client side detections are pushed here as well, so every consumer reads one ordered stream
+        EventJournal &GetEvents() { return m_events; }
+
+        // Samples the input state and sends it at the input tick rate, called every simulation step
+        void UpdateInput(float deltaTime);
         void SendInput();
+        void SendSnapshotAck(uint16_t snapshotId);
+        void SendPing();
+
+        // Round trip and server clock estimate, from input acknowledgements and pings
+        const ClockEstimator::Stats &GetClockStats() const { return m_clock.GetStats(); }
+        double GetServerTime() const { return m_clock.ToServerTime(GetTime()); }
+
+        const InputState &GetInputState() const { return m_inputState; }
+        const InputStats &GetInputStats() const { return m_inputStats; }
+        const InputHistory &GetPendingInputs() const { return m_pendingInputs; }
+        // Drops inputs older than the acknowledged one, which is kept as the start of the replay
+        void AcknowledgeInput(uint32_t sequenceNumber);
 
-        void SendPressedUp(bool pressed);
-        void SendPressedDown(bool pressed);
+        void SetPressedUp(bool pressed);
+        void SetPressedDown(bool pressed);
     };
 }
\ No newline at end of file
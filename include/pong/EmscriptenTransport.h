@@ -0,0 +1,40 @@
+#pragma once
+
+#ifdef __EMSCRIPTEN__
+
+#include "pong/Transport.h"
+
+#include <emscripten/websocket.h>
+
+namespace pong
+{
+    // Browser WebSocket, messages arrive on the socket callbacks and Poll does nothing
+    class EmscriptenTransport : public ITransport
+    {
+    private:
+        EMSCRIPTEN_WEBSOCKET_T m_socket = 0;
+        bool m_open = false;
+
+        ReceiveCallback m_onReceive = nullptr;
+        void *m_userData = nullptr;
+
+        static EM_BOOL OnOpen(int eventType, const EmscriptenWebSocketOpenEvent *websocketEvent, void *userData);
+        static EM_BOOL OnError(int eventType, const EmscriptenWebSocketErrorEvent *websocketEvent, void *userData);
+        static EM_BOOL OnClose(int eventType, const EmscriptenWebSocketCloseEvent *websocketEvent, void *userData);
+        static EM_BOOL OnMessage(int eventType, const EmscriptenWebSocketMessageEvent *websocketEvent, void *userData);
+
+    public:
+        EmscriptenTransport() = default;
+        ~EmscriptenTransport() override { Close(); }
+
+        bool Connect(const std::string &url, ReceiveCallback onReceive, void *userData) override;
+        void Close() override;
+
+        bool Send(const uint8_t *data, size_t size) override;
+        void Poll() override {}
+
+        bool IsOpen() const override { return m_open; }
+    };
+}
+
+#endif
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace pong
+{
+    // Refers to an entity for as long as it exists, a removed entity's handle no longer resolves even if
+    // its slot has been reused
+    struct EntityHandle
+    {
+        uint32_t slot = UINT32_MAX;
+        uint32_t generation = 0;
+
+        bool operator==(const EntityHandle &) const = default;
+    };
+
+    // Maps entity ids and handles to dense indices, for components kept in parallel arrays. Removing swaps
+    // the last entity into the hole, so the arrays stay packed and are iterated front to back. Ids are
+    // looked up in an open addressing table, slots go through a sparse set with a generation per slot.
+    // Everything is inline, adding and removing never allocates.
+    template <uint32_t N>
+    class EntityIndex
+    {
+    public:
+        static constexpr uint32_t c_capacity = N;
+        static constexpr uint32_t c_invalid = UINT32_MAX;
+
+    private:
+        static constexpr uint32_t TableSize()
+        {
+            uint32_t size = 1;
+            while (size < 2 * N)
+            {
+                size *= 2;
+            }
+            return size;
+        }
+
+        static constexpr uint32_t c_tableSize = TableSize();
+        static constexpr uint32_t c_empty = UINT32_MAX;
+
+        std::array<uint32_t, N> m_denseToSlot = {};
+        std::array<uint32_t, N> m_slotToDense = {};
+        std::array<uint32_t, N> m_slotIds = {};
+        std::array<uint32_t, N> m_generations = {};
+        std::array<uint32_t, N> m_freeSlots = {};
+        uint32_t m_freeCount = 0;
+        uint32_t m_size = 0;
+
+        std::array<uint32_t, c_tableSize> m_table = {}; // Slot of the id hashed to each bucket
+
+        // Entities seen since the last BeginSync, for diffing against a complete list of ids
+        std::array<uint32_t, N> m_seen = {};
+        uint32_t m_syncStamp = 0;
+
+        static uint32_t Bucket(uint32_t id)
+        {
+            id ^= id >> 16;
+            id *= 0x45D9F3Bu;
+            id ^= id >> 16;
+            return id & (c_tableSize - 1);
+        }
+
+        uint32_t FindBucket(uint32_t id) const
+        {
+            for (uint32_t bucket = Bucket(id);; bucket = (bucket + 1) & (c_tableSize - 1))
+            {
+                const uint32_t slot = m_table[bucket];
+                if (slot == c_empty || m_slotIds[slot] == id)
+                {
+                    return bucket;
+                }
+            }
+        }
+
+        // Backward shift deletion, keeps every remaining id reachable from its home bucket
+        void EraseBucket(uint32_t bucket)
+        {
+            m_table[bucket] = c_empty;
+            for (uint32_t next = (bucket + 1) & (c_tableSize - 1); m_table[next] != c_empty; next = (next + 1) & (c_tableSize - 1))
+            {
+                const uint32_t home = Bucket(m_slotIds[m_table[next]]);
+                const bool stays = bucket <= next ? (home > bucket && home <= next) : (home > bucket || home <= next);
+                if (!stays)
+                {
+                    m_table[bucket] = m_table[next];
+                    m_table[next] = c_empty;
+                    bucket = next;
+                }
+            }
+        }
+
+    public:
+        EntityIndex() { Clear(); }
+
+        void Clear()
+        {
+            m_size = 0;
+            m_freeCount = N;
+            for (uint32_t i = 0; i < N; i++)
+            {
+                m_freeSlots[i] = N - 1 - i;
+            }
+            m_table.fill(c_empty);
+        }
+
+        uint32_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        // Dense index of a new entity at the end of the arrays, c_invalid if full or the id exists
+        uint32_t Add(uint32_t id)
+        {
+            const uint32_t bucket = FindBucket(id);
+            if (m_freeCount == 0 || m_table[bucket] != c_empty)
+            {
+                return c_invalid;
+            }
+
+            const uint32_t slot = m_freeSlots[--m_freeCount];
+            const uint32_t dense = m_size++;
+            m_table[bucket] = slot;
+            m_slotIds[slot] = id;
+            m_slotToDense[slot] = dense;
+            m_denseToSlot[dense] = slot;
+            m_seen[dense] = m_syncStamp;
+            return dense;
+        }
+
+        // Returns the dense index whose entity was moved into dense, the caller moves its components the
+        // same way. Equal to dense when the last entity was removed.
+        uint32_t Remove(uint32_t dense)
+        {
+            const uint32_t slot = m_denseToSlot[dense];
+            EraseBucket(FindBucket(m_slotIds[slot]));
+            m_generations[slot]++;
+            m_freeSlots[m_freeCount++] = slot;
+
+            const uint32_t last = --m_size;
+            const uint32_t lastSlot = m_denseToSlot[last];
+            m_denseToSlot[dense] = lastSlot;
+            m_slotToDense[lastSlot] = dense;
+            m_seen[dense] = m_seen[last];
+            return last;
+        }
+
+        uint32_t Find(uint32_t id) const
+        {
+            const uint32_t slot = m_table[FindBucket(id)];
+            return slot == c_empty ? c_invalid : m_slotToDense[slot];
+        }
+
+        EntityHandle GetHandle(uint32_t dense) const
+        {
+            const uint32_t slot = m_denseToSlot[dense];
+            return {slot, m_generations[slot]};
+        }
+
+        uint32_t Resolve(EntityHandle handle) const
+        {
+            if (handle.slot >= N || m_generations[handle.slot] != handle.generation)
+            {
+                return c_invalid;
+            }
+
+            const uint32_t dense = m_slotToDense[handle.slot];
+            return dense < m_size && m_denseToSlot[dense] == handle.slot ? dense : c_invalid;
+        }
+
+        uint32_t GetId(uint32_t dense) const { return m_slotIds[m_denseToSlot[dense]]; }
+
+        // Diffing: BeginSync, Mark every id that still exists, then remove whatever IsSeen is false for
+        void BeginSync() { m_syncStamp++; }
+        void Mark(uint32_t dense) { m_seen[dense] = m_syncStamp; }
+        bool IsSeen(uint32_t dense) const { return m_seen[dense] == m_syncStamp; }
+    };
+}
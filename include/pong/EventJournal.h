@@ -0,0 +1,80 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+
+namespace pong
+{
+    enum class EventType : uint8_t
+    {
+        Hit = 0,        // Ball hit a paddle
+        PlayerHit = 1,  // A player was scored on
+        Smash = 2,
+        NewRound = 3,
+        TableBounce = 4,
+    };
+
+    enum class EventSource : uint8_t
+    {
+        Server = 0, // From a snapshot, happened at the snapshot's receive time
+        Client = 1, // Detected locally on the rendered state
+    };
+
+    struct GameEvent
+    {
+        // Positions are in server units, stored in 1/8 units from -512 to 1536
+        static constexpr float c_positionOffset = 512.0f;
+        static constexpr float c_positionScale = 8.0f;
+        static constexpr uint32_t c_positionMax = (1 << 14) - 1;
+
+        double time = 0.0; // Connection clock
+        uint32_t id = 0;   // Journal sequence number, consecutive
+        uint32_t tick = 0; // Server snapshot tick
+        uint32_t type : 3;
+        uint32_t source : 1;
+        uint32_t x : 14;
+        uint32_t y : 14;
+
+        GameEvent() : type(0), source(0), x(0), y(0) {}
+
+        EventType GetType() const { return EventType(type); }
+        EventSource GetSource() const { return EventSource(source); }
+        glm::vec2 GetPosition() const;
+        void SetPosition(glm::vec2 position);
+    };
+    static_assert(sizeof(GameEvent) == 24);
+
+    // Ring of the most recent game events. Every consumer reads through its own cursor and sees each event
+    // exactly once, in order, so several events arriving in one frame are all delivered instead of merged.
+    // A consumer that falls a whole ring behind skips the overwritten events and counts them as missed.
+    class EventJournal
+    {
+    public:
+        static constexpr uint32_t c_capacity = 64;
+
+        struct Cursor
+        {
+            uint32_t next = 0;
+            uint32_t missed = 0;
+        };
+
+    private:
+        std::array<GameEvent, c_capacity> m_events;
+        uint32_t m_next = 0;
+
+    public:
+        EventJournal() = default;
+        ~EventJournal() = default;
+
+        const GameEvent &Push(EventType type, EventSource source, uint32_t tick, glm::vec2 position, double time);
+
+        // Copies the next unread event, returns false once the cursor has caught up
+        bool Next(Cursor &cursor, GameEvent &event) const;
+
+        // New consumers only see events pushed after they were created
+        Cursor CreateCursor() const { return {m_next, 0}; }
+        uint32_t GetCount() const { return m_next; }
+    };
+}
@@ -1,8 +1,12 @@
 #pragma once
 
+#include "pong/BotBatch.h"
 #include "pong/Connection.h"
+#include "pong/Match.h"
 #include "pong/Model.h"
 #include "pong/Renderer.h"
+#include "pong/TextCache.h"
+#include "pong/TransformKernel.h"
 #include "pong/Texture.h"
 #include "pong/Sound.h"
 
@@ -10,80 +14,13 @@
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <map>
+#include <memory>
 #include <vector>
 #include <algorithm>
 #include <random>
 
 namespace pong
 {
-    // Scaling will effect the physics, ball and players will be squished
-    static constexpr glm::vec2 c_scaleFactor = glm::vec2(1.0f / 3.95f, 1.0f / 3.95f);
-    static constexpr float c_arenaWidth = 800.0f * c_scaleFactor.x;
-    static constexpr float c_arenaHeight = 600.0f * c_scaleFactor.y;
-
-    static constexpr float c_padelWidth = 10.0f * c_scaleFactor.x;
-    static constexpr float c_padelHeight = 100.0f * c_scaleFactor.y;
-
-    static constexpr float c_ballRadius = 10.0f * c_scaleFactor.x;
-
-    // Constants for 3D movement
-    static constexpr float c_padelTableHitOffset = 20.0f;
-    static constexpr float c_tabelHitLocation = 0.75f;
-
-    // Font constants
-    const float letterWidth = 148.0f;
-    const float letterWorldWidth = letterWidth * 0.1f;
-    const float letterSpacing = -4.0f;
-
-    // Component types
-    struct CTransform
-    {
-        glm::vec3 position;
-        glm::quat rotation;
-
-        CTransform() = default;
-        CTransform(const glm::vec3 &position, const glm::quat &rotation)
-            : position(position), rotation(rotation) {}
-
-        CTransform(const glm::mat4 &matrix)
-        {
-            SetMatrix(matrix);
-        }
-
-        glm::mat4 GetMatrix() const
-        {
-            return glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(rotation);
-        }
-
-        void SetMatrix(const glm::mat4 &matrix)
-        {
-            position = glm::vec3(matrix[3]);
-            rotation = glm::quat_cast(matrix);
-        }
-    };
-
-    // Entity types
-    struct EPlayer
-    {
-        int32_t id = 0;
-        float targetAngle = 90.0f;
-        float currentAngle = 0.0f;
-        uint32_t score = 0;
-        CTransform transform;
-    };
-
-    struct EBall
-    {
-        CTransform transform;
-        glm::vec3 velocity;
-    };
-
-    struct ETable
-    {
-        CTransform transform;
-    };
-
     struct ECamera
     {
         CTransform transform;
@@ -92,25 +29,45 @@ namespace pong
         glm::mat4 offset = glm::mat4(1.0f);
     };
 
+    // Slot of a match in the frame's render batch
+    struct VisibleMatch
+    {
+        uint32_t match = 0;
+        uint32_t firstPaddle = 0;
+    };
+
+    // Runs every match shown by the client. One match is the one we play, a match wall adds more that
+    // are only watched, laid out on a grid and drawn together.
     class Game
     {
     private:
-        // Entities
-        uint32_t m_playerId = 0;
-        std::map<uint32_t, EPlayer> m_players;
-        EBall m_ball;
-        ETable m_table = {{glm::vec3(c_arenaWidth / 2.0f, -79.0f, c_arenaHeight / 2.0f), glm::quat(glm::vec3(0.0f, glm::radians(90.0f), 0.0f))}};
+        // Room between neighbouring tables on the wall
+        static constexpr glm::vec2 c_wallSpacing = glm::vec2(2.0f * c_arenaWidth, 2.0f * c_arenaHeight);
+
+        // The first match is played with the application's connection, the others bring their own
+        std::vector<std::unique_ptr<Match>> m_matches;
+        std::vector<std::unique_ptr<Connection>> m_wallConnections;
+        glm::vec3 m_wallCenter = glm::vec3(c_arenaWidth / 2.0f, 0.0f, c_arenaHeight / 2.0f);
+        glm::vec2 m_wallSize = glm::vec2(c_arenaWidth, c_arenaHeight);
+
+        // With bots on every match's paddle is played by one, for soak tests
+        bool m_botsEnabled = false;
+        BotBatch m_bots;
+        std::vector<BotObservation> m_botObservations;
+        std::vector<InputMessage> m_botDecisions;
+
         ECamera m_camera = {{glm::lookAt(glm::vec3(c_arenaWidth / 2.0f, 250.0f, 2 * c_arenaHeight / 2.0f),
                                          glm::vec3(c_arenaWidth / 2.0f, 0.0f, c_arenaHeight / 2.0f),
                                          glm::vec3(0.0f, 1.0f, 0.0f))}};
+        std::mt19937 m_random;
 
-        // Text sprite instances
-        std::vector<SpriteBatch::Instance> m_waitingTextSprites;
-        std::vector<SpriteBatch::Instance> m_gameOverTextSprites;
-        std::vector<SpriteBatch::Instance> m_startingTextSprites;
+        // Text of every match
+        TextCache m_text;
 
-        // Game state
-        GameState m_state = GameState::Starting;
+        // Render extraction, every visible match fills its own slot of the same batches
+        MatchRenderBatch m_renderBatch;
+        std::vector<VisibleMatch> m_visibleMatches; // Indexed by slot
+        uint32_t m_culledMatches = 0;
 
         // Graphics
         std::unique_ptr<Model> m_ballModel;
@@ -125,10 +82,10 @@ namespace pong
         std::unique_ptr<Sound> m_winSound;
         std::unique_ptr<Sound> m_loseSound;
 
-        float CalculateBallHeight(glm::vec2 position, glm::vec2 velocity);
-        bool HasBallHitTable(glm::vec2 position, glm::vec2 velocity);
-        std::vector<SpriteBatch::Instance> GenerateTextSprites(const std::string &text, const glm::mat4 &transform, const glm::vec4 &tint = glm::vec4(1.0f)) const;
-        void PositionScoreInstances(std::vector<struct SpriteBatch::Instance> &instances, uint32_t score, glm::vec3 origin);
+        void LoadAssets(class Renderer &renderer);
+        void InitializeWall(class Renderer &renderer, uint32_t matchCount);
+        void UpdateBots(float deltaTime);
+        void UpdateCamera(float deltaTime);
 
     public:
         Game() = default;
@@ -136,7 +93,16 @@ namespace pong
 
         void Initialize(class Renderer &renderer);
         void Update(float deltaTime);
-        void Render(class Renderer &renderer);
+        // Alpha is how far the current frame is between the last two simulation steps
+        void Render(class Renderer &renderer, float alpha);
         void Terminate();
+
+        uint32_t GetMatchCount() const { return uint32_t(m_matches.size()); }
+        // Matches outside the view in the last rendered frame
+        uint32_t GetCulledMatchCount() const { return m_culledMatches; }
+
+        const SnapshotInterpolator::Stats &GetInterpolationStats() const { return m_matches.front()->GetInterpolationStats(); }
+        const PaddlePredictor::Stats &GetPredictionStats() const { return m_matches.front()->GetPredictionStats(); }
+        const BallExtrapolator::Stats &GetExtrapolationStats() const { return m_matches.front()->GetExtrapolationStats(); }
     };
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pong
+{
+    class Profiler;
+
+    // Work stealing job scheduler. Every thread owns a deque of jobs, it takes its newest job from the back
+    // while idle threads steal the oldest from the front of the others. Jobs can have children, a job only
+    // finishes once its children have, and continuations that are started when it finishes. With no
+    // workers (browser builds without pthreads) every job simply runs inline when it is started, so call
+    // sites are the same either way.
+    class JobSystem
+    {
+    public:
+        using JobFunction = void (*)(void *userData);
+        using RangeFunction = void (*)(size_t begin, size_t end, void *userData);
+
+        // Jobs live in a ring per thread, a finished job's slot is reused once the ring comes around to it
+        static constexpr uint32_t c_maxJobs = 1024;
+        static constexpr uint32_t c_maxContinuations = 4;
+
+        struct Job
+        {
+            const char *name = nullptr;
+            JobFunction function = nullptr; // Null for jobs that only group their children
+            RangeFunction range = nullptr;  // Set instead of function for chunks of a parallel loop
+            void *userData = nullptr;
+            size_t begin = 0;
+            size_t end = 0;
+            Job *parent = nullptr;
+            std::atomic<uint32_t> unfinished = 0; // Itself and its unfinished children
+            uint32_t continuationCount = 0;
+            std::array<Job *, c_maxContinuations> continuations = {};
+        };
+
+    private:
+        // Per thread, the main thread is index 0 and the workers follow
+        struct alignas(64) Queue
+        {
+            std::mutex mutex;
+            std::array<Job *, c_maxJobs> jobs = {};
+            uint32_t head = 0; // Oldest, stolen from here
+            uint32_t tail = 0; // Newest, pushed and popped by the owner
+
+            std::array<Job, c_maxJobs> storage;
+            uint32_t allocated = 0;
+        };
+
+        std::vector<std::unique_ptr<Queue>> m_queues;
+        std::vector<std::thread> m_workers;
+        Profiler *m_profiler = nullptr;
+
+        // Idle workers sleep until a job is queued
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::atomic<uint32_t> m_queued = 0;
+        bool m_stopping = false;
+
+        void WorkerMain(uint32_t index);
+        Job *Allocate(Queue &queue);
+        bool Push(Job *job);
+        Job *Pop(uint32_t index);
+        Job *Steal(uint32_t index);
+        Job *GetJob(uint32_t index);
+        void Execute(Job *job);
+        void Finish(Job *job);
+
+    public:
+        JobSystem() = default;
+        ~JobSystem() { Terminate(); }
+
+        JobSystem(const JobSystem &) = delete;
+        JobSystem &operator=(const JobSystem &) = delete;
+
+        // Zero workers runs everything on the calling thread. Job timings go to the profiler if there is one.
+        void Initialize(uint32_t workerCount, Profiler *profiler = nullptr);
+        void Terminate();
+
+        // Jobs may only be created and started on the main thread and from inside other jobs. A parent
+        // has to be created before its children and started after them. Once c_maxJobs jobs created on one
+        // thread are unfinished, Create runs other jobs until one of them is done.
+        Job *Create(const char *name, JobFunction function, void *userData, Job *parent = nullptr);
+        // Starts continuation once job and its children are done, has to be added before job is started
+        bool AddContinuation(Job *job, Job *continuation);
+        void Run(Job *job);
+        // Runs other jobs until job is done
+        void Wait(Job *job);
+        bool IsDone(const Job *job) const { return job->unfinished.load(std::memory_order_acquire) == 0; }
+
+        // Calls function on chunks of at most grain indices covering [0, count), returns once all are done.
+        // Chunks are independent jobs, so loops may start loops of their own.
+        void ParallelFor(size_t count, size_t grain, RangeFunction function, void *userData, const char *name = "ParallelFor");
+
+        uint32_t GetWorkerCount() const { return uint32_t(m_workers.size()); }
+        // Workers and the main thread
+        uint32_t GetThreadCount() const { return uint32_t(m_queues.size()); }
+
+        // Workers to start by default, one less than the hardware threads so the main thread keeps one
+        static uint32_t GetDefaultWorkerCount();
+    };
+}
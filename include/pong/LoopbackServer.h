@@ -0,0 +1,53 @@
+#pragma once
+
+#include "pong/Messages.h"
+#include "pong/Simulation.h"
+#include "pong/Transport.h"
+#include "pong/WireFormat.h"
+
+#include <cstdint>
+
+namespace pong
+{
+    // In-process stand-in for the game server. Runs the simulation against its AI opponent and speaks
+    // the same wire protocol, so the client networking code can run without a browser or the real server.
+    class LoopbackServer
+    {
+    public:
+        struct Config
+        {
+            uint32_t protocolVersion = wire::c_protocolVersion;
+            float tickRate = 60.0f;  // Simulation and snapshot rate
+            int32_t winningScore = 5;
+        };
+
+    private:
+        Config m_config;
+        Simulation m_simulation;
+        float m_accumulator = 0.0f;
+
+        // v2 delta compression against the last snapshot the client acked
+        uint16_t m_snapshotId = 0;
+        SnapshotBaselines m_sent;
+        uint16_t m_ackedSnapshot = wire::c_noBaseline;
+
+        // Server clock, deliberately not the client's clock so the offset estimate has something to find
+        double m_serverTime = 1000.0;
+        FixedVector<PingExchange, 4> m_pendingPongs;
+
+        void SendSnapshot(ITransport::ReceiveCallback onSend, void *userData);
+
+    public:
+        LoopbackServer() = default;
+        ~LoopbackServer() = default;
+
+        void Initialize(const Config &config);
+
+        // Handles a message sent by the client
+        void Receive(const uint8_t *data, size_t size);
+        // Advances the match and hands every snapshot to onSend
+        void Update(float deltaTime, ITransport::ReceiveCallback onSend, void *userData);
+
+        const GameStateMessage &GetState() const { return m_simulation.GetState(); }
+    };
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "pong/LoopbackServer.h"
+#include "pong/Transport.h"
+
+#include <chrono>
+
+namespace pong
+{
+    // Runs a LoopbackServer in process. Sends go straight to the server, snapshots are produced from
+    // Poll as wall clock time passes. Options come from the url query, e.g. loopback://?proto=1&rate=30
+    class LoopbackTransport : public ITransport
+    {
+    private:
+        LoopbackServer m_server;
+        bool m_open = false;
+
+        ReceiveCallback m_onReceive = nullptr;
+        void *m_userData = nullptr;
+        std::chrono::steady_clock::time_point m_lastPoll;
+
+    public:
+        LoopbackTransport() = default;
+        ~LoopbackTransport() override = default;
+
+        bool Connect(const std::string &url, ReceiveCallback onReceive, void *userData) override;
+        void Close() override { m_open = false; }
+
+        bool Send(const uint8_t *data, size_t size) override;
+        void Poll() override;
+
+        bool IsOpen() const override { return m_open; }
+
+        LoopbackServer &GetServer() { return m_server; }
+    };
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include "pong/BallExtrapolator.h"
+#include "pong/BotBatch.h"
+#include "pong/Connection.h"
+#include "pong/EntityStore.h"
+#include "pong/EventJournal.h"
+#include "pong/PaddlePredictor.h"
+#include "pong/Simulation.h"
+#include "pong/SnapshotInterpolator.h"
+#include "pong/Sound.h"
+#include "pong/TextCache.h"
+#include "pong/TransformKernel.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <array>
+#include <random>
+#include <vector>
+
+namespace pong
+{
+    // Scaling will effect the physics, ball and players will be squished
+    static constexpr glm::vec2 c_scaleFactor = glm::vec2(1.0f / 3.95f, 1.0f / 3.95f);
+    static constexpr float c_arenaWidth = 800.0f * c_scaleFactor.x;
+    static constexpr float c_arenaHeight = 600.0f * c_scaleFactor.y;
+
+    static constexpr float c_padelWidth = 10.0f * c_scaleFactor.x;
+    static constexpr float c_padelHeight = 100.0f * c_scaleFactor.y;
+
+    static constexpr float c_ballRadius = 10.0f * c_scaleFactor.x;
+
+    // Constants for 3D movement
+    static constexpr float c_padelTableHitOffset = 20.0f;
+    static constexpr float c_tabelHitLocation = 0.75f;
+
+    static constexpr uint32_t c_maxMatches = 64;
+
+    // Component types
+    struct CTransform
+    {
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+
+        CTransform() = default;
+        CTransform(const glm::vec3 &position, const glm::quat &rotation)
+            : position(position), rotation(rotation) {}
+
+        CTransform(const glm::mat4 &matrix)
+        {
+            SetMatrix(matrix);
+        }
+
+        glm::mat4 GetMatrix() const
+        {
+            return glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(rotation);
+        }
+
+        void SetMatrix(const glm::mat4 &matrix)
+        {
+            position = glm::vec3(matrix[3]);
+            rotation = glm::quat_cast(matrix);
+        }
+
+        static CTransform Interpolate(const CTransform &from, const CTransform &to, float alpha)
+        {
+            return CTransform(glm::mix(from.position, to.position, alpha), glm::slerp(from.rotation, to.rotation, alpha));
+        }
+    };
+
+    // Ball flight as two parabolas, from the paddle down to the table bounce and from there up to the other
+    // paddle. The coefficients of the current segment are cached and only refit when the ball turns, speeds
+    // up or bounces, so evaluating the height is a single polynomial in x.
+    struct CTrajectory
+    {
+        float origin = 0.0f; // Segment start along x
+        float c0 = 0.0f;     // height = (c2 * dx + c1) * dx + c0, with dx = x - origin
+        float c1 = 0.0f;
+        float c2 = 0.0f;
+        float velocityX = 0.0f;
+        bool bounced = false;
+        bool valid = false;
+        uint32_t fits = 0;
+
+        // Refits the segment if needed, returns true on the step the ball bounces on the table
+        bool Update(glm::vec2 position, glm::vec2 velocity);
+        void Fit(bool hasBounced, float vx);
+
+        float GetHeight(float x) const
+        {
+            const float dx = x - origin;
+            return (c2 * dx + c1) * dx + c0;
+        }
+    };
+
+    // Entity types
+
+    // Players as parallel arrays indexed by the dense index of the entity index. Dense indices change when
+    // a player is removed, handles from index.GetHandle stay valid until the player itself is removed.
+    struct EPlayers
+    {
+        static constexpr uint32_t c_capacity = c_maxPlayers;
+
+        EntityIndex<c_capacity> index;
+        std::array<CTransform, c_capacity> transforms;
+        std::array<CTransform, c_capacity> previousTransforms;
+        std::array<float, c_capacity> targetAngles;
+        std::array<float, c_capacity> currentAngles;
+        std::array<float, c_capacity> previousAngles;
+        std::array<int32_t, c_capacity> scores;
+        std::array<TextCache::Handle, c_capacity> scoreTexts;
+
+        uint32_t size() const { return index.size(); }
+
+        // Returns EntityIndex::c_invalid when full
+        uint32_t Add(uint32_t playerId, const glm::vec3 &position, TextCache::Handle scoreText);
+        void Remove(uint32_t player);
+    };
+
+    struct EBall
+    {
+        CTransform transform;
+        CTransform previousTransform;
+        glm::vec3 velocity;
+        CTrajectory trajectory;
+    };
+
+    struct ETable
+    {
+        CTransform transform;
+    };
+
+    struct ScheduledSound
+    {
+        Sound *sound = nullptr;
+        glm::vec3 position = glm::vec3(0.0f);
+        float volume = 1.0f;
+        float pitch = 1.0f;
+        double time = 0.0; // Connection clock
+    };
+
+    // Shared by every match, a match without sounds plays silently
+    struct MatchResources
+    {
+        TextCache *text = nullptr;
+        Sound *hitSound = nullptr;
+        Sound *smashSound = nullptr;
+        Sound *racketSound = nullptr;
+        Sound *winSound = nullptr;
+        Sound *loseSound = nullptr;
+    };
+
+    // Model instances of every visible match, drawn as one instanced batch per model. Every match writes
+    // to its own slot and paddle range, so matches are extracted in parallel.
+    struct MatchRenderBatch
+    {
+        static constexpr uint32_t c_maxPaddles = c_maxMatches * EPlayers::c_capacity;
+
+        TransformArrayStorage<c_maxPaddles> paddles;
+        uint32_t paddleCount = 0;
+        std::vector<glm::mat4> tables; // One per slot
+        std::vector<glm::mat4> balls;
+
+        void Resize(uint32_t slotCount, uint32_t newPaddleCount)
+        {
+            paddleCount = newPaddleCount;
+            tables.resize(slotCount);
+            balls.resize(slotCount);
+        }
+    };
+
+    // One table fed by one connection. Entity state is kept in the match's own arena coordinates, the
+    // origin places the match on the wall and is only added to what is rendered and heard.
+    class Match
+    {
+    private:
+        Connection *m_connection = nullptr;
+        MatchResources m_resources;
+        glm::vec3 m_origin = glm::vec3(0.0f);
+        bool m_controlled = false; // Our paddle is predicted from local or bot input, watched matches only follow snapshots
+        std::mt19937 m_random;
+
+        // Entities
+        uint32_t m_playerId = 0;
+        EPlayers m_players;
+        EBall m_ball;
+        ETable m_table = {{glm::vec3(c_arenaWidth / 2.0f, -79.0f, c_arenaHeight / 2.0f), glm::quat(glm::vec3(0.0f, glm::radians(90.0f), 0.0f))}};
+
+        // Text
+        TextCache::Handle m_waitingText = TextCache::c_invalidHandle;
+        TextCache::Handle m_gameOverText = TextCache::c_invalidHandle;
+        TextCache::Handle m_startingText = TextCache::c_invalidHandle;
+
+        // Game state
+        GameState m_state = GameState::Starting;
+        SnapshotInterpolator m_interpolator;
+        PaddlePredictor m_predictor;
+        BallExtrapolator m_ballExtrapolator;
+        uint32_t m_tick = 0;
+
+        // Every system reads the event journal through its own cursor
+        EventJournal::Cursor m_audioEvents;
+        EventJournal::Cursor m_cameraEvents;
+        FixedVector<ScheduledSound, 16> m_scheduledSounds;
+
+        void ScheduleSound(const ScheduledSound &scheduled);
+        void ScheduleEventSound(const GameEvent &event, double time);
+
+    public:
+        Match() = default;
+        ~Match() = default;
+
+        Match(const Match &) = delete;
+        Match &operator=(const Match &) = delete;
+
+        void Initialize(Connection &connection, const MatchResources &resources, const glm::vec3 &origin, bool controlled, uint32_t seed);
+        void Terminate();
+
+        // The connection has to be polled first, the scheduler polls every match before updating any.
+        // Matches update in parallel, sounds are only scheduled and played by PlaySounds.
+        void Update(float deltaTime);
+        // Plays the sounds that are due, on the main thread like all audio
+        void PlaySounds();
+        // Writes this match's instances to its slot and paddles from firstPaddle on, and places its score
+        // text. Alpha is as in Game::Render.
+        void Extract(MatchRenderBatch &batch, uint32_t slot, uint32_t firstPaddle, float alpha);
+        // Shows the text for the current state, or hides all of it when the match is culled
+        void SetTextVisible(bool visible);
+
+        // Reads the impacts since the last call, raising trauma to the strongest one. Returns false when
+        // nothing hit, so the camera can let its shake decay.
+        bool ReadCameraEvents(float &trauma);
+
+        // Our paddle and the ball as a bot sees them, in server units
+        BotObservation Observe() const;
+
+        // World space bounds of the table and everything on it
+        void GetBounds(glm::vec3 &min, glm::vec3 &max) const;
+
+        Connection &GetConnection() { return *m_connection; }
+        // Played locally or by a bot, spectated matches never send on their connection
+        bool IsControlled() const { return m_controlled; }
+        const EBall &GetBall() const { return m_ball; }
+        uint32_t GetPaddleCount() const { return m_players.size(); }
+        const glm::vec3 &GetOrigin() const { return m_origin; }
+
+        const SnapshotInterpolator::Stats &GetInterpolationStats() const { return m_interpolator.GetStats(); }
+        const PaddlePredictor::Stats &GetPredictionStats() const { return m_predictor.GetStats(); }
+        const BallExtrapolator::Stats &GetExtrapolationStats() const { return m_ballExtrapolator.GetStats(); }
+    };
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "pong/SnapshotRing.h"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+
+namespace pong
+{
+    static constexpr uint32_t c_maxPlayers = 8;
+    // Enough history for the snapshot interpolation delay
+    static constexpr uint32_t c_maxMessages = 32;
+    static constexpr uint32_t c_messageQueueSize = 16;
+    // Inputs sent but not yet acknowledged, older ones are dropped
+    static constexpr uint32_t c_maxPendingInputs = 64;
+
+    enum class GameState : uint8_t
+    {
+        WaitingForPlayers = 0,
+        Starting = 1,
+        Running = 2,
+        InBetweenRounds = 3,
+        GameOver = 4,
+    };
+
+    struct Head
+    {
+        uint32_t playerId = 0;
+        uint32_t sequenceNumber = 0;
+    };
+
+    struct Player
+    {
+        uint32_t playerId = 0;
+        int32_t score = 0;
+        glm::vec2 position = {};
+    };
+
+    struct Ball
+    {
+        glm::vec2 position = {};
+        glm::vec2 velocity = {};
+    };
+
+    // Event flags of a single snapshot as sent by the server, the game reads events from the EventJournal
+    struct Events
+    {
+        bool hasHit : 1 = false;
+        bool playerWasHit : 1 = false;
+        bool hasSmashed : 1 = false;
+        bool newRound : 1 = false;
+    };
+
+    struct GameStateMessage
+    {
+        Head head;
+        FixedVector<Player, c_maxPlayers> players;
+        Ball ball;
+        Events events;
+        GameState state;
+        uint32_t tick = 0; // Server snapshot counter, v1 servers have none so their frames are counted
+        bool handeled = false;
+        double receiveTime = 0.0; // Seconds on the GetReceiveClock() clock
+    };
+
+    struct InputMessage
+    {
+        bool upPressed = false;
+        bool downPressed = false;
+        uint32_t sequenceNumber = 0;
+        uint64_t timestamp = 0;
+    };
+
+    struct InputState
+    {
+        bool upPressed = false;
+        bool downPressed = false;
+    };
+
+    using MessageHistory = HistoryRing<GameStateMessage, c_maxMessages>;
+    using InputHistory = HistoryRing<InputMessage, c_maxPendingInputs>;
+
+    // Monotonic clock used to timestamp received messages
+    inline double GetReceiveClock()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
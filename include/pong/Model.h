@@ -4,6 +4,7 @@
 #include <webgpu/webgpu_cpp.h>
 
 #include <string>
+#include <vector>
 
 namespace pong
 {
@@ -29,6 +30,13 @@ namespace pong
             glm::vec2 texCoord;
         };
 
+        // Contents of a model file, read on any thread and uploaded by Create on the main thread
+        struct Data
+        {
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+        };
+
         Model() {}
         Model(const wgpu::Buffer &vertexBuffer, size_t vertexCount, const wgpu::Buffer &indexBuffer, size_t indexCount)
             : m_vertexBuffer(vertexBuffer), m_vertexCount(vertexCount), m_indexBuffer(indexBuffer), m_indexCount(indexCount) {}
@@ -39,6 +47,8 @@ namespace pong
         size_t GetVertexCount() { return m_vertexCount; }
         size_t GetIndexCount() { return m_indexCount; }
 
+        static bool Load(const std::string &path, Data &data);
+        static std::unique_ptr<Model> Create(const wgpu::Device &device, const wgpu::Queue &queue, const Data &data);
         static std::unique_ptr<Model> Create(const wgpu::Device &device, const wgpu::Queue &queue, const std::string &path);
         static std::unique_ptr<Model> CreateQuad(const wgpu::Device &device, const wgpu::Queue &queue, const glm::vec2 &size, const glm::vec3 &color);
         static std::unique_ptr<Model> CreateSpriteQuad(const wgpu::Device &device, const wgpu::Queue &queue);
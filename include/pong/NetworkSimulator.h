@@ -0,0 +1,152 @@
+#pragma once
+
+#include "pong/Transport.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pong
+{
+    enum class LatencyDistribution : uint8_t
+    {
+        Uniform = 0,     // latency +- jitter
+        Normal = 1,      // jitter is the standard deviation
+        Exponential = 2, // jitter is the mean extra delay, long tail of late packets
+    };
+
+    // Conditions of one direction of the link
+    struct LinkConditions
+    {
+        float latency = 0.0f; // One way, seconds
+        float jitter = 0.0f;  // Seconds
+        LatencyDistribution distribution = LatencyDistribution::Normal;
+        float loss = 0.0f;        // Average fraction of packets lost
+        float burstLength = 1.0f; // Average number of packets lost in a row
+        float duplicate = 0.0f;   // Fraction of packets delivered twice
+        float reorder = 0.0f;     // Fraction of packets held back so later ones overtake them
+        float reorderDelay = 0.02f;
+        float bandwidth = 0.0f;  // Bytes per second, 0 is unlimited
+        float queueTime = 1.0f;  // Packets that would wait longer than this for the bandwidth are dropped
+
+        bool IsEnabled() const;
+    };
+
+    struct NetworkConditions
+    {
+        std::string profile = "none";
+        uint32_t seed = 1;
+        LinkConditions up;   // Client to server
+        LinkConditions down; // Server to client
+
+        bool IsEnabled() const { return up.IsEnabled() || down.IsEnabled(); }
+    };
+
+    // Named profiles: none, lan, wifi, mobile, lossy and awful. Returns false for unknown names.
+    bool GetNetworkProfile(const std::string &name, NetworkConditions &conditions);
+
+    // Sets one parameter by name. Keys without an up. or down. prefix set both directions. Times are
+    // given in milliseconds, bandwidth in kbit/s and fractions as 0 to 1, e.g. latency=80, down.loss=0.05,
+    // bandwidth=256, distribution=exponential. profile=<name> resets everything to that profile.
+    bool SetNetworkParameter(NetworkConditions &conditions, const std::string &key, const std::string &value);
+
+    // Applies every net.<key>=<value> query parameter, net=<name> selects the profile first
+    bool ParseNetworkConditionsUrl(const std::string &url, NetworkConditions &conditions);
+    // Reads key = value lines, # starts a comment
+    bool LoadNetworkConditions(const std::string &path, NetworkConditions &conditions);
+
+    // One direction of the simulated link. Everything is driven by a seeded generator of its own, so the
+    // same conditions, seed and traffic always drop, duplicate and delay the same packets.
+    class SimulatedLink
+    {
+    public:
+        struct Stats
+        {
+            uint32_t packets = 0;    // Handed to the link
+            uint32_t delivered = 0;  // Including duplicates
+            uint32_t lost = 0;
+            uint32_t overflowed = 0; // Dropped because the bandwidth queue was full
+            uint32_t duplicated = 0;
+            uint32_t reordered = 0;
+            uint64_t bytes = 0;      // Delivered
+            uint32_t queued = 0;
+            float averageDelay = 0.0f; // Seconds from send to delivery
+            float maxDelay = 0.0f;
+        };
+
+    private:
+        struct Packet
+        {
+            double deliveryTime = 0.0;
+            double sendTime = 0.0;
+            uint64_t order = 0;
+            std::vector<uint8_t> data;
+        };
+
+        LinkConditions m_conditions;
+        uint64_t m_random = 0;
+        bool m_inBurst = false;
+
+        std::vector<Packet> m_queue; // Min heap on delivery time
+        std::vector<std::vector<uint8_t>> m_freeBuffers;
+        uint64_t m_order = 0;
+        double m_lastDelivery = 0.0;
+        double m_linkFree = 0.0;
+        double m_totalDelay = 0.0;
+
+        Stats m_stats;
+
+        static bool DeliversAfter(const Packet &lhs, const Packet &rhs);
+
+        double NextRandom();
+        double SampleDelay();
+        bool SampleLoss();
+        void Enqueue(const uint8_t *data, size_t size, double sendTime, double deliveryTime);
+
+    public:
+        SimulatedLink() = default;
+        ~SimulatedLink() = default;
+
+        void Initialize(const LinkConditions &conditions, uint64_t seed);
+
+        void Send(const uint8_t *data, size_t size, double now);
+        // Hands every packet due at now to onDeliver, in delivery order
+        void Deliver(double now, ITransport::ReceiveCallback onDeliver, void *userData);
+
+        const Stats &GetStats() const { return m_stats; }
+    };
+
+    // Wraps another transport and passes both directions through a SimulatedLink. Received messages are
+    // only delivered from Poll, including in the browser where the socket calls back on its own.
+    class SimulatedTransport : public ITransport
+    {
+    private:
+        std::unique_ptr<ITransport> m_transport;
+        NetworkConditions m_conditions;
+        SimulatedLink m_up;
+        SimulatedLink m_down;
+
+        ReceiveCallback m_onReceive = nullptr;
+        void *m_userData = nullptr;
+
+        static void OnReceive(const uint8_t *data, size_t size, void *userData);
+        static void OnSend(const uint8_t *data, size_t size, void *userData);
+
+    public:
+        SimulatedTransport(std::unique_ptr<ITransport> transport, const NetworkConditions &conditions);
+        ~SimulatedTransport() override = default;
+
+        bool Connect(const std::string &url, ReceiveCallback onReceive, void *userData) override;
+        void Close() override { m_transport->Close(); }
+
+        bool Send(const uint8_t *data, size_t size) override;
+        void Poll() override;
+
+        bool IsOpen() const override { return m_transport->IsOpen(); }
+        double GetTime() const override { return m_transport->GetTime(); }
+
+        const NetworkConditions &GetConditions() const { return m_conditions; }
+        const SimulatedLink::Stats &GetUpStats() const { return m_up.GetStats(); }
+        const SimulatedLink::Stats &GetDownStats() const { return m_down.GetStats(); }
+    };
+}
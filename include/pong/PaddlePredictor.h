@@ -0,0 +1,58 @@
+#pragma once
+
+#include "pong/Connection.h"
+#include "pong/Simulation.h"
+
+#include <cstdint>
+
+namespace pong
+{
+    // Predicts the local paddle from our own inputs and reconciles with the server by replaying
+    // the inputs it has not yet acknowledged. Positions are in server units along the paddle axis.
+    class PaddlePredictor
+    {
+    public:
+        struct Stats
+        {
+            float correction = 0.0f;  // Last misprediction, smoothed out over the following steps
+            float roundTrip = 0.0f;   // Seconds, as passed to the last reconcile
+            uint32_t pendingInputs = 0;
+            uint32_t snaps = 0;
+        };
+
+    private:
+        static constexpr float c_snapDistance = 100.0f;
+        static constexpr float c_correctionRate = 10.0f;
+
+        // Movement model, taken from the server rules
+        float m_minPosition = 0.0f;
+        float m_maxPosition = 0.0f;
+        float m_paddleSpeed = 0.0f;
+        float m_upDirection = -1.0f;
+
+        bool m_initialized = false;
+        float m_predicted = 0.0f;
+        float m_correction = 0.0f;
+
+        Stats m_stats;
+
+        float Direction(bool upPressed, bool downPressed) const;
+
+    public:
+        PaddlePredictor() = default;
+        ~PaddlePredictor() = default;
+
+        void Initialize(const Simulation::Config &rules);
+
+        // Rebuild the prediction from an authoritative position and the inputs sent after the acknowledged one
+        void Reconcile(float serverPosition, uint32_t acknowledged, double receiveTime, float roundTrip, const InputHistory &pendingInputs, double now);
+        void Step(const InputState &input, float deltaTime);
+        // Fade the remaining correction, Step does this itself so only call it on frames that reconciled instead
+        void Blend(float deltaTime);
+
+        bool IsActive() const { return m_initialized; }
+        void Reset() { m_initialized = false; }
+        float GetPosition() const { return m_predicted + m_correction; }
+        const Stats &GetStats() const { return m_stats; }
+    };
+}
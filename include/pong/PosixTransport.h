@@ -0,0 +1,61 @@
+#pragma once
+
+#ifndef __EMSCRIPTEN__
+
+#include "pong/Transport.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace pong
+{
+    // Native WebSocket client over a non-blocking TCP socket, all socket work happens in Poll.
+    // Implements the parts of RFC 6455 the game server uses: binary messages, fragmentation, ping and close.
+    class PosixTransport : public ITransport
+    {
+    private:
+        static constexpr size_t c_maxMessageSize = 1 << 20;
+        static constexpr size_t c_readSize = 4096;
+
+        enum class State : uint8_t
+        {
+            Closed,
+            Connecting,
+            Handshake,
+            Open,
+        };
+
+        int m_socket = -1;
+        State m_state = State::Closed;
+
+        ReceiveCallback m_onReceive = nullptr;
+        void *m_userData = nullptr;
+
+        std::vector<uint8_t> m_sendBuffer;
+        std::vector<uint8_t> m_receiveBuffer;
+        std::vector<uint8_t> m_message; // Payload of a fragmented message
+        std::mt19937 m_random;
+
+        bool Flush();
+        bool ReadAvailable();
+        bool ProcessHandshake();
+        bool ProcessFrames();
+        void QueueFrame(uint8_t opcode, const uint8_t *data, size_t size);
+
+    public:
+        PosixTransport() = default;
+        ~PosixTransport() override { Close(); }
+
+        bool Connect(const std::string &url, ReceiveCallback onReceive, void *userData) override;
+        void Close() override;
+
+        bool Send(const uint8_t *data, size_t size) override;
+        void Poll() override;
+
+        bool IsOpen() const override { return m_state == State::Open; }
+    };
+}
+
+#endif
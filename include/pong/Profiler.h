@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace pong
+{
+    // Time spent per named task. Every thread records into its own slot without locking, the slots are
+    // merged on the main thread between frames when no tasks run.
+    class Profiler
+    {
+    public:
+        struct Entry
+        {
+            const char *name = nullptr; // Compared by pointer, names are string literals
+            uint32_t count = 0;
+            float totalTime = 0.0f; // Seconds
+            float maxTime = 0.0f;
+        };
+
+    private:
+        struct alignas(64) Slot
+        {
+            std::vector<Entry> entries;
+        };
+
+        std::vector<Slot> m_slots;
+        std::vector<Entry> m_entries; // Merged since the last reset
+        uint32_t m_frames = 0;
+
+        static void Add(std::vector<Entry> &entries, const Entry &entry);
+
+    public:
+        Profiler() = default;
+        ~Profiler() = default;
+
+        void Initialize(uint32_t threadCount);
+
+        // Only thread may record into its slot
+        void Record(uint32_t thread, const char *name, float time);
+        // Merges what every thread recorded this frame
+        void EndFrame();
+        void Reset();
+
+        // Per task totals and the average time per frame over the frames since the last reset
+        void Print(std::ostream &out) const;
+
+        const std::vector<Entry> &GetEntries() const { return m_entries; }
+        uint32_t GetFrameCount() const { return m_frames; }
+    };
+}
@@ -3,14 +3,17 @@
 #include "pong/Device.h"
 #include "pong/Model.h"
 #include "pong/Texture.h"
+#include "pong/UploadRing.h"
 
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #define GLM_FORCE_LEFT_HANDED
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 #include <webgpu/webgpu_cpp.h>
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <array>
@@ -21,28 +24,53 @@ namespace pong
     struct RenderBatch
     {
         Model *model;
-        std::vector<glm::mat4> transforms;
+        uint32_t firstInstance = 0; // Into the frame's model instances, which are uploaded as one block
+        uint32_t instanceCount = 0;
     };
 
     struct SpriteBatch
     {
         Texture *texture;
+
+        // Compact instance for a quad lying in the xz-plane, rotated around the y-axis.
+        // The matrix is rebuilt in the vertex stage.
         struct Instance
+        {
+            glm::vec3 position = glm::vec3(0.0f);
+            float rotation = 0.0f;
+            glm::u16vec4 offsetAndSize = glm::u16vec4(0, 0, UINT16_MAX, UINT16_MAX); // Unorm
+            uint32_t scale = 0;                                                         // Half floats
+            uint32_t tint = UINT32_MAX;                                                 // RGBA8
+
+            Instance() = default;
+            Instance(const glm::vec3 &position, const glm::vec2 &scale, float rotation = 0.0f,
+                     const glm::vec4 &offsetAndSize = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), const glm::vec4 &tint = glm::vec4(1.0f))
+                : position(position), rotation(rotation),
+                  offsetAndSize(glm::round(glm::clamp(offsetAndSize, 0.0f, 1.0f) * float(UINT16_MAX))),
+                  scale(glm::packHalf2x16(scale)), tint(glm::packUnorm4x8(tint)) {}
+        };
+        static_assert(sizeof(Instance) == 32);
+
+        // Opt-in instance with an arbitrary transform
+        struct TransformInstance
         {
             glm::mat4 transform;
             glm::vec4 offsetAndSize = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
             glm::vec4 tint = glm::vec4(1.0f);
         };
 
-        std::vector<Instance> instances;
+        // Range in the renderer's compact or transform instance storage
+        uint32_t firstInstance = 0;
+        uint32_t instanceCount = 0;
+        bool transform = false;
     };
 
     class Renderer
     {
     private:
-        struct Uniforms
+        // Data that stays constant over all draws in a frame, per instance model matrices live in the instance buffer
+        struct FrameUniforms
         {
-            glm::mat4 model = glm::rotate(glm::mat4(1.0f), glm::radians(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
             glm::mat4 view = glm::lookAt(glm::vec3(200.0f, 300.0f, 200.0f), // Camera position in World Space
                                          glm::vec3(200.0f, 0.0, 150.0f),    // and looks at the origin
                                          glm::vec3(0.0f, 1.0f, 0.0f));      // Head is up
@@ -58,7 +86,7 @@ namespace pong
             float _padding[3];
         };
         // Check alignment
-        static_assert(sizeof(Uniforms) % 16 == 0);
+        static_assert(sizeof(FrameUniforms) % 16 == 0);
 
         struct SpriteUniforms
         {
@@ -68,6 +96,15 @@ namespace pong
 
         static_assert(sizeof(SpriteUniforms) % 16 == 0);
 
+        // Range of the packed sprite instances drawn with one texture
+        struct SpriteDraw
+        {
+            Texture *texture;
+            uint32_t firstInstance;
+            uint32_t instanceCount;
+            bool transform;
+        };
+
         // Constants
         const wgpu::TextureFormat c_swapChainFormat = wgpu::TextureFormat::BGRA8Unorm;
         const wgpu::TextureFormat c_depthFormat = wgpu::TextureFormat::Depth24Plus;
@@ -78,12 +115,13 @@ namespace pong
         constexpr static glm::vec2 c_shadowMapWorldSize = glm::vec2(400.0f, 200.0f);
         const static uint32_t c_shadowMapSize = 2048;
         const std::string c_canvasSelector = "#canvas";
-        const uint32_t c_maxInstances = 1000;
-        const uint32_t c_maxSprites = 50;
+        const uint64_t c_uploadRingSize = 1 << 20;
+        const uint32_t c_uploadBindingWindow = 1 << 16;
 
         // Window
         uint32_t m_width = c_width;
         uint32_t m_height = c_height;
+        float m_farPlane = 1000.0f;
 
         // Buffers
         wgpu::VertexBufferLayout m_vertexBufferLayout;
@@ -97,6 +135,7 @@ namespace pong
         // Pipeline
         wgpu::RenderPipeline m_shadowPipeline = {};
         wgpu::RenderPipeline m_spritePipeline = {};
+        wgpu::RenderPipeline m_spriteTransformPipeline = {};
         wgpu::RenderPipeline m_renderPipeline = {};
 
         // Swap chain
@@ -105,9 +144,10 @@ namespace pong
         // Shader
         wgpu::ShaderModule m_shaderModule = {};
 
-        // Bind group
-        std::array<wgpu::BindGroupLayout, 3> m_bindGroupLayouts = {};
-        wgpu::BindGroup m_bindGroup = {};
+        // Bind group (frame, instances, shadow map, sprite)
+        std::array<wgpu::BindGroupLayout, 4> m_bindGroupLayouts = {};
+        wgpu::BindGroup m_frameBindGroup = {};
+        wgpu::BindGroup m_instanceBindGroup = {};
         wgpu::BindGroup m_shadowBindGroup = {};
         std::unordered_map<uint32_t, wgpu::BindGroup> m_spriteBindGroups = {};
 
@@ -119,18 +159,26 @@ namespace pong
         wgpu::TextureView m_shadowDepthTextureView = {};
         wgpu::Sampler m_shadowDepthSampler = {};
 
-        // Uniforms
-        wgpu::Buffer m_uniformBuffer = {};
-        Uniforms m_uniforms;
+        // Uniforms and per-frame instance data, all sub-allocated from the upload ring
+        UploadRing m_uploadRing;
+        uint32_t m_uploadGeneration = 0;
 
-        wgpu::Buffer m_spriteUniformBuffer = {};
-        SpriteUniforms m_spriteUniforms;
+        FrameUniforms m_uniforms;
+        UploadRing::Allocation m_frameUniformAllocation = {};
+        UploadRing::Allocation m_instanceAllocation = {};
 
-        wgpu::Buffer m_spriteInstanceBuffer = {};
+        SpriteUniforms m_spriteUniforms;
+        UploadRing::Allocation m_spriteUniformAllocation = {};
+        UploadRing::Allocation m_spriteInstanceAllocation = {};
+        UploadRing::Allocation m_spriteTransformInstanceAllocation = {};
 
         // Batches
         std::vector<RenderBatch> m_batches;
+        std::vector<glm::mat4> m_modelInstances;
         std::vector<SpriteBatch> m_spriteBatches;
+        std::vector<SpriteDraw> m_spriteDraws;
+        std::vector<SpriteBatch::Instance> m_spriteInstances;
+        std::vector<SpriteBatch::TransformInstance> m_spriteTransformInstances;
 
         // Renderer assets
         std::unique_ptr<Model> m_quad = {};
@@ -149,6 +197,8 @@ namespace pong
 
         void AddSpriteBindGroup(Texture *texture);
 
+        void UploadBatches();
+        void UploadSpriteBatches();
         void RenderBatches(wgpu::RenderPassEncoder &pass);
         void RenderSpriteBatches(wgpu::RenderPassEncoder &pass);
 
@@ -162,17 +212,42 @@ namespace pong
 
         void Resize(uint32_t width, uint32_t height);
 
+        // Returns storage for count model matrices, to be filled before the next submit
+        glm::mat4 *AllocateInstances(Model *model, size_t count)
+        {
+            m_batches.push_back({model, uint32_t(m_modelInstances.size()), uint32_t(count)});
+            m_modelInstances.resize(m_modelInstances.size() + count);
+            return m_modelInstances.data() + m_batches.back().firstInstance;
+        }
+
         void SubmitInstances(Model *model, const std::vector<glm::mat4> &transforms)
         {
-            m_batches.push_back({model, transforms});
+            std::copy(transforms.begin(), transforms.end(), AllocateInstances(model, transforms.size()));
+        }
+
+        // Instances are copied into storage owned by the renderer, which keeps its capacity between frames
+        void SubmitInstances(Texture *texture, const SpriteBatch::Instance *instances, size_t count)
+        {
+            if (texture == nullptr || texture->GetId() == 0 || count == 0)
+                return;
+
+            m_spriteBatches.push_back({texture, uint32_t(m_spriteInstances.size()), uint32_t(count), false});
+            m_spriteInstances.insert(m_spriteInstances.end(), instances, instances + count);
+
+            // Create bind group if it doesn't exist
+            if (m_spriteBindGroups.find(texture->GetId()) == m_spriteBindGroups.end())
+            {
+                AddSpriteBindGroup(texture);
+            }
         }
 
-        void SubmitInstances(Texture *texture, const std::vector<SpriteBatch::Instance> &instances)
+        void SubmitInstances(Texture *texture, const SpriteBatch::TransformInstance *instances, size_t count)
         {
-            if (texture == nullptr || texture->GetId() == 0)
+            if (texture == nullptr || texture->GetId() == 0 || count == 0)
                 return;
 
-            m_spriteBatches.push_back({texture, instances});
+            m_spriteBatches.push_back({texture, uint32_t(m_spriteTransformInstances.size()), uint32_t(count), true});
+            m_spriteTransformInstances.insert(m_spriteTransformInstances.end(), instances, instances + count);
 
             // Create bind group if it doesn't exist
             if (m_spriteBindGroups.find(texture->GetId()) == m_spriteBindGroups.end())
@@ -181,20 +256,33 @@ namespace pong
             }
         }
 
+        void SubmitInstances(Texture *texture, const std::vector<SpriteBatch::Instance> &instances) { SubmitInstances(texture, instances.data(), instances.size()); }
+        void SubmitInstances(Texture *texture, const std::vector<SpriteBatch::TransformInstance> &instances) { SubmitInstances(texture, instances.data(), instances.size()); }
+
+        const UploadRing::Stats &GetUploadStats() const { return m_uploadRing.GetStats(); }
+
         void SetCameraView(const glm::mat4 &view)
         {
             m_uniforms.view = view;
             m_uniforms.camera = glm::vec4(glm::vec3(view[3]), 0.0f);
         }
 
+        // Far enough for the whole match wall
+        void SetFarPlane(float farPlane);
+        // Area covered by the shadow map, centered below the light
+        void SetShadowBounds(const glm::vec3 &center, const glm::vec2 &size);
+        glm::mat4 GetViewProjection() const { return m_uniforms.projection * m_uniforms.view; }
+
         void Render();
         void Tick();
         void Terminate();
 
         // Should be moved in the future
         std::unique_ptr<Model> CreateModel(const std::string &path) const { return Model::Create(m_device, m_queue, path); }
+        std::unique_ptr<Model> CreateModel(const Model::Data &data) const { return Model::Create(m_device, m_queue, data); }
         std::unique_ptr<Model> CreateQuad(const glm::vec2 &size, const glm::vec3 &color) const { return Model::CreateQuad(m_device, m_queue, size, color); }
 
         std::unique_ptr<Texture> CreateTexture(const std::string &path) const { return Texture::Create(m_device, m_queue, path); }
+        std::unique_ptr<Texture> CreateTexture(const Texture::Data &data) const { return Texture::Create(m_device, m_queue, data); }
     };
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "pong/Capture.h"
+#include "pong/Transport.h"
+
+#include <chrono>
+
+namespace pong
+{
+    // Plays the received frames of a capture back through the normal receive path. By default frames are
+    // delivered at their original pacing, with replay://path?fast=1 the capture clock instead advances a
+    // fixed step per Poll, so a harness that polls in a loop runs the capture as fast as it can and every
+    // run sees the same message timing. Sent records and everything the client sends are ignored.
+    class ReplayTransport : public ITransport
+    {
+    private:
+        CaptureReader m_reader;
+        CaptureRecord m_record;
+        bool m_hasRecord = false;
+        bool m_open = false;
+
+        bool m_fast = false;
+        double m_step = 1.0 / 60.0;
+        double m_time = 0.0; // Seconds since the start of the capture
+        std::chrono::steady_clock::time_point m_startTime;
+
+        ReceiveCallback m_onReceive = nullptr;
+        void *m_userData = nullptr;
+
+        uint32_t m_delivered = 0;
+
+        bool ReadReceived();
+
+    public:
+        ReplayTransport() = default;
+        ~ReplayTransport() override = default;
+
+        bool Connect(const std::string &url, ReceiveCallback onReceive, void *userData) override;
+        void Close() override;
+
+        bool Send(const uint8_t *, size_t) override { return m_open; }
+        void Poll() override;
+
+        // Stays open until every frame has been delivered
+        bool IsOpen() const override { return m_open; }
+        double GetTime() const override { return m_reader.GetStartTime() + m_time; }
+
+        uint32_t GetDelivered() const { return m_delivered; }
+    };
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "pong/Messages.h"
+#include "pong/WireFormat.h"
+
+#include <array>
+#include <cstdint>
+
+namespace pong
+{
+    // Authoritative rules of a two player match on the server's coordinate system. Stepping is
+    // deterministic, the same config and inputs give bit identical states on every run of a build.
+    // Across compilers and platforms that only holds for IEEE single precision math without fused
+    // multiply-adds, so Simulation.cpp is built with -ffp-contract=off and calls no libm functions,
+    // x87 or -ffast-math builds may still differ. No clock, socket or allocation is involved, so it
+    // runs inside the loopback server as well as headless, many matches per thread.
+    class Simulation
+    {
+    public:
+        static constexpr uint32_t c_playerCount = 2;
+        static constexpr uint32_t c_leftPlayerId = 1;
+        static constexpr uint32_t c_rightPlayerId = 2;
+
+        struct Config
+        {
+            float tickRate = 60.0f; // Steps per second
+            int32_t winningScore = 5;
+            bool rightPlayerAI = true; // Tracks the ball instead of following input
+
+            float arenaWidth = wire::c_arenaWidth;
+            float arenaHeight = wire::c_arenaHeight;
+            float paddleWidth = 10.0f;
+            float paddleHeight = 100.0f;
+            float paddleMargin = 20.0f;
+            float paddleSpeed = 300.0f;
+            float aiSpeed = 220.0f;
+            float upDirection = -1.0f;
+            float ballRadius = 10.0f;
+            float ballSpeed = 300.0f;
+            float ballSpeedup = 1.05f;
+            float roundDelay = 1.0f;
+        };
+
+        struct Stats
+        {
+            uint64_t steps = 0;
+            uint32_t hits = 0;
+            uint32_t sweptHits = 0; // Hits where the ball passed the paddle face within one step
+            uint32_t wallBounces = 0;
+            uint32_t rounds = 0;
+        };
+
+    private:
+        Config m_config;
+        GameStateMessage m_state;
+        std::array<InputState, c_playerCount> m_inputs = {};
+        std::array<uint32_t, c_playerCount> m_appliedInputs = {};
+        std::array<bool, c_playerCount> m_hasInput = {};
+        float m_stateTime = 0.0f;
+        uint32_t m_rounds = 0;
+        Stats m_stats;
+
+        void ResetBall();
+        void MovePaddles(float deltaTime);
+        void MoveBall(float deltaTime);
+        // Returns true and reflects the ball if it reaches the paddle of player during this step
+        bool CollidePaddle(uint32_t player, const glm::vec2 &start, float deltaTime);
+
+    public:
+        Simulation() = default;
+        ~Simulation() = default;
+
+        void Initialize(const Config &config);
+
+        // Inputs older than the last applied one of the player are ignored, returns false for those
+        bool ApplyInput(uint32_t player, uint32_t sequenceNumber, const InputState &input);
+        void ApplyInput(uint32_t player, const InputMessage &input) { ApplyInput(player, input.sequenceNumber, {input.upPressed, input.downPressed}); }
+
+        // Advances by one fixed step of 1 / tickRate, events in the state are those of this step only
+        void Step();
+
+        float GetTimeStep() const { return 1.0f / m_config.tickRate; }
+        uint32_t GetAppliedInput(uint32_t player) const { return m_appliedInputs[player]; }
+        const GameStateMessage &GetState() const { return m_state; }
+        const Config &GetConfig() const { return m_config; }
+        const Stats &GetStats() const { return m_stats; }
+    };
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "pong/Connection.h"
+
+#include <cstdint>
+
+namespace pong
+{
+    // Plays back server snapshots on the server's timeline, a small jitter dependent delay behind the
+    // newest one. Snapshots are placed at tick / serverTickRate, and the receive clock is mapped onto
+    // that timeline through the offset of the fastest arrival, so arrival jitter only sizes the delay
+    // and never reaches the interpolation weights.
+    class SnapshotInterpolator
+    {
+    public:
+        struct Sample
+        {
+            FixedVector<Player, c_maxPlayers> players;
+            Ball ball;
+            bool valid = false;
+            bool extrapolated = false; // Playback ran past the newest snapshot, which is held
+        };
+
+        struct Stats
+        {
+            uint32_t bufferDepth = 0;   // Snapshots ahead of the playback time
+            uint32_t lateSnapshots = 0; // Times playback ran past the newest snapshot
+            float interpDelay = 0.0f;
+            float interval = 0.0f;
+            float jitter = 0.0f;
+            float extrapolationTime = 0.0f; // Playback time past the newest snapshot
+        };
+
+    private:
+        static constexpr float c_minDelay = 0.03f;
+        static constexpr float c_maxDelay = 0.25f;
+        static constexpr float c_jitterMultiplier = 2.0f;
+        static constexpr float c_clockAdjustRate = 0.05f;
+        static constexpr float c_clockSnapThreshold = 0.25f;
+        static constexpr float c_estimateGain = 1.0f / 16.0f;
+        static constexpr float c_offsetGain = 1.0f / 256.0f;
+
+        double m_serverStep = 1.0 / 60.0;
+        double m_playbackTime = 0.0; // Server time
+        double m_lastReceiveTime = -1.0;
+        uint32_t m_lastTick = 0;
+        double m_clockOffset = 0.0; // Receive clock minus server time, tracks the fastest arrivals
+        bool m_hasClockOffset = false;
+        float m_interval = 1.0f / 60.0f;
+        float m_jitter = 0.0f;
+        float m_delay = c_minDelay;
+        bool m_extrapolating = false;
+
+        Sample m_sample;
+        Stats m_stats;
+
+        void AddArrival(const GameStateMessage &message);
+        double GetServerTime(const GameStateMessage &message) const { return double(message.tick) * m_serverStep; }
+
+    public:
+        SnapshotInterpolator() = default;
+        ~SnapshotInterpolator() = default;
+
+        // Ticks are spaced by one server step, v1 servers have no ticks and their frames are counted instead
+        void Initialize(float serverTickRate);
+
+        // Messages must be ordered by tick, now is on the same clock as the receive times
+        const Sample &Update(const MessageHistory &messages, double now, float deltaTime);
+
+        const Stats &GetStats() const { return m_stats; }
+    };
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace pong
+{
+    // Vector with inline storage, used where allocating is not allowed
+    template <typename T, uint32_t N>
+    class FixedVector
+    {
+    private:
+        std::array<T, N> m_items = {};
+        uint32_t m_count = 0;
+
+    public:
+        static constexpr uint32_t c_capacity = N;
+
+        // Returns false if the vector is full
+        bool push_back(const T &item)
+        {
+            if (m_count == N)
+            {
+                return false;
+            }
+
+            m_items[m_count++] = item;
+            return true;
+        }
+
+        void clear() { m_count = 0; }
+        // Only shrinks, keeps the first count items
+        void resize(size_t count) { m_count = count < m_count ? uint32_t(count) : m_count; }
+
+        size_t size() const { return m_count; }
+        bool empty() const { return m_count == 0; }
+
+        T &operator[](size_t index) { return m_items[index]; }
+        const T &operator[](size_t index) const { return m_items[index]; }
+
+        T *data() { return m_items.data(); }
+        const T *data() const { return m_items.data(); }
+
+        T *begin() { return m_items.data(); }
+        T *end() { return m_items.data() + m_count; }
+        const T *begin() const { return m_items.data(); }
+        const T *end() const { return m_items.data() + m_count; }
+    };
+
+    // Lock-free single producer, single consumer queue of preallocated slots. The producer fills a slot
+    // in place and publishes it with a release store, the consumer sees it only after an acquire load.
+    template <typename T, uint32_t N>
+    class SpscRing
+    {
+        static_assert((N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+    private:
+        std::array<T, N> m_slots = {};
+
+        // Kept on separate cache lines so the two threads do not contend
+        alignas(64) std::atomic<uint32_t> m_write = 0;
+        alignas(64) std::atomic<uint32_t> m_read = 0;
+        std::atomic<uint32_t> m_dropped = 0;
+
+    public:
+        // Producer only. Returns nullptr if the consumer is a full ring behind, the item is then dropped.
+        T *BeginWrite()
+        {
+            const uint32_t write = m_write.load(std::memory_order_relaxed);
+            if (write - m_read.load(std::memory_order_acquire) == N)
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            return &m_slots[write & (N - 1)];
+        }
+
+        // Producer only. Publishes the slot returned by BeginWrite.
+        void EndWrite()
+        {
+            m_write.store(m_write.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Consumer only. The slot stays valid until Pop.
+        const T *Peek() const
+        {
+            const uint32_t read = m_read.load(std::memory_order_relaxed);
+            if (read == m_write.load(std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+
+            return &m_slots[read & (N - 1)];
+        }
+
+        // Consumer only. Hands the slot back to the producer.
+        void Pop()
+        {
+            m_read.store(m_read.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        uint32_t GetDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    };
+
+    // Fixed capacity history that overwrites its oldest entry, index 0 is the oldest.
+    // Not thread safe, it is owned by the consumer.
+    template <typename T, uint32_t N>
+    class HistoryRing
+    {
+    private:
+        std::array<T, N> m_items = {};
+        uint32_t m_first = 0;
+        uint32_t m_count = 0;
+
+    public:
+        // Returns the slot for a new newest entry, its previous contents are stale
+        T &Push()
+        {
+            if (m_count == N)
+            {
+                m_first = (m_first + 1) % N;
+            }
+            else
+            {
+                m_count++;
+            }
+
+            return m_items[(m_first + m_count - 1) % N];
+        }
+
+        // Removes the count oldest entries
+        void PopFront(size_t count)
+        {
+            count = count < m_count ? count : m_count;
+            m_first = uint32_t((m_first + count) % N);
+            m_count -= uint32_t(count);
+        }
+
+        size_t size() const { return m_count; }
+        bool empty() const { return m_count == 0; }
+
+        T &operator[](size_t index) { return m_items[(m_first + index) % N]; }
+        const T &operator[](size_t index) const { return m_items[(m_first + index) % N]; }
+
+        T &front() { return (*this)[0]; }
+        T &back() { return (*this)[m_count - 1]; }
+        const T &front() const { return (*this)[0]; }
+        const T &back() const { return (*this)[m_count - 1]; }
+    };
+}
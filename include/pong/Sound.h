@@ -4,6 +4,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace pong
 {
@@ -14,6 +15,15 @@ namespace pong
         uint32_t sourceId = 0;
 
     public:
+        // Samples of a .wav-file, read on any thread and handed to the audio device by Create on the main thread
+        struct Data
+        {
+            uint16_t channels = 0;
+            uint16_t bitsPerSample = 0;
+            uint32_t sampleRate = 0;
+            std::vector<char> samples;
+        };
+
         Sound() = default;
         Sound(uint32_t bufferId, uint32_t sourceId)
             : bufferId(bufferId), sourceId(sourceId) {}
@@ -25,6 +35,8 @@ namespace pong
         void Play();
         void PlayAt(const glm::vec3 &position, float volume = 1.0f, float pitch = 1.0f);
 
+        static bool Load(const std::string &path, Data &data);
+        static std::unique_ptr<Sound> Create(const Data &data);
         static std::unique_ptr<Sound> Create(const std::string &path);
     };
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "pong/Renderer.h"
+#include "pong/Texture.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pong
+{
+    // Font constants
+    const float letterWidth = 148.0f;
+    const float letterWorldWidth = letterWidth * 0.1f;
+    const float letterSpacing = -4.0f;
+
+    // Retained text blocks, glyphs are only laid out again when a block's text or placement changes.
+    // Create and Destroy may be called from several jobs at once. Set and SetVisible only touch their own
+    // block, so different blocks can be set in parallel, but not while blocks are being created.
+    class TextCache
+    {
+    public:
+        using Handle = uint32_t;
+        static constexpr Handle c_invalidHandle = UINT32_MAX;
+
+    private:
+        struct Glyph
+        {
+            glm::vec4 offsetAndSize = glm::vec4(0.0f);
+            float advance = 0.0f;
+            bool visible = false;
+        };
+
+        struct TextBlock
+        {
+            std::string text;
+            glm::vec3 position = glm::vec3(0.0f);
+            glm::vec2 scale = glm::vec2(1.0f);
+            glm::vec4 tint = glm::vec4(1.0f);
+            std::vector<SpriteBatch::Instance> glyphs;
+            bool visible = true;
+            bool alive = false;
+        };
+
+        Texture *m_font = nullptr;
+        std::array<Glyph, 256> m_glyphs = {};
+        std::vector<TextBlock> m_blocks;
+        std::vector<Handle> m_freeHandles;
+        std::mutex m_mutex; // Guards the block list and free handles
+
+        void Layout(TextBlock &block) const;
+
+    public:
+        TextCache() = default;
+        ~TextCache() = default;
+
+        void Initialize(Texture *font);
+
+        Handle Create(std::string_view text = {}, const glm::vec3 &position = glm::vec3(0.0f), const glm::vec2 &scale = glm::vec2(1.0f), const glm::vec4 &tint = glm::vec4(1.0f));
+        void Destroy(Handle handle);
+
+        void Set(Handle handle, std::string_view text, const glm::vec3 &position, const glm::vec2 &scale, const glm::vec4 &tint = glm::vec4(1.0f));
+        void SetVisible(Handle handle, bool visible);
+
+        void Submit(Renderer &renderer) const;
+    };
+}
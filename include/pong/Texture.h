@@ -4,6 +4,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace pong
 {
@@ -21,6 +22,15 @@ namespace pong
         wgpu::Sampler m_sampler = {};
 
     public:
+        // Contents of a texture file, read on any thread and uploaded by Create on the main thread
+        struct Data
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t numChannels = 0;
+            std::vector<uint8_t> pixels;
+        };
+
         Texture() = default;
         Texture(uint32_t id, uint32_t width, uint32_t height, wgpu::Texture texture, wgpu::TextureView textureView, wgpu::Sampler sampler)
             : m_id(id), m_width(width), m_height(height), m_texture(texture), m_textureView(textureView), m_sampler(sampler) {}
@@ -35,6 +45,8 @@ namespace pong
 
         Texture(const Texture &) = delete;
         Texture &operator=(const Texture &) = delete;
+        static bool Load(const std::string &path, Data &data);
+        static std::unique_ptr<Texture> Create(const wgpu::Device &device, const wgpu::Queue &queue, const Data &data);
         static std::unique_ptr<Texture> Create(const wgpu::Device &device, const wgpu::Queue &queue, const std::string &path);
     };
 
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace pong
+{
+    // Struct of arrays input of BuildTransforms. The scale arrays are optional, null means a scale of one.
+    struct TransformArrays
+    {
+        const float *positionX = nullptr;
+        const float *positionY = nullptr;
+        const float *positionZ = nullptr;
+        const float *rotationX = nullptr;
+        const float *rotationY = nullptr;
+        const float *rotationZ = nullptr;
+        const float *rotationW = nullptr;
+        const float *scaleX = nullptr;
+        const float *scaleY = nullptr;
+        const float *scaleZ = nullptr;
+    };
+
+    // Inline storage for a fixed number of transforms
+    template <size_t N>
+    struct TransformArrayStorage
+    {
+        std::array<float, N> positionX, positionY, positionZ;
+        std::array<float, N> rotationX, rotationY, rotationZ, rotationW;
+
+        TransformArrays View() const
+        {
+            return {positionX.data(), positionY.data(), positionZ.data(), rotationX.data(), rotationY.data(), rotationZ.data(), rotationW.data()};
+        }
+    };
+
+    enum class TransformKernel : uint8_t
+    {
+        Scalar = 0,
+        Sse = 1,
+        Avx2 = 2,
+        WasmSimd = 3,
+    };
+
+    // Writes translate(position) * mat4_cast(rotation) * scale(scale) for count transforms, rotations must
+    // be unit quaternions. Uses the widest SIMD path available, AVX2 is picked at runtime on x86-64.
+    void BuildTransforms(const TransformArrays &arrays, size_t count, glm::mat4 *out);
+    // Reference implementation, the SIMD paths match it to rounding
+    void BuildTransformsScalar(const TransformArrays &arrays, size_t count, glm::mat4 *out);
+
+    // Runs one particular path, for tests and benchmarks. Returns false without writing anything if this
+    // build or CPU does not have it.
+    bool BuildTransforms(const TransformArrays &arrays, size_t count, glm::mat4 *out, TransformKernel kernel);
+    bool IsTransformKernelAvailable(TransformKernel kernel);
+
+    // Widest available path
+    TransformKernel GetTransformKernel();
+    const char *ToString(TransformKernel kernel);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "pong/Messages.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pong
+{
+    // Message based connection to a game server. Received messages are delivered through the receive
+    // callback, either from Poll or, in the browser, from the socket's own event callbacks.
+    class ITransport
+    {
+    public:
+        using ReceiveCallback = void (*)(const uint8_t *data, size_t size, void *userData);
+
+        virtual ~ITransport() = default;
+
+        virtual bool Connect(const std::string &url, ReceiveCallback onReceive, void *userData) = 0;
+        virtual void Close() = 0;
+
+        virtual bool Send(const uint8_t *data, size_t size) = 0;
+        virtual void Poll() = 0;
+
+        virtual bool IsOpen() const = 0;
+
+        // Clock used to timestamp messages, replays run on the captured clock instead of the wall clock
+        virtual double GetTime() const { return GetReceiveClock(); }
+    };
+
+    // Picks a backend from the url scheme: loopback:// runs the in-process server, replay:// plays back
+    // a capture file, ws:// uses the browser WebSocket under Emscripten and a native socket otherwise.
+    std::unique_ptr<ITransport> CreateTransport(const std::string &url);
+
+    // Returns the numeric value of key in the url query, or fallback
+    float GetUrlParameter(const std::string &url, const std::string &key, float fallback);
+    // Every key and value of the url query, in order
+    std::vector<std::pair<std::string, std::string>> GetUrlParameters(const std::string &url);
+}
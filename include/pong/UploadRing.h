@@ -0,0 +1,101 @@
+#pragma once
+
+#include <webgpu/webgpu_cpp.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace pong
+{
+    // Sub-allocates per-frame GPU data from one large buffer. Allocations are staged on the CPU and
+    // flushed with a single WriteBuffer, frames in flight are kept apart using submitted work fences.
+    class UploadRing
+    {
+    public:
+        // Offset is relative to the start of the frame until the frame has been flushed
+        struct Allocation
+        {
+            uint32_t offset = 0;
+            uint32_t size = 0;
+        };
+
+        struct Stats
+        {
+            uint64_t usedBytes = 0;
+            uint64_t peakBytes = 0;
+            uint64_t capacity = 0;
+            uint32_t allocations = 0;
+            uint32_t framesInFlight = 0;
+            uint32_t grows = 0;
+            uint32_t stalls = 0;
+        };
+
+    private:
+        static const uint32_t c_maxFramesInFlight = 3;
+
+        struct InFlightFrame
+        {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t generation = 0;
+            uint64_t serial = 0; // Submission that last used the slot, its work done callback must match
+            bool pending = false;
+        };
+
+        // Handed to the work done callback, which may arrive after the slot was reused by a newer frame
+        struct Submission
+        {
+            UploadRing *ring = nullptr;
+            uint64_t serial = 0;
+        };
+
+        wgpu::Device m_device = {};
+        wgpu::Queue m_queue = {};
+        wgpu::Buffer m_buffer = {};
+        wgpu::BufferUsage m_usage = wgpu::BufferUsage::None;
+
+        uint64_t m_capacity = 0;
+        uint32_t m_bindingWindow = 0;
+        uint32_t m_generation = 0;
+
+        uint64_t m_head = 0;
+        uint64_t m_frameBase = 0;
+        uint64_t m_serial = 0; // Next submission, it uses slot m_serial % c_maxFramesInFlight
+        uint32_t m_largestAllocation = 0;
+        std::vector<uint8_t> m_staging;
+        std::array<InFlightFrame, c_maxFramesInFlight> m_frames = {};
+
+        Stats m_stats;
+
+        bool CreateBuffer(uint64_t capacity, uint32_t bindingWindow);
+        bool Overlaps(uint64_t offset, uint64_t size) const;
+
+    public:
+        UploadRing() = default;
+        ~UploadRing() = default;
+
+        UploadRing(const UploadRing &) = delete;
+        UploadRing &operator=(const UploadRing &) = delete;
+
+        bool Initialize(const wgpu::Device &device, const wgpu::Queue &queue, uint64_t capacity, uint32_t bindingWindow, wgpu::BufferUsage usage);
+
+        void BeginFrame();
+        Allocation Allocate(uint32_t size, uint32_t alignment);
+        Allocation Upload(const void *data, uint32_t size, uint32_t alignment);
+        // Pointer into the staging memory, only valid until the next call to Allocate
+        void *GetData(const Allocation &allocation) { return m_staging.data() + allocation.offset; }
+        bool Flush();
+        void EndFrame();
+
+        // Absolute offset of an allocation in the buffer, only valid after Flush
+        uint32_t GetOffset(const Allocation &allocation) const { return uint32_t(m_frameBase + allocation.offset); }
+
+        const wgpu::Buffer &GetBuffer() const { return m_buffer; }
+        // Bytes that can be bound starting from any offset in the ring
+        uint32_t GetBindingWindow() const { return m_bindingWindow; }
+        // Changes every time the buffer is recreated, bind groups referencing it must be rebuilt
+        uint32_t GetGeneration() const { return m_generation; }
+        const Stats &GetStats() const { return m_stats; }
+    };
+}
@@ -0,0 +1,325 @@
+#pragma once
+
+#include "pong/Messages.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace pong
+{
+    // Version 1 game state layout, all fields little-endian and unaligned:
+    //   Head      u32 playerId, u32 sequenceNumber
+    //   Player[n] u32 playerId, i32 score, f32 x, f32 y
+    //   Ball      f32 x, f32 y, f32 vx, f32 vy
+    //   Events    u8 hasHit, u8 playerWasHit, u8 hasSmashed, u8 newRound
+    //   GameState u8
+    // The version has no tag on the wire, it is identified by the frame length.
+    //
+    // Version 2 is requested with proto=2 in the connect URL. Frames start with the magic "P2":
+    //   u8[2]  magic
+    //   u8     flags, bit 0 delta, bit 1 playerId present, bit 2 inputSequence present
+    //   u16    snapshotId
+    //   u16    baselineId, delta frames only
+    //   u32    playerId, u32 inputSequence, when present
+    //   u8     state in bits 0-3, events in bits 4-7 (hasHit, playerWasHit, hasSmashed, newRound)
+    //   u8     ball mask, bit 0 position, bit 1 velocity
+    //   u16 x, u16 y    ball position, when present
+    //   i16 vx, i16 vy  ball velocity, when present
+    //   u8     player count, then per player:
+    //     u32 playerId, u8 mask (bit 0 score, bit 1 position), i16 score, u16 x, u16 y, when present
+    // Positions are unsigned fixed point over the arena plus a margin on every side, velocities are
+    // signed fixed point with c_velocityScale steps per unit. Full frames have every field present,
+    // delta frames copy missing fields from the baseline, which is the snapshot the client last acked.
+    // The client acks every snapshot it decodes with "PA" u16 snapshotId, acking c_noBaseline asks
+    // the server for a full frame after a delta could not be decoded. The magic alone does not tell
+    // the versions apart, a v1 frame can start with the same bytes, so the client keeps the version
+    // of the first frame that decodes. That first frame is a full one, 24 + 11n bytes, which is never
+    // the length of a v1 frame. tests/fixtures holds byte exact v2 frames for servers to test against.
+    //
+    // Inputs are sent at a fixed tick rate, each packet repeating the inputs the server has not acked yet:
+    //   u8[2]  magic "PI"
+    //   u8     input count n, at most c_inputRedundancy
+    //   u32    sequenceNumber of the newest input
+    //   u64    timestamp of the newest input in milliseconds
+    //   u8[n]  buttons newest first, bit 0 up, bit 1 down. Input i has sequence number newest - i.
+    // v1 servers instead get the newest input as the raw 16 byte InputMessage.
+    //
+    // v2 clients also ping the server once a second to measure the round trip and clock offset:
+    //   Ping  "PP" u32 pingId, u64 clientTime
+    //   Pong  "PO" u32 pingId, u64 clientTime, u64 serverReceiveTime, u64 serverSendTime
+    // Times are microseconds on the sender's monotonic clock, the pong echoes clientTime unchanged.
+    namespace wire
+    {
+        static constexpr size_t c_headSize = 8;
+        static constexpr size_t c_playerSize = 16;
+        static constexpr size_t c_ballSize = 16;
+        static constexpr size_t c_eventsSize = 4;
+        static constexpr size_t c_stateSize = 1;
+        static constexpr size_t c_fixedSize = c_headSize + c_ballSize + c_eventsSize + c_stateSize;
+        static constexpr size_t c_maxFrameSize = c_fixedSize + c_maxPlayers * c_playerSize;
+
+        static constexpr uint32_t c_protocolVersion = 2;
+        static constexpr uint8_t c_magic[2] = {'P', '2'};
+        static constexpr uint8_t c_ackMagic[2] = {'P', 'A'};
+        static constexpr size_t c_ackSize = 4;
+        static constexpr uint16_t c_noBaseline = 0xFFFF;
+        static constexpr uint8_t c_inputMagic[2] = {'P', 'I'};
+        static constexpr uint32_t c_inputRedundancy = 4;
+        static constexpr size_t c_maxInputPacketSize = 15 + c_inputRedundancy;
+        static constexpr uint8_t c_pingMagic[2] = {'P', 'P'};
+        static constexpr uint8_t c_pongMagic[2] = {'P', 'O'};
+        static constexpr size_t c_pingSize = 14;
+        static constexpr size_t c_pongSize = 30;
+
+        static constexpr uint8_t c_flagDelta = 1 << 0;
+        static constexpr uint8_t c_flagPlayerId = 1 << 1;
+        static constexpr uint8_t c_flagInputSequence = 1 << 2;
+        static constexpr uint8_t c_fieldPosition = 1 << 0;
+        static constexpr uint8_t c_fieldVelocity = 1 << 1;
+        static constexpr uint8_t c_fieldScore = 1 << 0;
+
+        // Server arena in server units, must match the server
+        static constexpr float c_arenaWidth = 800.0f;
+        static constexpr float c_arenaHeight = 600.0f;
+        static constexpr float c_arenaMargin = 0.5f; // Fraction of the arena size on every side
+        static constexpr float c_velocityScale = 16.0f;
+
+        static constexpr size_t c_maxFrameSizeV2 = 26 + c_maxPlayers * 11;
+    }
+
+    struct QuantizedPlayer
+    {
+        uint32_t playerId = 0;
+        int16_t score = 0;
+        uint16_t position[2] = {};
+    };
+
+    // Snapshot in wire precision, the unit of delta compression
+    struct QuantizedSnapshot
+    {
+        uint16_t snapshotId = 0;
+        uint32_t playerId = 0;
+        uint32_t inputSequence = 0;
+        uint8_t state = 0;
+        uint8_t events = 0;
+        uint16_t ballPosition[2] = {};
+        int16_t ballVelocity[2] = {};
+        FixedVector<QuantizedPlayer, c_maxPlayers> players;
+    };
+
+    // Recently decoded snapshots by id, used to resolve the baseline of delta frames
+    class SnapshotBaselines
+    {
+    private:
+        static constexpr uint32_t c_size = 32;
+
+        std::array<QuantizedSnapshot, c_size> m_snapshots = {};
+        std::array<bool, c_size> m_valid = {};
+
+    public:
+        void Store(const QuantizedSnapshot &snapshot);
+        const QuantizedSnapshot *Find(uint16_t snapshotId) const;
+        void Clear() { m_valid = {}; }
+    };
+
+    // Server side view of an input packet
+    struct InputPacket
+    {
+        uint32_t newestSequence = 0;
+        uint64_t timestamp = 0;
+        FixedVector<InputState, wire::c_inputRedundancy> inputs; // Newest first
+    };
+
+    struct PingExchange
+    {
+        uint32_t pingId = 0;
+        uint64_t clientTime = 0;
+        uint64_t serverReceiveTime = 0;
+        uint64_t serverSendTime = 0;
+    };
+
+    enum class DecodeResult : uint8_t
+    {
+        Ok = 0,
+        TooShort,
+        TooLong,
+        BadLength,
+        BadEvent,
+        BadState,
+        BadMagic,
+        MissingBaseline,
+        BadDelta,
+    };
+
+    const char *ToString(DecodeResult result);
+
+    // Bounds-checked little-endian reads over a received buffer. A failed read leaves the reader
+    // in an error state and returns zero, so a decoder can check once at the end.
+    class WireReader
+    {
+    private:
+        const uint8_t *m_data = nullptr;
+        size_t m_size = 0;
+        size_t m_offset = 0;
+        bool m_ok = true;
+
+        bool Reserve(size_t size)
+        {
+            if (!m_ok || m_size - m_offset < size)
+            {
+                m_ok = false;
+                return false;
+            }
+            return true;
+        }
+
+    public:
+        WireReader(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+
+        uint8_t ReadU8()
+        {
+            if (!Reserve(1))
+            {
+                return 0;
+            }
+            return m_data[m_offset++];
+        }
+
+        uint32_t ReadU32()
+        {
+            if (!Reserve(4))
+            {
+                return 0;
+            }
+
+            const uint8_t *p = m_data + m_offset;
+            m_offset += 4;
+            return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+        }
+
+        uint16_t ReadU16()
+        {
+            if (!Reserve(2))
+            {
+                return 0;
+            }
+
+            const uint8_t *p = m_data + m_offset;
+            m_offset += 2;
+            return uint16_t(p[0] | p[1] << 8);
+        }
+
+        uint64_t ReadU64()
+        {
+            const uint64_t low = ReadU32();
+            return low | uint64_t(ReadU32()) << 32;
+        }
+
+        int16_t ReadI16() { return int16_t(ReadU16()); }
+        int32_t ReadI32() { return int32_t(ReadU32()); }
+        float ReadF32() { return std::bit_cast<float>(ReadU32()); }
+
+        bool IsOk() const { return m_ok; }
+        size_t GetOffset() const { return m_offset; }
+        size_t GetRemaining() const { return m_size - m_offset; }
+    };
+
+    // Bounds-checked little-endian writes into a caller provided buffer
+    class WireWriter
+    {
+    private:
+        uint8_t *m_data = nullptr;
+        size_t m_capacity = 0;
+        size_t m_offset = 0;
+        bool m_ok = true;
+
+        bool Reserve(size_t size)
+        {
+            if (!m_ok || m_capacity - m_offset < size)
+            {
+                m_ok = false;
+                return false;
+            }
+            return true;
+        }
+
+    public:
+        WireWriter(uint8_t *data, size_t capacity) : m_data(data), m_capacity(capacity) {}
+
+        void WriteU8(uint8_t value)
+        {
+            if (Reserve(1))
+            {
+                m_data[m_offset++] = value;
+            }
+        }
+
+        void WriteU16(uint16_t value)
+        {
+            if (Reserve(2))
+            {
+                m_data[m_offset++] = uint8_t(value);
+                m_data[m_offset++] = uint8_t(value >> 8);
+            }
+        }
+
+        void WriteU32(uint32_t value)
+        {
+            if (Reserve(4))
+            {
+                for (uint32_t i = 0; i < 4; i++)
+                {
+                    m_data[m_offset++] = uint8_t(value >> (8 * i));
+                }
+            }
+        }
+
+        void WriteU64(uint64_t value)
+        {
+            WriteU32(uint32_t(value));
+            WriteU32(uint32_t(value >> 32));
+        }
+
+        void WriteI16(int16_t value) { WriteU16(uint16_t(value)); }
+
+        bool IsOk() const { return m_ok; }
+        size_t GetSize() const { return m_offset; }
+    };
+
+    // Decodes straight into a preallocated message, does not allocate. On failure the message is left
+    // partially written and must not be published.
+    DecodeResult DecodeGameState(const uint8_t *data, size_t size, GameStateMessage &msg);
+
+    // Reference encoder for version 1, used by the loopback server
+    size_t EncodeGameState(const GameStateMessage &msg, uint8_t *data, size_t capacity);
+
+    // Only checks the magic, see the version notes above
+    bool IsGameStateV2(const uint8_t *data, size_t size);
+    DecodeResult DecodeGameStateV2(const uint8_t *data, size_t size, const SnapshotBaselines &baselines, QuantizedSnapshot &snapshot);
+
+    // Reference encoder for the server, writes a full frame when baseline is null. Returns the frame size, or 0 if it did not fit.
+    size_t EncodeGameStateV2(const QuantizedSnapshot &snapshot, const QuantizedSnapshot *baseline, uint8_t *data, size_t capacity);
+    size_t EncodeSnapshotAck(uint16_t snapshotId, uint8_t *data, size_t capacity);
+    // Inputs are oldest first with consecutive sequence numbers, only the newest c_inputRedundancy are written
+    size_t EncodeInputPacket(const InputMessage *inputs, size_t count, uint8_t *data, size_t capacity);
+
+    // Server side decoders for what the client sends
+    DecodeResult DecodeSnapshotAck(const uint8_t *data, size_t size, uint16_t &snapshotId);
+    DecodeResult DecodeInputPacket(const uint8_t *data, size_t size, InputPacket &packet);
+    DecodeResult DecodeInputMessage(const uint8_t *data, size_t size, InputMessage &input);
+
+    size_t EncodePing(uint32_t pingId, uint64_t clientTime, uint8_t *data, size_t capacity);
+    DecodeResult DecodePing(const uint8_t *data, size_t size, PingExchange &exchange);
+    size_t EncodePong(const PingExchange &exchange, uint8_t *data, size_t capacity);
+    bool IsPong(const uint8_t *data, size_t size);
+    DecodeResult DecodePong(const uint8_t *data, size_t size, PingExchange &exchange);
+
+    // Snapshots from older to newer, ids count modulo c_noBaseline. Negative when newer was sent before
+    // older, which the shorter way around the wrap decides.
+    int32_t SnapshotIdDifference(uint16_t newer, uint16_t older);
+
+    QuantizedSnapshot QuantizeSnapshot(const GameStateMessage &msg, uint16_t snapshotId);
+    void DequantizeSnapshot(const QuantizedSnapshot &snapshot, GameStateMessage &msg);
+}
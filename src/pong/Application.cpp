@@ -9,12 +9,25 @@
 #include <webgpu/webgpu_glfw.h>
 #endif
 
+#include <cstdlib>
 #include <iostream>
 
 namespace pong
 {
     Application *Application::s_instance = nullptr;
 
+    static bool GetProfileFlag()
+    {
+#ifdef __EMSCRIPTEN__
+        return EM_ASM_INT(
+                   const url = new URL(window.location.href);
+                   return url.searchParams.get("profile") === "true" ? 1 : 0;) == 1;
+#else
+        const char *value = std::getenv("PONG_PROFILE");
+        return value != nullptr && std::atoi(value) != 0;
+#endif
+    }
+
     void Application::Run(const DeviceContext &context)
     {
         int width = 0;
@@ -53,36 +66,75 @@ namespace pong
                 return EM_TRUE;
             });
 
+        m_lastFrameTime = std::chrono::steady_clock::now();
+
+        // Frame rate 0 lets the browser drive the loop with requestAnimationFrame at the display rate
         emscripten_set_main_loop_arg(
             [](void *arg)
             {
                 auto *app = reinterpret_cast<Application *>(arg);
-                app->Update(float(1.0f / c_fps));
+                auto now = std::chrono::steady_clock::now();
+                float frameTime = std::chrono::duration<float>(now - app->m_lastFrameTime).count();
+                app->m_lastFrameTime = now;
+
+                app->Update(frameTime);
                 app->Render();
+                app->UpdateProfiler(frameTime);
             },
-            this, c_fps, true);
+            this, 0, true);
     }
 
     void Application::Initialize()
     {
+        const uint32_t workerCount = JobSystem::GetDefaultWorkerCount();
+        m_profiler.Initialize(workerCount + 1);
+        m_jobSystem.Initialize(workerCount, &m_profiler);
+        m_profiling = GetProfileFlag();
+        std::cout << "Job system running on " << m_jobSystem.GetThreadCount() << " threads" << std::endl;
+
         m_game.Initialize(m_renderer);
     }
 
-    void Application::Update(float deltaTime)
+    void Application::Update(float frameTime)
     {
-        m_game.Update(deltaTime);
+        // Clamp so a long stall does not make the simulation spiral trying to catch up
+        m_accumulator += glm::min(frameTime, c_maxFrameTime);
+        while (m_accumulator >= c_fixedDeltaTime)
+        {
+            m_game.Update(c_fixedDeltaTime);
+            m_accumulator -= c_fixedDeltaTime;
+        }
     }
 
     void Application::Render()
     {
-        m_game.Render(m_renderer);
+        m_game.Render(m_renderer, m_accumulator / c_fixedDeltaTime);
         m_renderer.Render();
     }
 
+    void Application::UpdateProfiler(float frameTime)
+    {
+        // Every job of the frame has been waited for, so the threads are done recording
+        m_profiler.EndFrame();
+        m_profileTime += frameTime;
+        if (m_profileTime < 1.0f)
+        {
+            return;
+        }
+
+        if (m_profiling)
+        {
+            m_profiler.Print(std::cout);
+        }
+        m_profiler.Reset();
+        m_profileTime = 0.0f;
+    }
+
     void Application::Terminate()
     {
         m_audioPlayer.Terminate();
         m_renderer.Terminate();
+        m_jobSystem.Terminate();
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "pong/BallExtrapolator.h"
+
+#include <glm/glm.hpp>
+
+namespace pong
+{
+    void BallExtrapolator::Initialize(const Config &config)
+    {
+        m_config = config;
+        m_correction = {};
+        m_initialized = false;
+        m_stalled = false;
+        m_stallTime = 0.0f;
+        m_stats = {};
+    }
+
+    Ball BallExtrapolator::Advance(const Ball &ball, float time) const
+    {
+        Ball result = ball;
+        result.position.x = glm::clamp(ball.position.x + ball.velocity.x * time, 0.0f, m_config.arenaWidth);
+
+        // Unfold the bounces, the ball travels a span of length 2 * range before it is back where it started
+        const float range = m_config.arenaHeight - 2.0f * m_config.ballRadius;
+        if (range <= 0.0f)
+        {
+            return result;
+        }
+
+        const float period = 2.0f * range;
+        const float unfolded = ball.position.y - m_config.ballRadius + ball.velocity.y * time;
+        const float offset = unfolded - period * glm::floor(unfolded / period);
+        const bool reflected = offset > range;
+        result.position.y = m_config.ballRadius + (reflected ? period - offset : offset);
+        result.velocity.y = reflected ? -ball.velocity.y : ball.velocity.y;
+        return result;
+    }
+
+    const Ball &BallExtrapolator::Update(const Ball &authoritative, bool stalled, float deltaTime)
+    {
+        if (!m_initialized)
+        {
+            m_ball = authoritative;
+            m_correction = {};
+            m_initialized = true;
+            m_stalled = false;
+            return m_ball;
+        }
+
+        if (stalled)
+        {
+            // Start from what was shown last frame so the ball does not jump
+            if (!m_stalled)
+            {
+                m_stallStart = m_ball;
+                m_stallTime = 0.0f;
+                m_stats.stalls++;
+            }
+            m_stalled = true;
+            m_stallTime = glm::min(m_stallTime + deltaTime, m_config.horizon);
+            m_stats.extrapolationTime = m_stallTime;
+
+            m_ball = Advance(m_stallStart, m_stallTime);
+            m_correction = {};
+            m_stats.remainingCorrection = 0.0f;
+            return m_ball;
+        }
+
+        if (m_stalled)
+        {
+            // Data is back, keep showing the extrapolated ball and blend the error out. A large error
+            // means the ball was reset or hit a paddle meanwhile, that is snapped.
+            const glm::vec2 error = m_ball.position - authoritative.position;
+            const float distance = glm::length(error);
+            m_stats.correction = distance;
+            m_stats.maxCorrection = glm::max(m_stats.maxCorrection, distance);
+            if (distance > m_config.snapDistance)
+            {
+                m_correction = {};
+                m_stats.snaps++;
+            }
+            else
+            {
+                m_correction = error;
+            }
+            m_stalled = false;
+        }
+        else
+        {
+            m_correction *= glm::exp(-m_config.blendRate * deltaTime);
+        }
+
+        m_ball = authoritative;
+        m_ball.position += m_correction;
+        m_stats.remainingCorrection = glm::length(m_correction);
+        return m_ball;
+    }
+}
@@ -0,0 +1,133 @@
+#include "pong/BotBatch.h"
+
+#include <glm/glm.hpp>
+
+namespace pong
+{
+    static uint32_t NextRandom(uint32_t &state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Uniform in [-1, 1)
+    static float NextSigned(uint32_t &state)
+    {
+        return float(NextRandom(state) >> 8) * (2.0f / 16777216.0f) - 1.0f;
+    }
+
+    void BotBatch::Initialize(const Config &config)
+    {
+        m_config = config;
+
+        BallExtrapolator::Config flight;
+        flight.arenaWidth = config.arenaWidth;
+        flight.arenaHeight = config.arenaHeight;
+        flight.ballRadius = config.ballRadius;
+        m_flight.Initialize(flight);
+
+        Clear();
+    }
+
+    uint32_t BotBatch::Add(const BotDifficulty &difficulty, uint32_t seed)
+    {
+        // Xorshift never leaves zero
+        const uint32_t state = seed * 2654435761u ^ 0x9e3779b9u;
+
+        m_difficulty.push_back(difficulty);
+        m_lookTimer.push_back(0.0f);
+        m_target.push_back((m_config.arenaHeight - m_config.paddleHeight) / 2.0f);
+        m_random.push_back(state != 0 ? state : 1);
+        m_sequence.push_back(0);
+        return uint32_t(m_difficulty.size() - 1);
+    }
+
+    void BotBatch::Clear()
+    {
+        m_difficulty.clear();
+        m_lookTimer.clear();
+        m_target.clear();
+        m_random.clear();
+        m_sequence.clear();
+    }
+
+    float BotBatch::PredictIntercept(const BotObservation &observation) const
+    {
+        const Ball &ball = observation.ball;
+        const bool left = observation.paddle.x < m_config.arenaWidth / 2.0f;
+        const float faceX = left ? observation.paddle.x + m_config.paddleWidth + m_config.ballRadius : observation.paddle.x - m_config.ballRadius;
+
+        // Moving away, wait in the middle
+        const float time = ball.velocity.x != 0.0f ? (faceX - ball.position.x) / ball.velocity.x : -1.0f;
+        if (time < 0.0f)
+        {
+            return m_config.arenaHeight / 2.0f;
+        }
+
+        return m_flight.Advance(ball, time).position.y;
+    }
+
+    void BotBatch::Decide(uint32_t bot)
+    {
+        const BotObservation &observation = m_observations[bot];
+        const BotDifficulty &difficulty = m_difficulty[bot];
+        InputMessage &decision = m_decisions[bot];
+
+        decision = {};
+        decision.sequenceNumber = ++m_sequence[bot];
+        decision.timestamp = m_timestamp;
+        if (!observation.valid)
+        {
+            return;
+        }
+
+        m_lookTimer[bot] -= m_deltaTime;
+        if (m_lookTimer[bot] <= 0.0f)
+        {
+            m_lookTimer[bot] = glm::max(m_lookTimer[bot] + difficulty.reactionTime, 0.0f);
+
+            const float error = NextSigned(m_random[bot]) * difficulty.aimError;
+            const float maxY = m_config.arenaHeight - m_config.paddleHeight;
+            m_target[bot] = glm::clamp(PredictIntercept(observation) + error - m_config.paddleHeight / 2.0f, 0.0f, maxY);
+        }
+
+        // Keys move the paddle by upDirection, pick the one that moves it towards the target
+        const float offset = m_target[bot] - observation.paddle.y;
+        const bool increase = offset > difficulty.deadZone;
+        const bool decrease = offset < -difficulty.deadZone;
+        decision.upPressed = m_config.upDirection > 0.0f ? increase : decrease;
+        decision.downPressed = m_config.upDirection > 0.0f ? decrease : increase;
+    }
+
+    void BotBatch::DecideRange(size_t begin, size_t end, void *userData)
+    {
+        BotBatch *batch = reinterpret_cast<BotBatch *>(userData);
+        for (size_t bot = begin; bot < end; bot++)
+        {
+            batch->Decide(uint32_t(bot));
+        }
+    }
+
+    void BotBatch::DecideAll(const BotObservation *observations, InputMessage *decisions, float deltaTime, uint64_t timestamp, JobSystem *jobs)
+    {
+        m_observations = observations;
+        m_decisions = decisions;
+        m_deltaTime = deltaTime;
+        m_timestamp = timestamp;
+
+        // Every bot only touches its own entries, so chunks need no synchronization
+        if (jobs != nullptr)
+        {
+            jobs->ParallelFor(size(), m_config.grain, DecideRange, this, "BotBatch::Decide");
+        }
+        else
+        {
+            DecideRange(0, size(), this);
+        }
+
+        m_observations = nullptr;
+        m_decisions = nullptr;
+    }
+}
@@ -0,0 +1,267 @@
+#include "pong/Capture.h"
+
+#include "pong/WireFormat.h"
+
+#include <iostream>
+
+namespace pong
+{
+    static void WriteHeader(uint8_t *data, uint64_t indexOffset, uint32_t indexCount, uint32_t recordCount, uint64_t startTime)
+    {
+        WireWriter writer(data, capture::c_headerSize);
+        for (uint8_t c : capture::c_magic)
+        {
+            writer.WriteU8(c);
+        }
+        writer.WriteU32(capture::c_version);
+        writer.WriteU64(indexOffset);
+        writer.WriteU32(indexCount);
+        writer.WriteU32(recordCount);
+        writer.WriteU64(startTime);
+    }
+
+    static uint64_t ToMicroseconds(double seconds)
+    {
+        // Rounded, truncating would shift times that are not exact in binary a microsecond early
+        return seconds > 0.0 ? uint64_t(seconds * 1e6 + 0.5) : 0;
+    }
+
+    bool CaptureWriter::Open(const std::string &path, double startTime)
+    {
+        Close();
+
+        m_file = std::fopen(path.c_str(), "wb");
+        if (m_file == nullptr)
+        {
+            std::cerr << "Failed to open capture file " << path << std::endl;
+            return false;
+        }
+
+        m_startTime = startTime;
+        m_recordCount = 0;
+        m_index.clear();
+
+        uint8_t header[capture::c_headerSize];
+        WriteHeader(header, 0, 0, 0, ToMicroseconds(startTime));
+        m_offset = std::fwrite(header, 1, sizeof(header), m_file);
+        if (m_offset != sizeof(header))
+        {
+            std::cerr << "Failed to write capture header to " << path << std::endl;
+            std::fclose(m_file);
+            m_file = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    void CaptureWriter::Close()
+    {
+        if (m_file == nullptr)
+        {
+            return;
+        }
+
+        // Index goes after the last record, then the header is patched to point at it
+        const uint64_t indexOffset = m_offset;
+        for (auto &&entry : m_index)
+        {
+            uint8_t data[16];
+            WireWriter writer(data, sizeof(data));
+            writer.WriteU64(entry.time);
+            writer.WriteU64(entry.offset);
+            std::fwrite(data, 1, sizeof(data), m_file);
+        }
+
+        uint8_t header[capture::c_headerSize];
+        WriteHeader(header, indexOffset, uint32_t(m_index.size()), m_recordCount, ToMicroseconds(m_startTime));
+        std::fseek(m_file, 0, SEEK_SET);
+        std::fwrite(header, 1, sizeof(header), m_file);
+
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+    bool CaptureWriter::Write(CaptureDirection direction, double time, const uint8_t *data, size_t size)
+    {
+        if (m_file == nullptr || size > capture::c_maxRecordSize)
+        {
+            return false;
+        }
+
+        const uint64_t relativeTime = ToMicroseconds(time - m_startTime);
+        if (m_recordCount % capture::c_indexInterval == 0)
+        {
+            m_index.push_back({relativeTime, m_offset});
+        }
+
+        uint8_t header[capture::c_recordHeaderSize];
+        WireWriter writer(header, sizeof(header));
+        writer.WriteU8(uint8_t(direction));
+        writer.WriteU8(0);
+        writer.WriteU16(0);
+        writer.WriteU32(uint32_t(size));
+        writer.WriteU64(relativeTime);
+
+        if (std::fwrite(header, 1, sizeof(header), m_file) != sizeof(header) || std::fwrite(data, 1, size, m_file) != size)
+        {
+            std::cerr << "Failed to write capture record, closing capture" << std::endl;
+            Close();
+            return false;
+        }
+
+        m_offset += sizeof(header) + size;
+        m_recordCount++;
+        return true;
+    }
+
+    bool CaptureReader::Open(const std::string &path)
+    {
+        Close();
+
+        m_file = std::fopen(path.c_str(), "rb");
+        if (m_file == nullptr)
+        {
+            std::cerr << "Failed to open capture file " << path << std::endl;
+            return false;
+        }
+
+        uint8_t header[capture::c_headerSize];
+        if (std::fread(header, 1, sizeof(header), m_file) != sizeof(header))
+        {
+            std::cerr << "Capture file " << path << " is too short" << std::endl;
+            Close();
+            return false;
+        }
+
+        WireReader reader(header, sizeof(header));
+        bool validMagic = true;
+        for (uint8_t c : capture::c_magic)
+        {
+            validMagic = validMagic && reader.ReadU8() == c;
+        }
+
+        const uint32_t version = reader.ReadU32();
+        const uint64_t indexOffset = reader.ReadU64();
+        const uint32_t indexCount = reader.ReadU32();
+        m_recordCount = reader.ReadU32();
+        m_startTime = reader.ReadU64() / 1e6;
+
+        if (!validMagic || version != capture::c_version)
+        {
+            std::cerr << "Unsupported capture file " << path << std::endl;
+            Close();
+            return false;
+        }
+
+        m_index.clear();
+        m_recordsEnd = indexOffset != 0 ? indexOffset : UINT64_MAX;
+        if (indexOffset != 0 && std::fseek(m_file, long(indexOffset), SEEK_SET) == 0)
+        {
+            for (uint32_t i = 0; i < indexCount; i++)
+            {
+                uint8_t data[16];
+                if (std::fread(data, 1, sizeof(data), m_file) != sizeof(data))
+                {
+                    m_index.clear();
+                    break;
+                }
+
+                WireReader entryReader(data, sizeof(data));
+                const double time = entryReader.ReadU64() / 1e6;
+                m_index.push_back({time, entryReader.ReadU64()});
+            }
+        }
+
+        std::fseek(m_file, long(capture::c_headerSize), SEEK_SET);
+        return true;
+    }
+
+    void CaptureReader::Close()
+    {
+        if (m_file != nullptr)
+        {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+        m_index.clear();
+    }
+
+    bool CaptureReader::Next(CaptureRecord &record)
+    {
+        if (m_file == nullptr)
+        {
+            return false;
+        }
+
+        // Records end where the index starts
+        const long start = std::ftell(m_file);
+        if (start < 0 || uint64_t(start) >= m_recordsEnd)
+        {
+            return false;
+        }
+
+        uint8_t header[capture::c_recordHeaderSize];
+        if (std::fread(header, 1, sizeof(header), m_file) != sizeof(header))
+        {
+            return false;
+        }
+
+        WireReader reader(header, sizeof(header));
+        const uint8_t direction = reader.ReadU8();
+        reader.ReadU8();
+        reader.ReadU16();
+        const uint32_t size = reader.ReadU32();
+        const uint64_t time = reader.ReadU64();
+        if (direction > uint8_t(CaptureDirection::Sent) || size > capture::c_maxRecordSize)
+        {
+            std::fseek(m_file, start, SEEK_SET);
+            return false;
+        }
+
+        record.direction = CaptureDirection(direction);
+        record.time = time / 1e6;
+        record.payload.resize(size);
+        if (std::fread(record.payload.data(), 1, size, m_file) != size)
+        {
+            std::fseek(m_file, start, SEEK_SET);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool CaptureReader::Seek(double time)
+    {
+        if (m_file == nullptr)
+        {
+            return false;
+        }
+
+        uint64_t offset = capture::c_headerSize;
+        for (auto &&entry : m_index)
+        {
+            if (entry.time > time)
+            {
+                break;
+            }
+            offset = entry.offset;
+        }
+        std::fseek(m_file, long(offset), SEEK_SET);
+
+        // Scan forward to the first record at or after time
+        CaptureRecord record;
+        while (true)
+        {
+            const long start = std::ftell(m_file);
+            if (!Next(record))
+            {
+                return false;
+            }
+            if (record.time >= time)
+            {
+                std::fseek(m_file, start, SEEK_SET);
+                return true;
+            }
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#include "pong/ClockEstimator.h"
+
+#include <glm/glm.hpp>
+
+namespace pong
+{
+    void ClockEstimator::AddSample(const Sample &sample)
+    {
+        m_window[m_next] = sample;
+        m_next = (m_next + 1) % c_windowSize;
+        m_count = glm::min(m_count + 1, c_windowSize);
+        m_stats.samples++;
+
+        if (m_lastRoundTrip >= 0.0f)
+        {
+            m_stats.jitter += (glm::abs(sample.roundTrip - m_lastRoundTrip) - m_stats.jitter) * c_jitterGain;
+            m_stats.smoothedRoundTrip += (sample.roundTrip - m_stats.smoothedRoundTrip) * c_smoothingGain;
+        }
+        else
+        {
+            m_stats.smoothedRoundTrip = sample.roundTrip;
+        }
+        m_lastRoundTrip = sample.roundTrip;
+
+        // Minimum over the samples that are still fresh, the newest one always counts so best is never null.
+        // The window holds a copy, compared by index since the argument is never one of its slots.
+        const uint32_t newest = (m_next + c_windowSize - 1) % c_windowSize;
+        const Sample *best = nullptr;
+        const Sample *bestOffset = nullptr;
+        for (uint32_t i = 0; i < m_count; i++)
+        {
+            const Sample &candidate = m_window[i];
+            if (i != newest && sample.time - candidate.time > c_windowTime)
+            {
+                continue;
+            }
+
+            if (best == nullptr || candidate.roundTrip < best->roundTrip)
+            {
+                best = &candidate;
+            }
+            if (candidate.hasOffset && (bestOffset == nullptr || candidate.roundTrip < bestOffset->roundTrip))
+            {
+                bestOffset = &candidate;
+            }
+        }
+
+        m_stats.roundTrip = best->roundTrip;
+        if (bestOffset != nullptr)
+        {
+            m_stats.offset = bestOffset->offset;
+            m_stats.hasOffset = true;
+        }
+    }
+
+    void ClockEstimator::AddRoundTrip(double sendTime, double receiveTime)
+    {
+        if (receiveTime < sendTime)
+        {
+            return;
+        }
+
+        Sample sample;
+        sample.time = receiveTime;
+        sample.roundTrip = float(receiveTime - sendTime);
+        AddSample(sample);
+    }
+
+    void ClockEstimator::AddExchange(double clientSend, double serverReceive, double serverSend, double clientReceive)
+    {
+        // Time spent on the server does not count towards the round trip
+        const double roundTrip = (clientReceive - clientSend) - (serverSend - serverReceive);
+        if (roundTrip < 0.0)
+        {
+            return;
+        }
+
+        Sample sample;
+        sample.time = clientReceive;
+        sample.roundTrip = float(roundTrip);
+        sample.offset = ((serverReceive - clientSend) + (serverSend - clientReceive)) / 2.0;
+        sample.hasOffset = true;
+        AddSample(sample);
+    }
+}
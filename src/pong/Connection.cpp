@@ -1,11 +1,17 @@
 #include "pong/Connection.h"
+#include "pong/WireFormat.h"
 
+#ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
+#endif
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 
 namespace pong
 {
+#ifdef __EMSCRIPTEN__
     uint32_t GetGameIdFromUrl()
     {
         return EM_ASM_INT(
@@ -22,159 +28,381 @@ namespace pong
                    return ai ? 1 : 0;) == 1;
     }
 
-    Events EventOr(const Events &lhs, const Events &rhs)
+    bool GetLoopbackFlagFromUrl()
     {
-        Events result;
-        result.hasHit = lhs.hasHit || rhs.hasHit;
-        result.playerWasHit = lhs.playerWasHit || rhs.playerWasHit;
-        result.hasSmashed = lhs.hasSmashed || rhs.hasSmashed;
-        result.newRound = lhs.newRound || rhs.newRound;
-        return result;
+        return EM_ASM_INT(
+                   const url = new URL(window.location.href);
+                   const loopback = url.searchParams.get("loopback") === "true";
+                   return loopback ? 1 : 0;) == 1;
     }
+#endif
 
-    EM_BOOL onopen(int eventType, const EmscriptenWebSocketOpenEvent *websocketEvent, void *userData)
+    std::string GetServerUrl(uint32_t gameOffset, bool spectate)
     {
-        Connection *connection = reinterpret_cast<Connection *>(userData);
-        std::cout << "onopen" << std::endl;
-        return EM_TRUE;
+        const std::string protocol = "proto=" + std::to_string(wire::c_protocolVersion);
+        const std::string watch = spectate ? "&spectate=true" : "";
+#ifdef __EMSCRIPTEN__
+        if (GetLoopbackFlagFromUrl())
+        {
+            return "loopback://?" + protocol;
+        }
+
+        uint32_t gameId = GetGameIdFromUrl() + gameOffset;
+        bool ai = GetAIFlagFromUrl();
+        return "ws://localhost:5000/play?id=" + std::to_string(gameId) + "&ai=" + (ai ? "true" : "false") + "&" + protocol + watch;
+#else
+        const char *url = std::getenv("PONG_SERVER_URL");
+        if (url != nullptr)
+        {
+            // The environment names one game, the other matches of a wall can only watch it
+            const std::string base = url;
+            return spectate ? base + (base.find('?') == std::string::npos ? "?" : "&") + watch.substr(1) : base;
+        }
+        return "ws://localhost:5000/play?id=" + std::to_string(gameOffset) + "&ai=true&" + protocol + watch;
+#endif
     }
 
-    EM_BOOL onerror(int eventType, const EmscriptenWebSocketErrorEvent *websocketEvent, void *userData)
+    // Empty when capturing is off
+    std::string GetCapturePath()
     {
-        Connection *connection = reinterpret_cast<Connection *>(userData);
-        std::cerr << "onerror" << std::endl;
-
-        return EM_TRUE;
+#ifdef __EMSCRIPTEN__
+        const bool capture = EM_ASM_INT(
+                                 const url = new URL(window.location.href);
+                                 return url.searchParams.get("capture") === "true" ? 1 : 0;) == 1;
+        return capture ? "/capture.pongcap" : "";
+#else
+        const char *path = std::getenv("PONG_CAPTURE");
+        return path != nullptr ? path : "";
+#endif
     }
 
-    EM_BOOL onclose(int eventType, const EmscriptenWebSocketCloseEvent *websocketEvent, void *userData)
+    // Browser builds take the profile from the page query, ?net=mobile&net.down.loss=0.1, native builds
+    // from the file named by PONG_NETWORK_CONFIG
+    bool GetNetworkConditions(NetworkConditions &conditions)
     {
-        Connection *connection = reinterpret_cast<Connection *>(userData);
-        std::cout << "onclose: " << websocketEvent->wasClean << std::endl;
-        return EM_TRUE;
+#ifdef __EMSCRIPTEN__
+        char query[1024] = {};
+        EM_ASM({ stringToUTF8(window.location.search, $0, $1); }, query, sizeof(query));
+        return ParseNetworkConditionsUrl(query, conditions);
+#else
+        const char *path = std::getenv("PONG_NETWORK_CONFIG");
+        return path != nullptr && LoadNetworkConditions(path, conditions);
+#endif
     }
 
-    EM_BOOL onmessage(int eventType, const EmscriptenWebSocketMessageEvent *websocketEvent, void *userData)
+    void Connection::OnReceive(const uint8_t *data, size_t size, void *userData)
     {
         Connection *connection = reinterpret_cast<Connection *>(userData);
-        uint8_t *current = const_cast<uint8_t *>(websocketEvent->data);
-        GameStateMessage msg = connection->ParseMessage(current, websocketEvent->numBytes);
-        connection->AddMessage(msg);
-
-        return EM_TRUE;
+        connection->ReceiveMessage(data, size);
     }
 
     void Connection::Initialize()
     {
-        if (!emscripten_websocket_is_supported())
+        Initialize(GetServerUrl(0, false));
+
+        const std::string capturePath = GetCapturePath();
+        if (!capturePath.empty())
         {
-            std::cerr << "WebSockets are not supported." << std::endl;
-            exit(1);
+            StartCapture(capturePath);
         }
+    }
 
-        uint32_t gameId = GetGameIdFromUrl();
-        bool ai = GetAIFlagFromUrl();
-        std::string url = "ws://localhost:5000/play?id=" + std::to_string(gameId) + "&ai=" + (ai ? "true" : "false");
+    void Connection::Initialize(const std::string &url)
+    {
+        m_transport = CreateTransport(url);
 
-        EmscriptenWebSocketCreateAttributes wsAttrs = {url.c_str(), NULL, EM_TRUE};
+        NetworkConditions conditions;
+        if (GetNetworkConditions(conditions) && conditions.IsEnabled())
+        {
+            auto simulator = std::make_unique<SimulatedTransport>(std::move(m_transport), conditions);
+            m_simulator = simulator.get();
+            m_transport = std::move(simulator);
+            std::cout << "Simulating network profile " << conditions.profile << " with seed " << conditions.seed << std::endl;
+        }
 
-        m_socket = emscripten_websocket_new(&wsAttrs);
-        emscripten_websocket_set_onopen_callback(m_socket, this, onopen);
-        emscripten_websocket_set_onerror_callback(m_socket, this, onerror);
-        emscripten_websocket_set_onclose_callback(m_socket, this, onclose);
-        emscripten_websocket_set_onmessage_callback(m_socket, this, onmessage);
+        if (!m_transport->Connect(url, OnReceive, this))
+        {
+            std::cerr << "Failed to connect to " << url << std::endl;
+            exit(1);
+        }
     }
 
-    GameStateMessage Connection::ParseMessage(const uint8_t *message, size_t length)
+    void Connection::ReceiveMessage(const uint8_t *message, size_t length)
     {
-        const size_t numPlayers = (length - (sizeof(Head) + sizeof(Ball) + sizeof(Events) + sizeof(GameState))) / sizeof(Player);
+        if (m_capture.IsOpen())
+        {
+            m_capture.Write(CaptureDirection::Received, GetTime(), message, length);
+        }
 
-        GameStateMessage msg;
-        uint8_t *current = const_cast<uint8_t *>(message);
+        m_receivedFrames.fetch_add(1, std::memory_order_relaxed);
+        m_receivedBytes.fetch_add(length, std::memory_order_relaxed);
 
-        Head *head = reinterpret_cast<Head *>(current);
-        msg.head = *head;
-        current += sizeof(Head);
+        if (IsPong(message, length))
+        {
+            PongSample *pong = m_pongs.BeginWrite();
+            if (pong != nullptr && DecodePong(message, length, pong->exchange) == DecodeResult::Ok)
+            {
+                pong->receiveTime = GetTime();
+                m_pongs.EndWrite();
+            }
+            return;
+        }
 
-        std::vector<Player> players;
-        for (uint32_t i = 0; i < numPlayers; ++i)
+        // Parse straight into a free slot, if the game loop is a whole queue behind the message is dropped
+        GameStateMessage *slot = m_incoming.BeginWrite();
+        if (slot == nullptr)
         {
-            Player *player = reinterpret_cast<Player *>(current);
-            players.push_back(*player);
-            current += sizeof(Player);
+            return;
         }
-        msg.players = players;
 
-        Ball *ball = reinterpret_cast<Ball *>(current);
-        msg.ball = *ball;
-        current += sizeof(Ball);
+        // Servers without v2 support ignore the proto parameter and keep sending v1 frames. The first frame
+        // that decodes settles the version for the connection. Until then a frame with the v2 magic that
+        // fails as v2 is tried as v1, whose first bytes are a player id that can read "P2" by chance.
+        const uint32_t version = m_protocolVersion.load(std::memory_order_relaxed);
+        DecodeResult result = DecodeResult::BadMagic;
+        if (version != 1 && IsGameStateV2(message, length))
+        {
+            result = DecodeGameStateV2(message, length, m_baselines, m_snapshot);
+            if (result == DecodeResult::Ok)
+            {
+                // Reordered or duplicated on the way, the game already has a newer snapshot. Dropped before it
+                // moves the tick back or repeats its events, and not acked so the server keeps its baseline.
+                const int32_t elapsed = m_lastSnapshotId == wire::c_noBaseline ? 1 : SnapshotIdDifference(m_snapshot.snapshotId, m_lastSnapshotId);
+                if (elapsed <= 0)
+                {
+                    m_staleMessages.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                DequantizeSnapshot(m_snapshot, *slot);
+                m_tick += uint32_t(elapsed);
+                m_lastSnapshotId = m_snapshot.snapshotId;
+                m_baselines.Store(m_snapshot);
+                m_protocolVersion.store(2, std::memory_order_relaxed);
+                SendSnapshotAck(m_snapshot.snapshotId);
+            }
+        }
 
-        Events *events = reinterpret_cast<Events *>(current);
-        msg.events = *events;
-        current += sizeof(Events);
+        if (result != DecodeResult::Ok && version != 2)
+        {
+            const DecodeResult v1Result = DecodeGameState(message, length, *slot);
+            if (v1Result == DecodeResult::Ok || result == DecodeResult::BadMagic)
+            {
+                result = v1Result;
+            }
+            if (result == DecodeResult::Ok)
+            {
+                m_tick++;
+                m_protocolVersion.store(1, std::memory_order_relaxed);
+            }
+        }
 
-        GameState *state = reinterpret_cast<GameState *>(current);
-        msg.state = *state;
-        current += sizeof(GameState);
+        if (result == DecodeResult::MissingBaseline)
+        {
+            // Lost the baseline, ask for a full snapshot
+            SendSnapshotAck(wire::c_noBaseline);
+        }
 
-        return msg;
+        // Malformed frames are only counted, the slot is reused for the next message
+        if (result != DecodeResult::Ok)
+        {
+            m_rejectedMessages.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        slot->handeled = false;
+        slot->tick = m_tick;
+        slot->receiveTime = GetTime();
+        m_incoming.EndWrite();
     }
 
-    void Connection::AddMessage(const GameStateMessage &message)
+    Connection::ReceiveStats Connection::GetReceiveStats() const
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        ReceiveStats stats;
+        stats.frames = m_receivedFrames.load(std::memory_order_relaxed);
+        stats.bytes = m_receivedBytes.load(std::memory_order_relaxed);
+        stats.dropped = m_incoming.GetDropped();
+        stats.rejected = m_rejectedMessages.load(std::memory_order_relaxed);
+        stats.stale = m_staleMessages.load(std::memory_order_relaxed);
+        stats.protocolVersion = m_protocolVersion.load(std::memory_order_relaxed);
+        return stats;
+    }
 
-        GameStateMessage newMessage = message;
+    void Connection::PollMessages()
+    {
+        m_transport->Poll();
 
-        if (m_messages.size() > 0 && !m_messages.back().handeled)
+        while (const PongSample *pong = m_pongs.Peek())
         {
-            newMessage.events = EventOr(m_messages.back().events, message.events);
+            const PingExchange &exchange = pong->exchange;
+            m_clock.AddExchange(exchange.clientTime / 1e6, exchange.serverReceiveTime / 1e6, exchange.serverSendTime / 1e6, pong->receiveTime);
+            m_pongs.Pop();
         }
 
-        m_messages.push_back(newMessage);
-
-        if (m_messages.size() > c_maxMessages)
+        while (const GameStateMessage *message = m_incoming.Peek())
         {
-            m_messages.erase(m_messages.begin());
+            // One event per snapshot for the hit sounds, smashes and scoring take precedence like they always have
+            const Events &events = message->events;
+            const EventType hit = events.hasSmashed ? EventType::Smash : (events.playerWasHit ? EventType::PlayerHit : EventType::Hit);
+            if (events.hasSmashed || events.playerWasHit || events.hasHit)
+            {
+                m_events.Push(hit, EventSource::Server, message->tick, message->ball.position, message->receiveTime);
+            }
+            if (events.newRound)
+            {
+                m_events.Push(EventType::NewRound, EventSource::Server, message->tick, message->ball.position, message->receiveTime);
+            }
+
+            // The server echoes the newest input it has applied, which gives a round trip sample
+            const uint32_t echoed = message->head.sequenceNumber;
+            if (echoed != m_lastEchoedInput)
+            {
+                for (size_t i = 0; i < m_pendingInputs.size(); i++)
+                {
+                    if (m_pendingInputs[i].sequenceNumber == echoed)
+                    {
+                        m_clock.AddRoundTrip(m_pendingInputs[i].timestamp / 1000.0, message->receiveTime);
+                        break;
+                    }
+                }
+                m_lastEchoedInput = echoed;
+            }
+
+            m_messages.Push() = *message;
+
+            m_incoming.Pop();
         }
-
-        assert(m_messages.size() <= c_maxMessages);
     }
 
-    void Connection::SendPressedUp(bool pressed)
+    void Connection::SetPressedUp(bool pressed)
     {
         m_inputState.upPressed = pressed;
-        SendInput();
+        m_latchedState.upPressed = m_latchedState.upPressed || pressed;
     }
 
-    void Connection::SendPressedDown(bool pressed)
+    void Connection::SetPressedDown(bool pressed)
     {
         m_inputState.downPressed = pressed;
-        SendInput();
+        m_latchedState.downPressed = m_latchedState.downPressed || pressed;
+    }
+
+    void Connection::UpdateInput(float deltaTime)
+    {
+        const float tick = 1.0f / c_inputTickRate;
+        m_inputAccumulator += deltaTime;
+        if (m_inputAccumulator >= tick)
+        {
+            // At most one packet per step, the redundant history covers anything skipped
+            m_inputAccumulator = glm::min(m_inputAccumulator - tick, tick);
+            SendInput();
+        }
+
+        m_pingTimer += deltaTime;
+        if (m_pingTimer >= c_pingInterval && m_protocolVersion.load(std::memory_order_relaxed) >= 2)
+        {
+            m_pingTimer = 0.0f;
+            SendPing();
+        }
+
+        m_statsTime += deltaTime;
+        if (m_statsTime >= c_statsWindow)
+        {
+            m_inputStats.sendRate = m_windowPackets / m_statsTime;
+            m_inputStats.bytesPerSecond = m_windowBytes / m_statsTime;
+            m_inputStats.redundancy = m_windowPackets > 0 ? float(m_windowInputs) / m_windowPackets : 0.0f;
+            m_statsTime = 0.0f;
+            m_windowPackets = 0;
+            m_windowInputs = 0;
+            m_windowBytes = 0;
+        }
     }
 
     void Connection::SendInput()
     {
+        // Changes within the tick are coalesced, a tap shorter than a tick is still sent as pressed
         InputMessage message;
-        message.upPressed = m_inputState.upPressed;
-        message.downPressed = m_inputState.downPressed;
+        message.upPressed = m_latchedState.upPressed;
+        message.downPressed = m_latchedState.downPressed;
         message.sequenceNumber = m_sequenceNumber++;
-        auto now = std::chrono::steady_clock::now();
-        message.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+        message.timestamp = uint64_t(GetTime() * 1000.0);
+        m_latchedState = m_inputState;
+
+        m_pendingInputs.Push() = message;
+
+        // Every packet repeats the inputs the server has not acknowledged yet
+        uint8_t packet[wire::c_maxInputPacketSize];
+        const uint8_t *data = packet;
+        size_t size = 0;
+        uint32_t inputs = 1;
+        if (m_protocolVersion.load(std::memory_order_relaxed) >= 2)
+        {
+            // Only the newest inputs go out, copied oldest first as the encoder expects them
+            InputMessage redundant[wire::c_inputRedundancy];
+            inputs = glm::min(uint32_t(m_pendingInputs.size()), wire::c_inputRedundancy);
+            const size_t first = m_pendingInputs.size() - inputs;
+            for (uint32_t i = 0; i < inputs; i++)
+            {
+                redundant[i] = m_pendingInputs[first + i];
+            }
+            size = EncodeInputPacket(redundant, inputs, packet, sizeof(packet));
+        }
+        else
+        {
+            data = reinterpret_cast<const uint8_t *>(&message);
+            size = sizeof(InputMessage);
+        }
 
-        emscripten_websocket_send_binary(m_socket, &message, sizeof(InputMessage));
+        Send(data, size);
+
+        m_inputStats.packets++;
+        m_inputStats.bytes += size;
+        m_windowPackets++;
+        m_windowInputs += inputs;
+        m_windowBytes += uint32_t(size);
     }
 
-    GameStateMessage *Connection::PopLatestMessage()
+    void Connection::Send(const uint8_t *data, size_t size)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_messages.size() > 0)
+        if (m_capture.IsOpen())
         {
-            GameStateMessage *msg = &m_messages.back();
-            m_messages.pop_back();
-            return msg;
+            m_capture.Write(CaptureDirection::Sent, GetTime(), data, size);
         }
 
-        return nullptr;
+        m_transport->Send(data, size);
+    }
+
+    bool Connection::StartCapture(const std::string &path)
+    {
+        if (!m_capture.Open(path, GetTime()))
+        {
+            return false;
+        }
+
+        std::cout << "Capturing network traffic to " << path << std::endl;
+        return true;
+    }
+
+    void Connection::SendSnapshotAck(uint16_t snapshotId)
+    {
+        uint8_t ack[wire::c_ackSize];
+        const size_t size = EncodeSnapshotAck(snapshotId, ack, sizeof(ack));
+        Send(ack, size);
+    }
+
+    void Connection::SendPing()
+    {
+        uint8_t ping[wire::c_pingSize];
+        const size_t size = EncodePing(m_pingId++, uint64_t(GetTime() * 1e6), ping, sizeof(ping));
+        Send(ping, size);
+    }
+
+    void Connection::AcknowledgeInput(uint32_t sequenceNumber)
+    {
+        size_t count = 0;
+        while (count < m_pendingInputs.size() && m_pendingInputs[count].sequenceNumber < sequenceNumber)
+        {
+            count++;
+        }
+        m_pendingInputs.PopFront(count);
     }
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "pong/EmscriptenTransport.h"
+
+#ifdef __EMSCRIPTEN__
+
+#include <iostream>
+
+namespace pong
+{
+    EM_BOOL EmscriptenTransport::OnOpen(int eventType, const EmscriptenWebSocketOpenEvent *websocketEvent, void *userData)
+    {
+        EmscriptenTransport *transport = reinterpret_cast<EmscriptenTransport *>(userData);
+        transport->m_open = true;
+        std::cout << "onopen" << std::endl;
+        return EM_TRUE;
+    }
+
+    EM_BOOL EmscriptenTransport::OnError(int eventType, const EmscriptenWebSocketErrorEvent *websocketEvent, void *userData)
+    {
+        std::cerr << "onerror" << std::endl;
+        return EM_TRUE;
+    }
+
+    EM_BOOL EmscriptenTransport::OnClose(int eventType, const EmscriptenWebSocketCloseEvent *websocketEvent, void *userData)
+    {
+        EmscriptenTransport *transport = reinterpret_cast<EmscriptenTransport *>(userData);
+        transport->m_open = false;
+        std::cout << "onclose: " << websocketEvent->wasClean << std::endl;
+        return EM_TRUE;
+    }
+
+    EM_BOOL EmscriptenTransport::OnMessage(int eventType, const EmscriptenWebSocketMessageEvent *websocketEvent, void *userData)
+    {
+        EmscriptenTransport *transport = reinterpret_cast<EmscriptenTransport *>(userData);
+        if (transport->m_onReceive != nullptr)
+        {
+            transport->m_onReceive(websocketEvent->data, websocketEvent->numBytes, transport->m_userData);
+        }
+        return EM_TRUE;
+    }
+
+    bool EmscriptenTransport::Connect(const std::string &url, ReceiveCallback onReceive, void *userData)
+    {
+        if (!emscripten_websocket_is_supported())
+        {
+            std::cerr << "WebSockets are not supported." << std::endl;
+            return false;
+        }
+
+        m_onReceive = onReceive;
+        m_userData = userData;
+
+        EmscriptenWebSocketCreateAttributes wsAttrs = {url.c_str(), NULL, EM_TRUE};
+
+        m_socket = emscripten_websocket_new(&wsAttrs);
+        if (m_socket <= 0)
+        {
+            std::cerr << "Failed to create WebSocket for " << url << std::endl;
+            return false;
+        }
+
+        emscripten_websocket_set_onopen_callback(m_socket, this, OnOpen);
+        emscripten_websocket_set_onerror_callback(m_socket, this, OnError);
+        emscripten_websocket_set_onclose_callback(m_socket, this, OnClose);
+        emscripten_websocket_set_onmessage_callback(m_socket, this, OnMessage);
+        return true;
+    }
+
+    void EmscriptenTransport::Close()
+    {
+        if (m_socket > 0)
+        {
+            emscripten_websocket_close(m_socket, 1000, "");
+            emscripten_websocket_delete(m_socket);
+            m_socket = 0;
+        }
+        m_open = false;
+    }
+
+    bool EmscriptenTransport::Send(const uint8_t *data, size_t size)
+    {
+        if (!m_open)
+        {
+            return false;
+        }
+
+        return emscripten_websocket_send_binary(m_socket, const_cast<uint8_t *>(data), uint32_t(size)) == EMSCRIPTEN_RESULT_SUCCESS;
+    }
+}
+
+#endif
@@ -0,0 +1,48 @@
+#include "pong/EventJournal.h"
+
+namespace pong
+{
+    glm::vec2 GameEvent::GetPosition() const
+    {
+        return glm::vec2(float(x), float(y)) / c_positionScale - c_positionOffset;
+    }
+
+    void GameEvent::SetPosition(glm::vec2 position)
+    {
+        const glm::vec2 quantized = glm::clamp((position + c_positionOffset) * c_positionScale + 0.5f, 0.0f, float(c_positionMax));
+        x = uint32_t(quantized.x);
+        y = uint32_t(quantized.y);
+    }
+
+    const GameEvent &EventJournal::Push(EventType type, EventSource source, uint32_t tick, glm::vec2 position, double time)
+    {
+        GameEvent &event = m_events[m_next % c_capacity];
+        event.time = time;
+        event.id = m_next;
+        event.tick = tick;
+        event.type = uint32_t(type);
+        event.source = uint32_t(source);
+        event.SetPosition(position);
+
+        m_next++;
+        return event;
+    }
+
+    bool EventJournal::Next(Cursor &cursor, GameEvent &event) const
+    {
+        if (m_next - cursor.next > c_capacity)
+        {
+            cursor.missed += m_next - cursor.next - c_capacity;
+            cursor.next = m_next - c_capacity;
+        }
+
+        if (cursor.next == m_next)
+        {
+            return false;
+        }
+
+        event = m_events[cursor.next % c_capacity];
+        cursor.next++;
+        return true;
+    }
+}
@@ -5,309 +5,359 @@
 #include <emscripten/emscripten.h>
 #include <emscripten/websocket.h>
 
+#include <array>
+#include <cstdlib>
+#include <initializer_list>
 #include <iostream>
 #include <random>
-#include <set>
 #include <stdio.h>
 
 namespace pong
 {
-    void Game::Initialize(Renderer &renderer)
+    // Number of matches on the wall, ?wall=16 in the browser and PONG_WALL natively, one by default
+    static uint32_t GetWallMatchCount()
     {
-        std::cout << "Initializing game" << std::endl;
-
-        m_tableModel = renderer.CreateModel("./dist/table.dat");
-        m_paddelModel = renderer.CreateModel("./dist/racket.dat");
-        m_ballModel = renderer.CreateModel("./dist/ball.dat");
-        // m_debugPlane = renderer.CreateQuad({1.0f, 1.0f}, glm::vec3(156, 72, 72) * 1.0f / 255.0f);
-
-        m_fontTextureAtlas = renderer.CreateTexture("./dist/font.dat");
-
-        glm::mat4 baseTextTransform = glm::translate(glm::mat4(1.0f), glm::vec3(c_arenaWidth / 2.0f, 30.0f, -c_arenaHeight / 8.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.5f, 1.0f, -0.5f));
-        m_waitingTextSprites = GenerateTextSprites("Waiting for opponent", baseTextTransform);
-        m_gameOverTextSprites = GenerateTextSprites("Game over", baseTextTransform * glm::scale(glm::mat4(1.0f), glm::vec3(2.0f, 1.0f, 2.0f)));
-        m_startingTextSprites = GenerateTextSprites("Starting", baseTextTransform * glm::scale(glm::mat4(1.0f), glm::vec3(2.0f, 1.0f, 2.0f)));
-
-        m_hitSound = Sound::Create("./dist/ball_hit_1.wav");
-        m_smashSound = Sound::Create("./dist/smash_hit.wav");
-        m_racketSound = Sound::Create("./dist/racket_hit.wav");
-        m_winSound = Sound::Create("./dist/win.wav");
-        m_loseSound = Sound::Create("./dist/lose.wav");
-        Application::GetAudioPlayer().SetListenerPosition(m_camera.transform.position);
-
-        Connection &connection = Application::GetConnection();
-        connection.Initialize();
-
-        m_camera.offset = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1000.0f, -c_arenaHeight / 2.0f));
+#ifdef __EMSCRIPTEN__
+        const int count = EM_ASM_INT(
+            const url = new URL(window.location.href);
+            return parseInt(url.searchParams.get("wall")) || 1;);
+#else
+        const char *value = std::getenv("PONG_WALL");
+        const int count = value != nullptr ? std::atoi(value) : 1;
+#endif
+        return uint32_t(glm::clamp(count, 1, int(c_maxMatches)));
     }
 
-    float Game::CalculateBallHeight(glm::vec2 position, glm::vec2 velocity)
+    // Bots play every match, ?bots=true in the browser and PONG_BOTS=1 natively
+    static bool GetBotsFlag()
     {
-        const float c_lowerTarget = c_ballRadius;
-        const float c_g = 9.82f;
-        const float vx = velocity.x;
-        const bool isMovingRight = velocity.x > 0.0f;
-        const bool hasBounced = isMovingRight ? position.x > c_arenaWidth * c_tabelHitLocation : position.x < c_arenaWidth * (1.0f - c_tabelHitLocation);
-
-        const float xorigin = hasBounced ? c_arenaWidth * c_tabelHitLocation : 0.0f;
-        const float x0 = (isMovingRight ? xorigin : c_arenaWidth - xorigin);
-        const float xtarget = hasBounced ? c_arenaWidth : c_arenaWidth * c_tabelHitLocation;
-        const float x1 = (isMovingRight ? xtarget : c_arenaWidth - xtarget);
-        const float x = position.x;
-
-        const float y0 = hasBounced ? c_lowerTarget : c_padelTableHitOffset;
-        const float y1 = hasBounced ? c_padelTableHitOffset : c_lowerTarget;
-
-        const float vy = -(vx * (y1 - y0 + (c_g * std::pow(x0 - x1, 2)) / (2 * std::pow(vx, 2)))) / (x0 - x1);
-        const float py = y0 + (vy * (x - x0)) / vx - (c_g * std::pow(x - x0, 2)) / (2 * std::pow(vx, 2));
-
-        return py;
+#ifdef __EMSCRIPTEN__
+        return EM_ASM_INT(
+                   const url = new URL(window.location.href);
+                   return url.searchParams.get("bots") === "true" ? 1 : 0;) == 1;
+#else
+        const char *value = std::getenv("PONG_BOTS");
+        return value != nullptr && std::atoi(value) != 0;
+#endif
     }
 
-    bool Game::HasBallHitTable(glm::vec2 position, glm::vec2 velocity)
+    // Only rejects boxes with every corner outside the same clip plane, which is enough for whole tables
+    static bool IsInView(const glm::mat4 &viewProjection, const glm::vec3 &min, const glm::vec3 &max)
     {
-        static bool lastHasBounced = false; // Ugly, but we only have one ball
-        const bool isMovingRight = velocity.x > 0.0f;
-        const bool hasBounced = isMovingRight ? position.x > c_arenaWidth * c_tabelHitLocation : position.x < c_arenaWidth * (1.0f - c_tabelHitLocation);
-        bool value = hasBounced && !lastHasBounced;
-        lastHasBounced = hasBounced;
-        return value;
+        std::array<uint32_t, 6> outside = {};
+        for (uint32_t corner = 0; corner < 8; corner++)
+        {
+            const glm::vec4 p = viewProjection * glm::vec4(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z, 1.0f);
+            outside[0] += p.x < -p.w;
+            outside[1] += p.x > p.w;
+            outside[2] += p.y < -p.w;
+            outside[3] += p.y > p.w;
+            outside[4] += p.z < -p.w;
+            outside[5] += p.z > p.w;
+        }
+        return std::none_of(outside.begin(), outside.end(), [](uint32_t count) { return count == 8; });
     }
 
-    uint32_t GetFontAtlasOffset(char c)
+    // Decodes one asset file into memory, on any thread
+    template <typename T>
+    struct AssetDecode
     {
-        if (c >= 'A' && c <= 'Z')
-        {
-            return c - 'A';
-        }
-        else if (c >= 'a' && c <= 'z')
+        const char *path = nullptr;
+        typename T::Data data;
+        bool loaded = false;
+
+        static void Run(void *userData)
         {
-            return c - 'a';
+            AssetDecode *decode = reinterpret_cast<AssetDecode *>(userData);
+            decode->loaded = T::Load(decode->path, decode->data);
         }
-        else if (c >= '0' && c <= '9')
+    };
+
+    struct MatchStep
+    {
+        const std::vector<std::unique_ptr<Match>> *matches = nullptr;
+        float deltaTime = 0.0f;
+    };
+
+    static void UpdateMatches(size_t begin, size_t end, void *userData)
+    {
+        const MatchStep &step = *reinterpret_cast<const MatchStep *>(userData);
+        for (size_t i = begin; i < end; i++)
         {
-            return 26 + c - '0';
+            (*step.matches)[i]->Update(step.deltaTime);
         }
-
-        return 0;
     }
 
-    std::vector<SpriteBatch::Instance> Game::GenerateTextSprites(const std::string &text, const glm::mat4 &transform, const glm::vec4 &tint) const
+    struct MatchExtraction
     {
-        const size_t textSize = text.size();
-        std::vector<SpriteBatch::Instance> instances;
-        instances.resize(textSize);
+        const std::vector<std::unique_ptr<Match>> *matches = nullptr;
+        const std::vector<VisibleMatch> *visible = nullptr;
+        MatchRenderBatch *batch = nullptr;
+        float alpha = 0.0f;
+    };
 
-        glm::vec3 start = glm::vec3(-(textSize * letterWorldWidth + letterSpacing * textSize) / 2.0f, 0.0f, 0.0f);
-        for (uint32_t i = 0; i < textSize; i++)
+    static void ExtractMatches(size_t begin, size_t end, void *userData)
+    {
+        const MatchExtraction &extraction = *reinterpret_cast<const MatchExtraction *>(userData);
+        for (size_t slot = begin; slot < end; slot++)
         {
-            SpriteBatch::Instance instance;
-            char c = text[i];
-            if (c == ' ')
-            {
-                continue;
-            }
-            uint32_t offset = GetFontAtlasOffset(c);
-
-            instance.offsetAndSize = glm::vec4(offset * letterWidth / m_fontTextureAtlas->GetWidth(), 0.0f, letterWidth / m_fontTextureAtlas->GetWidth(), 1.0f);
-            glm::vec3 offsetPosition = glm::vec3(i * (letterWorldWidth + letterSpacing), 0.0f, 0.0f);
-            glm::vec3 position = (start + offsetPosition);
-            instance.transform = transform * glm::translate(glm::mat4(1.0f), position) * glm::scale(glm::mat4(1.0f), glm::vec3(letterWorldWidth, 1.0f, letterWorldWidth));
-            instance.tint = tint;
-            instances[i] = instance;
+            const VisibleMatch &visible = (*extraction.visible)[slot];
+            (*extraction.matches)[visible.match]->Extract(*extraction.batch, uint32_t(slot), visible.firstPaddle, extraction.alpha);
         }
-
-        return instances;
     }
 
-    void Game::Update(float deltaTime)
+    void Game::Initialize(Renderer &renderer)
     {
-        static std::mt19937 gen(0);
-        static std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+        std::cout << "Initializing game" << std::endl;
 
-        static std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
-        std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
-        float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+        LoadAssets(renderer);
+        // m_debugPlane = renderer.CreateQuad({1.0f, 1.0f}, glm::vec3(156, 72, 72) * 1.0f / 255.0f);
+        m_text.Initialize(m_fontTextureAtlas.get());
+
+        Application::GetAudioPlayer().SetListenerPosition(m_camera.transform.position);
 
-        Connection &connection = Application::GetConnection();
-        GameStateMessage *msg = connection.GetLatestMessage();
+        Application::GetConnection().Initialize();
 
-        if (msg == nullptr || msg->handeled)
+        m_camera.offset = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1000.0f, -c_arenaHeight / 2.0f));
+
+        m_botsEnabled = GetBotsFlag();
+        InitializeWall(renderer, GetWallMatchCount());
+
+        if (m_botsEnabled)
         {
-            return;
+            m_bots.Initialize({});
+            for (uint32_t i = 0; i < m_matches.size(); i++)
+            {
+                m_bots.Add({}, i);
+            }
+            m_botObservations.resize(m_bots.size());
+            m_botDecisions.resize(m_bots.size());
+            std::cout << "Bots play " << m_bots.size() << " matches" << std::endl;
         }
+    }
 
-        m_playerId = msg->head.playerId;
-        m_state = msg->state;
-
-        // Update ball
-        glm::vec2 ballVelocity = msg->ball.velocity * c_scaleFactor;
-
-        static float ts = 1.0f;
-
-        // Asymtotically slow down ball when game is over
-        // if (msg->state == GameState::GameOver)
-        // {
-        //     ts += deltaTime * (0.1f - ts);
-        // }
-        // else
-        // {
-        //     ts = 1.0f;
-        // }
-
-        // We simulate the ball on the client if we are in between rounds or game over
-        glm::vec2 ballPosition = (msg->state != GameState::InBetweenRounds && msg->state != GameState::GameOver) ? msg->ball.position * c_scaleFactor : glm::vec2(m_ball.transform.position.x, m_ball.transform.position.z) + ballVelocity * deltaTime * ts;
-        float ballHeight = CalculateBallHeight(ballPosition, ballVelocity);
-        m_ball.transform.position = glm::vec3(ballPosition.x, ballHeight, ballPosition.y);
-        m_ball.velocity = glm::vec3(ballVelocity.x, 0.0f, ballVelocity.y);
-        msg->events.hasHit = msg->events.hasHit || HasBallHitTable(ballPosition, ballVelocity);
-
-        std::set<int32_t> playersToRemove;
-        for (auto &&[id, player] : m_players)
+    void Game::LoadAssets(Renderer &renderer)
+    {
+        AssetDecode<Model> table = {"./dist/table.dat"};
+        AssetDecode<Model> paddle = {"./dist/racket.dat"};
+        AssetDecode<Model> ball = {"./dist/ball.dat"};
+        AssetDecode<Texture> font = {"./dist/font.dat"};
+        AssetDecode<Sound> hitSound = {"./dist/ball_hit_1.wav"};
+        AssetDecode<Sound> smashSound = {"./dist/smash_hit.wav"};
+        AssetDecode<Sound> racketSound = {"./dist/racket_hit.wav"};
+        AssetDecode<Sound> winSound = {"./dist/win.wav"};
+        AssetDecode<Sound> loseSound = {"./dist/lose.wav"};
+
+        // Files are read and decoded by jobs, the GPU and audio objects are made here on the main thread
+        JobSystem &jobs = Application::GetJobSystem();
+        JobSystem::Job *decode = jobs.Create("Decode assets", nullptr, nullptr);
+        jobs.Run(jobs.Create("Decode model", AssetDecode<Model>::Run, &table, decode));
+        jobs.Run(jobs.Create("Decode model", AssetDecode<Model>::Run, &paddle, decode));
+        jobs.Run(jobs.Create("Decode model", AssetDecode<Model>::Run, &ball, decode));
+        jobs.Run(jobs.Create("Decode texture", AssetDecode<Texture>::Run, &font, decode));
+        for (AssetDecode<Sound> *sound : {&hitSound, &smashSound, &racketSound, &winSound, &loseSound})
         {
-            playersToRemove.insert(id);
+            jobs.Run(jobs.Create("Decode sound", AssetDecode<Sound>::Run, sound, decode));
         }
+        jobs.Run(decode);
+        jobs.Wait(decode);
+
+        m_tableModel = table.loaded ? renderer.CreateModel(table.data) : nullptr;
+        m_paddelModel = paddle.loaded ? renderer.CreateModel(paddle.data) : nullptr;
+        m_ballModel = ball.loaded ? renderer.CreateModel(ball.data) : nullptr;
+        m_fontTextureAtlas = font.loaded ? renderer.CreateTexture(font.data) : nullptr;
+        m_hitSound = hitSound.loaded ? Sound::Create(hitSound.data) : nullptr;
+        m_smashSound = smashSound.loaded ? Sound::Create(smashSound.data) : nullptr;
+        m_racketSound = racketSound.loaded ? Sound::Create(racketSound.data) : nullptr;
+        m_winSound = winSound.loaded ? Sound::Create(winSound.data) : nullptr;
+        m_loseSound = loseSound.loaded ? Sound::Create(loseSound.data) : nullptr;
+    }
 
-        // Update players
-        for (auto &&msgPlayer : msg->players)
+    void Game::InitializeWall(Renderer &renderer, uint32_t matchCount)
+    {
+        // Only the match we play is heard, the watched ones would drown it out
+        MatchResources played;
+        played.text = &m_text;
+        played.hitSound = m_hitSound.get();
+        played.smashSound = m_smashSound.get();
+        played.racketSound = m_racketSound.get();
+        played.winSound = m_winSound.get();
+        played.loseSound = m_loseSound.get();
+
+        MatchResources watched;
+        watched.text = &m_text;
+
+        // Row by row, as square as the count allows
+        const uint32_t columns = uint32_t(glm::ceil(glm::sqrt(float(matchCount))));
+        const uint32_t rows = (matchCount + columns - 1) / columns;
+        for (uint32_t i = 0; i < matchCount; i++)
         {
-            playersToRemove.erase(msgPlayer.playerId);
-
-            if (!m_players.contains(msgPlayer.playerId))
+            Connection *connection = &Application::GetConnection();
+            if (i > 0)
             {
-                m_players[msgPlayer.playerId] = {};
+                m_wallConnections.push_back(std::make_unique<Connection>());
+                connection = m_wallConnections.back().get();
+                // Watched unless bots play them
+                connection->Initialize(GetServerUrl(i, !m_botsEnabled));
             }
 
-            EPlayer &player = m_players[msgPlayer.playerId];
-            glm::vec3 newPlayerPos = glm::vec3(msgPlayer.position.x * c_scaleFactor.x, c_padelTableHitOffset, msgPlayer.position.y * c_scaleFactor.y);
+            const glm::vec3 origin = glm::vec3(float(i % columns) * c_wallSpacing.x, 0.0f, float(i / columns) * c_wallSpacing.y);
+            auto match = std::make_unique<Match>();
+            match->Initialize(*connection, i == 0 ? played : watched, origin, i == 0 || m_botsEnabled, i);
+            m_matches.push_back(std::move(match));
+        }
 
-            // Check if player has higher score
-            if (msgPlayer.score > player.score)
-            {
-                if (msgPlayer.playerId == msg->head.playerId)
-                {
-                    m_winSound->PlayAt(m_ball.transform.position, 250.0f);
-                }
-                else
-                {
-                    m_loseSound->PlayAt(m_ball.transform.position, 250.0f);
-                }
-            }
+        if (matchCount == 1)
+        {
+            return;
+        }
 
-            player.score = msgPlayer.score;
+        std::cout << "Showing " << matchCount << " matches in " << rows << " rows" << std::endl;
 
-            if (glm::abs(newPlayerPos.z - player.transform.position.z) > glm::epsilon<float>())
-            {
-                float targetAngle = 0.0f;
-                bool isOrientedUp = newPlayerPos.z > player.transform.position.z;
-                targetAngle = isOrientedUp ? -75.0f : 75.0f;
-                player.targetAngle = targetAngle;
-            }
+        // Looking down on the whole wall from far enough to fit it on a 16:9 screen
+        m_wallSize = glm::vec2(float(columns), float(rows)) * c_wallSpacing;
+        m_wallCenter = glm::vec3((m_wallSize.x - c_wallSpacing.x + c_arenaWidth) / 2.0f, 0.0f, (m_wallSize.y - c_wallSpacing.y + c_arenaHeight) / 2.0f);
+        const float distance = 1.1f * glm::max(m_wallSize.x * 9.0f / 16.0f, m_wallSize.y);
+        m_camera.transform = CTransform(glm::lookAt(m_wallCenter + glm::vec3(0.0f, distance, 0.3f * distance), m_wallCenter, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+        renderer.SetFarPlane(2.0f * distance);
+        renderer.SetShadowBounds(m_wallCenter, m_wallSize);
+    }
 
-            player.currentAngle += (player.targetAngle - player.currentAngle) * 5.0f * deltaTime;
-            player.transform.position = newPlayerPos;
+    void Game::Update(float deltaTime)
+    {
+        // Every connection is polled before any match steps, so the matches update as one batch on the
+        // network state of this step. Sockets belong to the main thread, only the matches run as jobs.
+        for (auto &&match : m_matches)
+        {
+            match->GetConnection().PollMessages();
         }
 
-        for (auto &&id : playersToRemove)
+        if (m_botsEnabled)
         {
-            m_players.erase(id);
+            UpdateBots(deltaTime);
         }
 
-        // Update camera and play hit sounds
-        if (msg->events.hasSmashed)
+        // Inputs and pings only go out on connections that play, spectating ones only receive
+        for (auto &&match : m_matches)
         {
-            m_camera.trauma = 0.6f;
-            m_smashSound->PlayAt(m_ball.transform.position);
+            if (match->IsControlled())
+            {
+                match->GetConnection().UpdateInput(deltaTime);
+            }
         }
-        else if (msg->events.playerWasHit)
+
+        MatchStep step;
+        step.matches = &m_matches;
+        step.deltaTime = deltaTime;
+        Application::GetJobSystem().ParallelFor(m_matches.size(), 1, UpdateMatches, &step, "Match::Update");
+
+        for (auto &&match : m_matches)
         {
-            m_camera.trauma = 0.3f;
-            m_racketSound->PlayAt(m_ball.transform.position);
+            match->PlaySounds();
         }
-        else if (msg->events.hasHit)
+
+        UpdateCamera(deltaTime);
+    }
+
+    void Game::UpdateBots(float deltaTime)
+    {
+        // Bots look at the state of the last step and press keys like a player would
+        for (uint32_t i = 0; i < m_matches.size(); i++)
         {
-            // m_camera.trauma = 0.0f;
-            float pitch = 1.0f + (glm::abs(dist(gen)) * 0.15f);
-            m_hitSound->PlayAt(m_ball.transform.position, 1.0f, pitch);
+            m_botObservations[i] = m_matches[i]->Observe();
         }
-        else
+
+        const uint64_t timestamp = uint64_t(m_matches.front()->GetConnection().GetTime() * 1000.0);
+        m_bots.DecideAll(m_botObservations.data(), m_botDecisions.data(), deltaTime, timestamp, &Application::GetJobSystem());
+
+        for (uint32_t i = 0; i < m_matches.size(); i++)
         {
-            m_camera.trauma -= deltaTime * m_camera.traumaDecay;
-            m_camera.trauma = glm::max(m_camera.trauma, 0.0f);
+            Connection &connection = m_matches[i]->GetConnection();
+            connection.SetPressedUp(m_botDecisions[i].upPressed);
+            connection.SetPressedDown(m_botDecisions[i].downPressed);
         }
+    }
+
+    void Game::UpdateCamera(float deltaTime)
+    {
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
 
-        float shake = m_camera.trauma * m_camera.trauma;
+        // The wall camera holds still, with one match it shakes on impacts and leans towards the ball
+        glm::mat4 newOffset = glm::mat4(1.0f);
+        if (m_matches.size() == 1)
+        {
+            Match &match = *m_matches.front();
+            if (!match.ReadCameraEvents(m_camera.trauma))
+            {
+                m_camera.trauma -= deltaTime * m_camera.traumaDecay;
+                m_camera.trauma = glm::max(m_camera.trauma, 0.0f);
+            }
 
-        const float maxShake = 10.0f;
-        glm::mat4 newOffset =
-            glm::rotate(glm::mat4(1.0f), glm::radians(maxShake * dist(gen) * shake), glm::vec3(0.0f, 1.0f, 0.0f)) *
-            glm::rotate(glm::mat4(1.0f), glm::radians(maxShake * dist(gen) * shake), glm::vec3(1.0f, 0.0f, 0.0f));
+            float shake = m_camera.trauma * m_camera.trauma;
 
-        glm::vec3 ballTranslation = glm::vec3(m_ball.transform.position.x - c_arenaWidth / 2.0f, 0.0f, m_ball.transform.position.z - c_arenaHeight / 2.0f);
-        ballTranslation.x = glm::clamp(ballTranslation.x, -c_arenaWidth / 2.0f, c_arenaWidth / 2.0f);
-        ballTranslation.z = glm::clamp(ballTranslation.z, -c_arenaHeight / 2.0f, c_arenaHeight / 2.0f);
-        newOffset = glm::translate(newOffset, -ballTranslation * 0.05f);
+            const float maxShake = 10.0f;
+            newOffset =
+                glm::rotate(glm::mat4(1.0f), glm::radians(maxShake * dist(m_random) * shake), glm::vec3(0.0f, 1.0f, 0.0f)) *
+                glm::rotate(glm::mat4(1.0f), glm::radians(maxShake * dist(m_random) * shake), glm::vec3(1.0f, 0.0f, 0.0f));
+
+            const glm::vec3 &ballPosition = match.GetBall().transform.position;
+            glm::vec3 ballTranslation = glm::vec3(ballPosition.x - c_arenaWidth / 2.0f, 0.0f, ballPosition.z - c_arenaHeight / 2.0f);
+            ballTranslation.x = glm::clamp(ballTranslation.x, -c_arenaWidth / 2.0f, c_arenaWidth / 2.0f);
+            ballTranslation.z = glm::clamp(ballTranslation.z, -c_arenaHeight / 2.0f, c_arenaHeight / 2.0f);
+            newOffset = glm::translate(newOffset, -ballTranslation * 0.05f);
+        }
 
         // Asymtotically approach target
         m_camera.offset = glm::mix(m_camera.offset, newOffset, 5.0f * deltaTime);
-
-        msg->handeled = true;
     }
 
-    void Game::Render(Renderer &renderer)
+    void Game::Render(Renderer &renderer, float alpha)
     {
-        static glm::mat4 paddelRenderTransformOffset = glm::translate(glm::mat4(1.0f), glm::vec3(-c_padelWidth / 2.0f, 0.0f, c_padelHeight / 2.0f));
-        static glm::mat4 ballRenderTransformOffset = glm::translate(glm::mat4(1.0f), glm::vec3(-c_ballRadius, 0.0f, -c_ballRadius)) * glm::scale(glm::mat4(1.0f), glm::vec3(1.3f));
         renderer.SetCameraView(m_camera.transform.GetMatrix() * m_camera.offset);
 
-        std::vector<glm::mat4> playerTransforms = std::vector<glm::mat4>(m_players.size());
-        std::vector<SpriteBatch::Instance> spriteInstances = std::vector<SpriteBatch::Instance>();
-        uint32_t i = 0;
-        const float letterWidth = 148.0f;
-        for (const auto &[id, player] : m_players)
+        // Matches outside the view add nothing, not even their text
+        const glm::mat4 viewProjection = renderer.GetViewProjection();
+        m_visibleMatches.clear();
+        m_culledMatches = 0;
+        uint32_t paddleCount = 0;
+        for (uint32_t i = 0; i < m_matches.size(); i++)
         {
-            // Player
-            float angle = player.currentAngle;
-            playerTransforms[i] = player.transform.GetMatrix() * paddelRenderTransformOffset * glm::mat4_cast(glm::quat(glm::vec3(0.0f, glm::radians(angle), glm::radians(90.0f))));
-
-            // Score
-            float xOffset = (player.transform.position.x < c_arenaWidth / 2.0f ? -1.0f : 1.0f) * c_arenaWidth / 4.0f;
-            std::vector<SpriteBatch::Instance> instances = GenerateTextSprites(
-                std::to_string(player.score),
-                glm::translate(glm::mat4(1.0f), glm::vec3(c_arenaWidth / 2.0f + xOffset, 0.0f, c_arenaHeight / 6.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, 1.0f, -1.0f)));
-            spriteInstances.insert(spriteInstances.end(), instances.begin(), instances.end());
-
-            // Player names
-            // bool isPlayer = id == m_playerId;
-            // std::string name = isPlayer ? "You" : "Opponent";
-            // instances = GenerateTextSprites(
-            //     name,
-            //     glm::translate(glm::mat4(1.0f), glm::vec3(c_arenaWidth / 2.0f + xOffset, 0.0f, c_arenaHeight * 1.05)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.4f, 1.0f, -0.4f)),
-            //     glm::vec4(!isPlayer, 0.0f, isPlayer, 1.0f));
-            // spriteInstances.insert(spriteInstances.end(), instances.begin(), instances.end());
-            i++;
+            Match &match = *m_matches[i];
+            glm::vec3 min, max;
+            match.GetBounds(min, max);
+            const bool visible = IsInView(viewProjection, min, max);
+            match.SetTextVisible(visible);
+            if (visible)
+            {
+                m_visibleMatches.push_back({i, paddleCount});
+                paddleCount += match.GetPaddleCount();
+            }
+            else
+            {
+                m_culledMatches++;
+            }
         }
 
-        if (m_state == GameState::WaitingForPlayers)
-        {
-            spriteInstances.insert(spriteInstances.end(), m_waitingTextSprites.begin(), m_waitingTextSprites.end());
-        }
-        else if (m_state == GameState::GameOver)
-        {
-            spriteInstances.insert(spriteInstances.end(), m_gameOverTextSprites.begin(), m_gameOverTextSprites.end());
-        }
-        else if (m_state == GameState::Starting)
-        {
-            spriteInstances.insert(spriteInstances.end(), m_startingTextSprites.begin(), m_startingTextSprites.end());
-        }
+        // Slots and paddle ranges are handed out up front, so the matches fill the batch in parallel
+        m_renderBatch.Resize(uint32_t(m_visibleMatches.size()), paddleCount);
+        MatchExtraction extraction;
+        extraction.matches = &m_matches;
+        extraction.visible = &m_visibleMatches;
+        extraction.batch = &m_renderBatch;
+        extraction.alpha = alpha;
+        Application::GetJobSystem().ParallelFor(m_visibleMatches.size(), 1, ExtractMatches, &extraction, "Match::Extract");
+
+        // Text blocks share the font atlas and are merged into one draw by the renderer
+        m_text.Submit(renderer);
 
-        renderer.SubmitInstances(m_fontTextureAtlas.get(), spriteInstances);
-        renderer.SubmitInstances(m_paddelModel.get(), playerTransforms);
-        renderer.SubmitInstances(m_tableModel.get(), {m_table.transform.GetMatrix()});
-        renderer.SubmitInstances(m_ballModel.get(), {m_ball.transform.GetMatrix() * ballRenderTransformOffset});
+        // One instanced batch per model however many matches there are, the shadow pass draws the same batches
+        BuildTransforms(m_renderBatch.paddles.View(), m_renderBatch.paddleCount, renderer.AllocateInstances(m_paddelModel.get(), m_renderBatch.paddleCount));
+        renderer.SubmitInstances(m_tableModel.get(), m_renderBatch.tables);
+        renderer.SubmitInstances(m_ballModel.get(), m_renderBatch.balls);
 
         // Floor
-        // SpriteBatch::Instance floorInstance;
+        // SpriteBatch::TransformInstance floorInstance;
         // floorInstance.transform = glm::translate(glm::mat4(1.0f), glm::vec3(c_arenaWidth / 2.0f, -80.0f, c_arenaHeight / 2.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(c_arenaWidth * 10.0f, 1.0f, c_arenaWidth * 10.0f));
         // renderer.SubmitInstances(m_floorSprite.get(), {floorInstance});
         // renderer.SubmitInstances(m_debugPlane.get(), {floorInstance.transform});
@@ -315,6 +365,12 @@ namespace pong
 
     void Game::Terminate()
     {
+        for (auto &&match : m_matches)
+        {
+            match->Terminate();
+        }
+        m_matches.clear();
+        m_wallConnections.clear();
     }
 
 }
\ No newline at end of file
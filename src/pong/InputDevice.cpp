@@ -21,11 +21,11 @@ namespace pong
 
                 if (keyEvent->keyCode == 38 || keyEvent->keyCode == 87)
                 {
-                    connection.SendPressedUp(true);
+                    connection.SetPressedUp(true);
                 }
                 else if (keyEvent->keyCode == 40 || keyEvent->keyCode == 83)
                 {
-                    connection.SendPressedDown(true);
+                    connection.SetPressedDown(true);
                 }
 
                 return true;
@@ -45,11 +45,11 @@ namespace pong
                 // Up arrow
                 if (keyEvent->keyCode == 38 || keyEvent->keyCode == 87)
                 {
-                    connection.SendPressedUp(false);
+                    connection.SetPressedUp(false);
                 }
                 else if (keyEvent->keyCode == 40 || keyEvent->keyCode == 83)
                 {
-                    connection.SendPressedDown(false);
+                    connection.SetPressedDown(false);
                 }
 
                 return true;
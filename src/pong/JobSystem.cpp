@@ -0,0 +1,293 @@
+#include "pong/JobSystem.h"
+
+#include "pong/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace pong
+{
+    static_assert((JobSystem::c_maxJobs & (JobSystem::c_maxJobs - 1)) == 0, "Job ring size has to be a power of two");
+
+    // Loops are cut into at most this many chunks, so one loop never fills a job ring by itself
+    static constexpr size_t c_maxLoopChunks = JobSystem::c_maxJobs / 4;
+
+    // Queue of the current thread, the main thread keeps 0
+    static thread_local uint32_t s_threadIndex = 0;
+
+    void JobSystem::Initialize(uint32_t workerCount, Profiler *profiler)
+    {
+        Terminate();
+
+        m_profiler = profiler;
+        s_threadIndex = 0;
+        for (uint32_t i = 0; i <= workerCount; i++)
+        {
+            m_queues.push_back(std::make_unique<Queue>());
+        }
+
+        m_workers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            m_workers.emplace_back(&JobSystem::WorkerMain, this, i + 1);
+        }
+    }
+
+    void JobSystem::Terminate()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+
+        for (auto &&worker : m_workers)
+        {
+            worker.join();
+        }
+        m_workers.clear();
+        m_queues.clear();
+        m_queued.store(0, std::memory_order_relaxed);
+        m_profiler = nullptr;
+        m_stopping = false;
+    }
+
+    JobSystem::Job *JobSystem::Create(const char *name, JobFunction function, void *userData, Job *parent)
+    {
+        Queue &queue = *m_queues[s_threadIndex];
+        Job *job = Allocate(queue);
+        while (job == nullptr)
+        {
+            // Every slot is taken, help finish other jobs until one is free again
+            if (Job *other = GetJob(s_threadIndex))
+            {
+                Execute(other);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+            job = Allocate(queue);
+        }
+
+        job->name = name;
+        job->function = function;
+        job->range = nullptr;
+        job->userData = userData;
+        job->begin = 0;
+        job->end = 0;
+        job->parent = parent;
+        job->unfinished.store(1, std::memory_order_relaxed);
+        job->continuationCount = 0;
+
+        if (parent != nullptr)
+        {
+            parent->unfinished.fetch_add(1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    JobSystem::Job *JobSystem::Allocate(Queue &queue)
+    {
+        // Slots of long running jobs are skipped, a loop stays unfinished while its chunks create many more jobs
+        for (uint32_t i = 0; i < c_maxJobs; i++)
+        {
+            Job *job = &queue.storage[queue.allocated++ % c_maxJobs];
+            if (job->unfinished.load(std::memory_order_acquire) == 0)
+            {
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    bool JobSystem::AddContinuation(Job *job, Job *continuation)
+    {
+        if (job->continuationCount >= c_maxContinuations)
+        {
+            return false;
+        }
+
+        job->continuations[job->continuationCount++] = continuation;
+        return true;
+    }
+
+    void JobSystem::Run(Job *job)
+    {
+        // Inline without workers, and when the queue is full rather than dropping the job
+        if (m_workers.empty() || !Push(job))
+        {
+            Execute(job);
+        }
+    }
+
+    void JobSystem::Wait(Job *job)
+    {
+        while (!IsDone(job))
+        {
+            if (Job *other = GetJob(s_threadIndex))
+            {
+                Execute(other);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::ParallelFor(size_t count, size_t grain, RangeFunction function, void *userData, const char *name)
+    {
+        grain = std::max<size_t>(grain, 1);
+        grain = std::max(grain, (count + c_maxLoopChunks - 1) / c_maxLoopChunks);
+
+        Job *loop = Create(name, nullptr, nullptr);
+        for (size_t begin = 0; begin < count; begin += grain)
+        {
+            Job *chunk = Create(name, nullptr, userData, loop);
+            chunk->range = function;
+            chunk->begin = begin;
+            chunk->end = std::min(begin + grain, count);
+            Run(chunk);
+        }
+
+        Run(loop);
+        Wait(loop);
+    }
+
+    bool JobSystem::Push(Job *job)
+    {
+        Queue &queue = *m_queues[s_threadIndex];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tail - queue.head == c_maxJobs)
+            {
+                return false;
+            }
+            queue.jobs[queue.tail++ % c_maxJobs] = job;
+        }
+
+        // Taking the lock orders this after a worker that is about to sleep has checked the count
+        m_queued.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        m_wake.notify_one();
+        return true;
+    }
+
+    JobSystem::Job *JobSystem::Pop(uint32_t index)
+    {
+        Queue &queue = *m_queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tail == queue.head)
+        {
+            return nullptr;
+        }
+
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        return queue.jobs[--queue.tail % c_maxJobs];
+    }
+
+    JobSystem::Job *JobSystem::Steal(uint32_t index)
+    {
+        const uint32_t count = uint32_t(m_queues.size());
+        for (uint32_t offset = 1; offset < count; offset++)
+        {
+            Queue &queue = *m_queues[(index + offset) % count];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tail != queue.head)
+            {
+                m_queued.fetch_sub(1, std::memory_order_relaxed);
+                return queue.jobs[queue.head++ % c_maxJobs];
+            }
+        }
+        return nullptr;
+    }
+
+    JobSystem::Job *JobSystem::GetJob(uint32_t index)
+    {
+        Job *job = Pop(index);
+        return job != nullptr ? job : Steal(index);
+    }
+
+    void JobSystem::Execute(Job *job)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        if (job->range != nullptr)
+        {
+            job->range(job->begin, job->end, job->userData);
+        }
+        else if (job->function != nullptr)
+        {
+            job->function(job->userData);
+        }
+        else
+        {
+            // Grouping jobs take no time worth recording
+            Finish(job);
+            return;
+        }
+
+        // Recorded before finishing, once a job is done its waiter may read the profiler
+        if (m_profiler != nullptr)
+        {
+            m_profiler->Record(s_threadIndex, job->name, std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count());
+        }
+        Finish(job);
+    }
+
+    void JobSystem::Finish(Job *job)
+    {
+        // Copied while the job is still unfinished, as soon as it is done its creator may reuse it
+        Job *parent = job->parent;
+        const uint32_t continuationCount = job->continuationCount;
+        const std::array<Job *, c_maxContinuations> continuations = job->continuations;
+
+        if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+
+        for (uint32_t i = 0; i < continuationCount; i++)
+        {
+            Run(continuations[i]);
+        }
+
+        if (parent != nullptr)
+        {
+            Finish(parent);
+        }
+    }
+
+    void JobSystem::WorkerMain(uint32_t index)
+    {
+        s_threadIndex = index;
+        while (true)
+        {
+            if (Job *job = GetJob(index))
+            {
+                Execute(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]
+                        { return m_stopping || m_queued.load(std::memory_order_acquire) > 0; });
+            if (m_stopping)
+            {
+                return;
+            }
+        }
+    }
+
+    uint32_t JobSystem::GetDefaultWorkerCount()
+    {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+        return 0;
+#else
+        const uint32_t threads = std::thread::hardware_concurrency();
+        return threads > 1 ? threads - 1 : 0;
+#endif
+    }
+}
@@ -0,0 +1,113 @@
+#include "pong/LoopbackServer.h"
+
+#include <glm/glm.hpp>
+
+namespace pong
+{
+    void LoopbackServer::Initialize(const Config &config)
+    {
+        m_config = config;
+
+        Simulation::Config simulation;
+        simulation.tickRate = config.tickRate;
+        simulation.winningScore = config.winningScore;
+        m_simulation.Initialize(simulation);
+
+        m_accumulator = 0.0f;
+        m_snapshotId = 0;
+        m_sent.Clear();
+        m_ackedSnapshot = wire::c_noBaseline;
+        m_pendingPongs.clear();
+    }
+
+    void LoopbackServer::Receive(const uint8_t *data, size_t size)
+    {
+        uint16_t snapshotId = 0;
+        if (DecodeSnapshotAck(data, size, snapshotId) == DecodeResult::Ok)
+        {
+            m_ackedSnapshot = snapshotId;
+            return;
+        }
+
+        // Pings are answered on the next update, the time they wait counts as network delay
+        PingExchange exchange;
+        if (DecodePing(data, size, exchange) == DecodeResult::Ok)
+        {
+            m_pendingPongs.push_back(exchange);
+            return;
+        }
+
+        // Redundant inputs are applied oldest first, ones we already have are skipped
+        InputPacket packet;
+        if (DecodeInputPacket(data, size, packet) == DecodeResult::Ok)
+        {
+            for (size_t i = packet.inputs.size(); i > 0; i--)
+            {
+                m_simulation.ApplyInput(0, packet.newestSequence - uint32_t(i - 1), packet.inputs[i - 1]);
+            }
+            return;
+        }
+
+        InputMessage input;
+        if (DecodeInputMessage(data, size, input) == DecodeResult::Ok)
+        {
+            m_simulation.ApplyInput(0, input);
+        }
+    }
+
+    void LoopbackServer::SendSnapshot(ITransport::ReceiveCallback onSend, void *userData)
+    {
+        // The client plays the left paddle
+        GameStateMessage state = m_simulation.GetState();
+        state.head.playerId = Simulation::c_leftPlayerId;
+        state.head.sequenceNumber = m_simulation.GetAppliedInput(0);
+
+        uint8_t frame[wire::c_maxFrameSizeV2 > wire::c_maxFrameSize ? wire::c_maxFrameSizeV2 : wire::c_maxFrameSize];
+        size_t size = 0;
+        if (m_config.protocolVersion >= 2)
+        {
+            const QuantizedSnapshot snapshot = QuantizeSnapshot(state, m_snapshotId);
+            const QuantizedSnapshot *baseline = m_ackedSnapshot != wire::c_noBaseline ? m_sent.Find(m_ackedSnapshot) : nullptr;
+            size = EncodeGameStateV2(snapshot, baseline, frame, sizeof(frame));
+
+            m_sent.Store(snapshot);
+            m_snapshotId = (m_snapshotId + 1) % wire::c_noBaseline;
+        }
+        else
+        {
+            size = EncodeGameState(state, frame, sizeof(frame));
+        }
+
+        if (size > 0 && onSend != nullptr)
+        {
+            onSend(frame, size, userData);
+        }
+    }
+
+    void LoopbackServer::Update(float deltaTime, ITransport::ReceiveCallback onSend, void *userData)
+    {
+        m_serverTime += deltaTime;
+        for (auto &&exchange : m_pendingPongs)
+        {
+            exchange.serverReceiveTime = uint64_t(m_serverTime * 1e6);
+            exchange.serverSendTime = exchange.serverReceiveTime;
+
+            uint8_t pong[wire::c_pongSize];
+            const size_t size = EncodePong(exchange, pong, sizeof(pong));
+            if (size > 0 && onSend != nullptr)
+            {
+                onSend(pong, size, userData);
+            }
+        }
+        m_pendingPongs.clear();
+
+        const float tick = m_simulation.GetTimeStep();
+        m_accumulator = glm::min(m_accumulator + deltaTime, 0.25f);
+        while (m_accumulator >= tick)
+        {
+            m_simulation.Step();
+            SendSnapshot(onSend, userData);
+            m_accumulator -= tick;
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#include "pong/LoopbackTransport.h"
+
+#include <iostream>
+
+namespace pong
+{
+    bool LoopbackTransport::Connect(const std::string &url, ReceiveCallback onReceive, void *userData)
+    {
+        LoopbackServer::Config config;
+        config.protocolVersion = uint32_t(GetUrlParameter(url, "proto", float(config.protocolVersion)));
+        config.tickRate = GetUrlParameter(url, "rate", config.tickRate);
+        if (config.tickRate <= 0.0f)
+        {
+            std::cerr << "Invalid loopback tick rate in " << url << std::endl;
+            return false;
+        }
+
+        m_server.Initialize(config);
+        m_onReceive = onReceive;
+        m_userData = userData;
+        m_lastPoll = std::chrono::steady_clock::now();
+        m_open = true;
+        std::cout << "onopen: " << url << std::endl;
+        return true;
+    }
+
+    bool LoopbackTransport::Send(const uint8_t *data, size_t size)
+    {
+        if (!m_open)
+        {
+            return false;
+        }
+
+        m_server.Receive(data, size);
+        return true;
+    }
+
+    void LoopbackTransport::Poll()
+    {
+        if (!m_open)
+        {
+            return;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        const float deltaTime = std::chrono::duration<float>(now - m_lastPoll).count();
+        m_lastPoll = now;
+
+        m_server.Update(deltaTime, m_onReceive, m_userData);
+    }
+}
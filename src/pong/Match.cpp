@@ -0,0 +1,474 @@
+#include "pong/Match.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <iostream>
+
+namespace pong
+{
+    bool CTrajectory::Update(glm::vec2 position, glm::vec2 velocity)
+    {
+        const bool isMovingRight = velocity.x > 0.0f;
+        const bool hasBounced = isMovingRight ? position.x > c_arenaWidth * c_tabelHitLocation : position.x < c_arenaWidth * (1.0f - c_tabelHitLocation);
+        const bool hitTable = hasBounced && !bounced;
+
+        if (!valid || hasBounced != bounced || velocity.x != velocityX)
+        {
+            Fit(hasBounced, velocity.x);
+        }
+
+        bounced = hasBounced;
+        return hitTable;
+    }
+
+    void CTrajectory::Fit(bool hasBounced, float vx)
+    {
+        const float c_lowerTarget = c_ballRadius;
+        const float c_g = 9.82f;
+        const bool isMovingRight = vx > 0.0f;
+
+        const float xorigin = hasBounced ? c_arenaWidth * c_tabelHitLocation : 0.0f;
+        const float x0 = (isMovingRight ? xorigin : c_arenaWidth - xorigin);
+        const float xtarget = hasBounced ? c_arenaWidth : c_arenaWidth * c_tabelHitLocation;
+        const float x1 = (isMovingRight ? xtarget : c_arenaWidth - xtarget);
+
+        const float y0 = hasBounced ? c_lowerTarget : c_padelTableHitOffset;
+        const float y1 = hasBounced ? c_padelTableHitOffset : c_lowerTarget;
+
+        // height = y0 + slope * dx - g / (2 vx^2) * dx^2, with the slope chosen so the parabola ends at (x1, y1)
+        origin = x0;
+        c0 = y0;
+        if (vx != 0.0f)
+        {
+            const float curvature = c_g / (2.0f * vx * vx);
+            const float dx = x1 - x0;
+            c1 = (y1 - y0 + curvature * dx * dx) / dx;
+            c2 = -curvature;
+        }
+        else
+        {
+            c1 = 0.0f;
+            c2 = 0.0f;
+        }
+
+        velocityX = vx;
+        valid = true;
+        fits++;
+    }
+
+    uint32_t EPlayers::Add(uint32_t playerId, const glm::vec3 &position, TextCache::Handle scoreText)
+    {
+        const uint32_t player = index.Add(playerId);
+        if (player == EntityIndex<c_capacity>::c_invalid)
+        {
+            return player;
+        }
+
+        transforms[player] = {};
+        transforms[player].position = position;
+        previousTransforms[player] = transforms[player];
+        targetAngles[player] = 90.0f;
+        currentAngles[player] = 0.0f;
+        previousAngles[player] = 0.0f;
+        scores[player] = 0;
+        scoreTexts[player] = scoreText;
+        return player;
+    }
+
+    void EPlayers::Remove(uint32_t player)
+    {
+        const uint32_t moved = index.Remove(player);
+        transforms[player] = transforms[moved];
+        previousTransforms[player] = previousTransforms[moved];
+        targetAngles[player] = targetAngles[moved];
+        currentAngles[player] = currentAngles[moved];
+        previousAngles[player] = previousAngles[moved];
+        scores[player] = scores[moved];
+        scoreTexts[player] = scoreTexts[moved];
+    }
+
+    void Match::Initialize(Connection &connection, const MatchResources &resources, const glm::vec3 &origin, bool controlled, uint32_t seed)
+    {
+        m_connection = &connection;
+        m_resources = resources;
+        m_origin = origin;
+        m_controlled = controlled;
+        m_random.seed(seed);
+
+        TextCache &text = *m_resources.text;
+        glm::vec3 baseTextPosition = m_origin + glm::vec3(c_arenaWidth / 2.0f, 30.0f, -c_arenaHeight / 8.0f);
+        glm::vec2 baseTextScale = glm::vec2(0.5f, -0.5f);
+        m_waitingText = text.Create("Waiting for opponent", baseTextPosition, baseTextScale);
+        m_gameOverText = text.Create("Game over", baseTextPosition, baseTextScale * 2.0f);
+        m_startingText = text.Create("Starting", baseTextPosition, baseTextScale * 2.0f);
+
+        m_audioEvents = connection.GetEvents().CreateCursor();
+        m_cameraEvents = connection.GetEvents().CreateCursor();
+
+        // Snapshots are played back on the server's timeline, spaced by its step, and our paddle moves by
+        // its rules. Both are in server units.
+        const Simulation::Config rules;
+        m_interpolator.Initialize(rules.tickRate);
+        m_predictor.Initialize(rules);
+
+        BallExtrapolator::Config extrapolation;
+        extrapolation.arenaWidth = c_arenaWidth / c_scaleFactor.x;
+        extrapolation.arenaHeight = c_arenaHeight / c_scaleFactor.y;
+        extrapolation.ballRadius = c_ballRadius / c_scaleFactor.x;
+        m_ballExtrapolator.Initialize(extrapolation);
+    }
+
+    void Match::Terminate()
+    {
+        if (m_resources.text == nullptr)
+        {
+            return;
+        }
+
+        TextCache &text = *m_resources.text;
+        for (uint32_t player = 0; player < m_players.size(); player++)
+        {
+            text.Destroy(m_players.scoreTexts[player]);
+        }
+        text.Destroy(m_waitingText);
+        text.Destroy(m_gameOverText);
+        text.Destroy(m_startingText);
+        m_resources.text = nullptr;
+    }
+
+    void Match::ScheduleEventSound(const GameEvent &event, double time)
+    {
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+        ScheduledSound scheduled;
+        switch (event.GetType())
+        {
+        case EventType::Smash:
+            scheduled.sound = m_resources.smashSound;
+            break;
+        case EventType::PlayerHit:
+            scheduled.sound = m_resources.racketSound;
+            break;
+        case EventType::Hit:
+        case EventType::TableBounce:
+            scheduled.sound = m_resources.hitSound;
+            scheduled.pitch = 1.0f + (glm::abs(dist(m_random)) * 0.15f);
+            break;
+        case EventType::NewRound:
+            return;
+        }
+
+        if (scheduled.sound == nullptr)
+        {
+            return;
+        }
+
+        const glm::vec2 position = event.GetPosition() * c_scaleFactor;
+        scheduled.position = m_origin + glm::vec3(position.x, c_padelTableHitOffset, position.y);
+        scheduled.time = time;
+        ScheduleSound(scheduled);
+    }
+
+    void Match::ScheduleSound(const ScheduledSound &scheduled)
+    {
+        // Updates run off the main thread where audio can not be played, with no room left the sound is dropped
+        if (!m_scheduledSounds.push_back(scheduled))
+        {
+            std::cerr << "Dropped a sound, too many scheduled" << std::endl;
+        }
+    }
+
+    void Match::PlaySounds()
+    {
+        const double now = m_connection->GetTime();
+        size_t kept = 0;
+        for (size_t i = 0; i < m_scheduledSounds.size(); i++)
+        {
+            const ScheduledSound &scheduled = m_scheduledSounds[i];
+            if (scheduled.time > now)
+            {
+                m_scheduledSounds[kept++] = scheduled;
+            }
+            else if (scheduled.sound != nullptr)
+            {
+                scheduled.sound->PlayAt(scheduled.position, scheduled.volume, scheduled.pitch);
+            }
+        }
+        m_scheduledSounds.resize(kept);
+    }
+
+    void Match::Update(float deltaTime)
+    {
+        // Keep the state of the previous step around for render interpolation
+        m_ball.previousTransform = m_ball.transform;
+        std::copy_n(m_players.transforms.begin(), m_players.size(), m_players.previousTransforms.begin());
+        std::copy_n(m_players.currentAngles.begin(), m_players.size(), m_players.previousAngles.begin());
+
+        Connection &connection = *m_connection;
+        TextCache &text = *m_resources.text;
+        GameStateMessage *msg = connection.GetLatestMessage();
+
+        // Visual systems keep running between packets, only the authoritative state waits for a new message
+        const bool hasMessage = msg != nullptr && !msg->handeled;
+
+        if (hasMessage)
+        {
+            m_playerId = msg->head.playerId;
+            m_state = msg->state;
+            m_tick = msg->tick;
+        }
+
+        // Entity positions are played back from the snapshot history, slightly behind the newest snapshot
+        const double now = connection.GetTime();
+        const SnapshotInterpolator::Sample &sample = m_interpolator.Update(connection.GetMessages(), now, deltaTime);
+
+        // Our own paddle is predicted from local input instead, and reconciled with every new snapshot
+        bool reconciled = false;
+        if (hasMessage)
+        {
+            for (auto &&msgPlayer : msg->players)
+            {
+                if (msgPlayer.playerId == msg->head.playerId)
+                {
+                    if (m_controlled)
+                    {
+                        m_predictor.Reconcile(msgPlayer.position.y, msg->head.sequenceNumber, msg->receiveTime, connection.GetClockStats().roundTrip, connection.GetPendingInputs(), now);
+                        reconciled = true;
+                    }
+                    connection.AcknowledgeInput(msg->head.sequenceNumber);
+                }
+            }
+        }
+
+        if (m_controlled && !reconciled)
+        {
+            m_predictor.Step(connection.GetInputState(), deltaTime);
+        }
+        else if (reconciled)
+        {
+            m_predictor.Blend(deltaTime);
+        }
+
+        // Update ball
+        if (hasMessage)
+        {
+            m_ball.velocity = glm::vec3(msg->ball.velocity.x * c_scaleFactor.x, 0.0f, msg->ball.velocity.y * c_scaleFactor.y);
+        }
+        glm::vec2 ballVelocity = glm::vec2(m_ball.velocity.x, m_ball.velocity.z);
+
+        // We simulate the ball on the client if we are in between rounds or game over
+        const bool simulateBall = m_state == GameState::InBetweenRounds || m_state == GameState::GameOver;
+        glm::vec2 ballPosition = glm::vec2(m_ball.transform.position.x, m_ball.transform.position.z);
+        if (simulateBall)
+        {
+            ballPosition += ballVelocity * deltaTime;
+            m_ballExtrapolator.Reset();
+        }
+        else if (sample.valid)
+        {
+            // While snapshots are late the ball keeps flying, its height follows from the extrapolated velocity
+            const Ball &ball = m_ballExtrapolator.Update(sample.ball, sample.extrapolated, deltaTime);
+            ballPosition = ball.position * c_scaleFactor;
+            ballVelocity = ball.velocity * c_scaleFactor;
+            m_ball.velocity = glm::vec3(ballVelocity.x, 0.0f, ballVelocity.y);
+        }
+
+        const bool hasHitTable = m_ball.trajectory.Update(ballPosition, ballVelocity);
+        m_ball.transform.position = glm::vec3(ballPosition.x, m_ball.trajectory.GetHeight(ballPosition.x), ballPosition.y);
+        if (hasHitTable)
+        {
+            connection.GetEvents().Push(EventType::TableBounce, EventSource::Client, m_tick, ballPosition / c_scaleFactor, now);
+        }
+
+        // Update players
+        if (hasMessage)
+        {
+            // Players missing from the message are removed after the loop
+            m_players.index.BeginSync();
+            for (auto &&msgPlayer : msg->players)
+            {
+                uint32_t player = m_players.index.Find(msgPlayer.playerId);
+                if (player == EntityIndex<EPlayers::c_capacity>::c_invalid)
+                {
+                    glm::vec3 newPlayerPos = glm::vec3(msgPlayer.position.x * c_scaleFactor.x, c_padelTableHitOffset, msgPlayer.position.y * c_scaleFactor.y);
+                    player = m_players.Add(msgPlayer.playerId, newPlayerPos, text.Create());
+                    if (player == EntityIndex<EPlayers::c_capacity>::c_invalid)
+                    {
+                        continue;
+                    }
+                }
+                m_players.index.Mark(player);
+
+                // Check if player has higher score, only the match we play in cheers
+                if (m_controlled && msgPlayer.score > m_players.scores[player])
+                {
+                    ScheduledSound scheduled;
+                    scheduled.sound = msgPlayer.playerId == msg->head.playerId ? m_resources.winSound : m_resources.loseSound;
+                    scheduled.position = m_origin + m_ball.transform.position;
+                    scheduled.volume = 250.0f;
+                    scheduled.time = now;
+                    if (scheduled.sound != nullptr)
+                    {
+                        ScheduleSound(scheduled);
+                    }
+                }
+
+                m_players.scores[player] = msgPlayer.score;
+            }
+
+            // Back to front, removing swaps the last player into the hole
+            for (uint32_t player = m_players.size(); player > 0; player--)
+            {
+                if (!m_players.index.IsSeen(player - 1))
+                {
+                    text.Destroy(m_players.scoreTexts[player - 1]);
+                    m_players.Remove(player - 1);
+                }
+            }
+
+            msg->handeled = true;
+        }
+
+        for (auto &&samplePlayer : sample.players)
+        {
+            const uint32_t player = m_players.index.Find(samplePlayer.playerId);
+            if (player == EntityIndex<EPlayers::c_capacity>::c_invalid)
+            {
+                continue;
+            }
+
+            CTransform &transform = m_players.transforms[player];
+            const bool predicted = m_controlled && samplePlayer.playerId == m_playerId && m_predictor.IsActive();
+            const float positionY = predicted ? m_predictor.GetPosition() : samplePlayer.position.y;
+            glm::vec3 newPlayerPos = glm::vec3(samplePlayer.position.x * c_scaleFactor.x, c_padelTableHitOffset, positionY * c_scaleFactor.y);
+
+            if (glm::abs(newPlayerPos.z - transform.position.z) > glm::epsilon<float>())
+            {
+                float targetAngle = 0.0f;
+                bool isOrientedUp = newPlayerPos.z > transform.position.z;
+                targetAngle = isOrientedUp ? -75.0f : 75.0f;
+                m_players.targetAngles[player] = targetAngle;
+            }
+
+            transform.position = newPlayerPos;
+        }
+
+        for (uint32_t player = 0; player < m_players.size(); player++)
+        {
+            m_players.currentAngles[player] += (m_players.targetAngles[player] - m_players.currentAngles[player]) * 5.0f * deltaTime;
+        }
+
+        // Server events play when the interpolated ball gets to them, client ones are already on the rendered state
+        EventJournal &events = connection.GetEvents();
+        GameEvent event;
+        while (events.Next(m_audioEvents, event))
+        {
+            const bool delayed = event.GetSource() == EventSource::Server;
+            ScheduleEventSound(event, delayed ? event.time + m_interpolator.GetStats().interpDelay : event.time);
+        }
+    }
+
+    bool Match::ReadCameraEvents(float &trauma)
+    {
+        bool hasImpact = false;
+        GameEvent event;
+        while (m_connection->GetEvents().Next(m_cameraEvents, event))
+        {
+            switch (event.GetType())
+            {
+            case EventType::Smash:
+                trauma = glm::max(trauma, 0.6f);
+                break;
+            case EventType::PlayerHit:
+                trauma = glm::max(trauma, 0.3f);
+                break;
+            case EventType::NewRound:
+                continue;
+            default:
+                break;
+            }
+            hasImpact = true;
+        }
+        return hasImpact;
+    }
+
+    void Match::Extract(MatchRenderBatch &batch, uint32_t slot, uint32_t firstPaddle, float alpha)
+    {
+        static const glm::mat4 ballRenderTransformOffset = glm::translate(glm::mat4(1.0f), glm::vec3(-c_ballRadius, 0.0f, -c_ballRadius)) * glm::scale(glm::mat4(1.0f), glm::vec3(1.3f));
+        const glm::vec3 paddelRenderOffset = glm::vec3(-c_padelWidth / 2.0f, 0.0f, c_padelHeight / 2.0f);
+        TextCache &text = *m_resources.text;
+
+        for (uint32_t i = 0; i < m_players.size(); i++)
+        {
+            // Player, interpolated between the last two simulation steps. The render offset and tilt
+            // are folded into one position and rotation so the batch kernel builds the matrix.
+            float angle = glm::mix(m_players.previousAngles[i], m_players.currentAngles[i], alpha);
+            CTransform transform = CTransform::Interpolate(m_players.previousTransforms[i], m_players.transforms[i], alpha);
+            glm::vec3 position = m_origin + transform.position + transform.rotation * paddelRenderOffset;
+            glm::quat rotation = transform.rotation * glm::quat(glm::vec3(0.0f, glm::radians(angle), glm::radians(90.0f)));
+
+            const uint32_t paddle = firstPaddle + i;
+            batch.paddles.positionX[paddle] = position.x;
+            batch.paddles.positionY[paddle] = position.y;
+            batch.paddles.positionZ[paddle] = position.z;
+            batch.paddles.rotationX[paddle] = rotation.x;
+            batch.paddles.rotationY[paddle] = rotation.y;
+            batch.paddles.rotationZ[paddle] = rotation.z;
+            batch.paddles.rotationW[paddle] = rotation.w;
+
+            // Score
+            float xOffset = (m_players.transforms[i].position.x < c_arenaWidth / 2.0f ? -1.0f : 1.0f) * c_arenaWidth / 4.0f;
+            std::array<char, 16> scoreBuffer;
+            auto [scoreEnd, error] = std::to_chars(scoreBuffer.data(), scoreBuffer.data() + scoreBuffer.size(), m_players.scores[i]);
+            text.Set(m_players.scoreTexts[i],
+                     std::string_view(scoreBuffer.data(), scoreEnd - scoreBuffer.data()),
+                     m_origin + glm::vec3(c_arenaWidth / 2.0f + xOffset, 0.0f, c_arenaHeight / 6.0f),
+                     glm::vec2(1.0f, -1.0f));
+        }
+
+        CTransform table = m_table.transform;
+        table.position += m_origin;
+        batch.tables[slot] = table.GetMatrix();
+
+        CTransform ball = CTransform::Interpolate(m_ball.previousTransform, m_ball.transform, alpha);
+        ball.position += m_origin;
+        batch.balls[slot] = ball.GetMatrix() * ballRenderTransformOffset;
+    }
+
+    void Match::SetTextVisible(bool visible)
+    {
+        TextCache &text = *m_resources.text;
+        for (uint32_t player = 0; player < m_players.size(); player++)
+        {
+            text.SetVisible(m_players.scoreTexts[player], visible);
+        }
+        text.SetVisible(m_waitingText, visible && m_state == GameState::WaitingForPlayers);
+        text.SetVisible(m_gameOverText, visible && m_state == GameState::GameOver);
+        text.SetVisible(m_startingText, visible && m_state == GameState::Starting);
+    }
+
+    BotObservation Match::Observe() const
+    {
+        BotObservation observation;
+        const uint32_t player = m_players.index.Find(m_playerId);
+        if (player == EntityIndex<EPlayers::c_capacity>::c_invalid)
+        {
+            return observation;
+        }
+
+        const glm::vec3 &paddle = m_players.transforms[player].position;
+        observation.paddle = glm::vec2(paddle.x, paddle.z) / c_scaleFactor;
+        observation.ball.position = glm::vec2(m_ball.transform.position.x, m_ball.transform.position.z) / c_scaleFactor;
+        observation.ball.velocity = glm::vec2(m_ball.velocity.x, m_ball.velocity.z) / c_scaleFactor;
+        observation.valid = true;
+        return observation;
+    }
+
+    void Match::GetBounds(glm::vec3 &min, glm::vec3 &max) const
+    {
+        // Generous around the arena, the table model and the score text reach past it
+        min = m_origin + glm::vec3(-c_arenaWidth * 0.25f, -80.0f, -c_arenaHeight * 0.25f);
+        max = m_origin + glm::vec3(c_arenaWidth * 1.25f, c_padelTableHitOffset + c_padelHeight, c_arenaHeight * 1.25f);
+    }
+}
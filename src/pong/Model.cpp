@@ -9,14 +9,14 @@
 
 namespace pong
 {
-    std::unique_ptr<Model> Model::Create(const wgpu::Device &device, const wgpu::Queue &queue, const std::string &path)
+    bool Model::Load(const std::string &path, Data &data)
     {
         std::ifstream file(path, std::ios::binary);
 
         if (!file.is_open())
         {
             std::cout << "Failed to open file: " << path << std::endl;
-            return nullptr;
+            return false;
         }
 
         static_assert(sizeof(Vertex) == 9 * sizeof(float), "Vertex size is not 9 floats");
@@ -25,39 +25,53 @@ namespace pong
         uint32_t vertexCount = 0;
         file.read(reinterpret_cast<char *>(&vertexCount), sizeof(vertexCount));
         std::cout << "Vertex count: " << vertexCount << std::endl;
-        std::vector<Vertex> vertexData(vertexCount);
-        file.read(reinterpret_cast<char *>(vertexData.data()), vertexCount * sizeof(Vertex));
+        data.vertices.resize(vertexCount);
+        file.read(reinterpret_cast<char *>(data.vertices.data()), vertexCount * sizeof(Vertex));
 
         // Read index data
         uint32_t indexCount = 0;
         file.read(reinterpret_cast<char *>(&indexCount), sizeof(indexCount));
         std::cout << "Index count: " << indexCount << std::endl;
-        std::vector<uint32_t> indexData(indexCount);
-        file.read(reinterpret_cast<char *>(indexData.data()), indexCount * sizeof(uint32_t));
+        data.indices.resize(indexCount);
+        file.read(reinterpret_cast<char *>(data.indices.data()), indexCount * sizeof(uint32_t));
 
         file.close();
+        return true;
+    }
 
+    std::unique_ptr<Model> Model::Create(const wgpu::Device &device, const wgpu::Queue &queue, const Data &data)
+    {
         // Create vertex buffer
         wgpu::BufferDescriptor bufferDesc;
-        bufferDesc.size = vertexData.size() * sizeof(Vertex);
+        bufferDesc.size = data.vertices.size() * sizeof(Vertex);
         bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Vertex;
         bufferDesc.mappedAtCreation = false;
         wgpu::Buffer vertexBuffer = device.CreateBuffer(&bufferDesc);
 
-        queue.WriteBuffer(vertexBuffer, 0, vertexData.data(), bufferDesc.size);
+        queue.WriteBuffer(vertexBuffer, 0, data.vertices.data(), bufferDesc.size);
 
-        bufferDesc.size = indexData.size() * sizeof(uint32_t);
+        bufferDesc.size = data.indices.size() * sizeof(uint32_t);
         bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Index;
         wgpu::Buffer indexBuffer = device.CreateBuffer(&bufferDesc);
 
         // Upload geometry data to the buffer
-        queue.WriteBuffer(indexBuffer, 0, indexData.data(), bufferDesc.size);
+        queue.WriteBuffer(indexBuffer, 0, data.indices.data(), bufferDesc.size);
 
         return std::make_unique<Model>(
             vertexBuffer,
-            vertexCount,
+            data.vertices.size(),
             indexBuffer,
-            indexCount);
+            data.indices.size());
+    }
+
+    std::unique_ptr<Model> Model::Create(const wgpu::Device &device, const wgpu::Queue &queue, const std::string &path)
+    {
+        Data data;
+        if (!Load(path, data))
+        {
+            return nullptr;
+        }
+        return Create(device, queue, data);
     }
 
     std::unique_ptr<Model> Model::CreateQuad(const wgpu::Device &device, const wgpu::Queue &queue, const glm::vec2 &size, const glm::vec3 &color)
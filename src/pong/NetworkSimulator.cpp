@@ -0,0 +1,454 @@
+#include "pong/NetworkSimulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace pong
+{
+    static constexpr double c_pi = 3.14159265358979323846;
+
+    bool LinkConditions::IsEnabled() const
+    {
+        return latency > 0.0f || jitter > 0.0f || loss > 0.0f || duplicate > 0.0f || reorder > 0.0f || bandwidth > 0.0f;
+    }
+
+    static LinkConditions MakeLink(float latencyMs, float jitterMs, LatencyDistribution distribution, float loss, float burstLength, float duplicate, float reorder, float bandwidthKbps)
+    {
+        LinkConditions link;
+        link.latency = latencyMs / 1000.0f;
+        link.jitter = jitterMs / 1000.0f;
+        link.distribution = distribution;
+        link.loss = loss;
+        link.burstLength = burstLength;
+        link.duplicate = duplicate;
+        link.reorder = reorder;
+        link.bandwidth = bandwidthKbps * 125.0f;
+        return link;
+    }
+
+    bool GetNetworkProfile(const std::string &name, NetworkConditions &conditions)
+    {
+        LinkConditions link;
+        if (name == "none")
+        {
+            link = {};
+        }
+        else if (name == "lan")
+        {
+            link = MakeLink(1.0f, 0.5f, LatencyDistribution::Normal, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f);
+        }
+        else if (name == "wifi")
+        {
+            link = MakeLink(10.0f, 5.0f, LatencyDistribution::Exponential, 0.005f, 2.0f, 0.0f, 0.0f, 0.0f);
+        }
+        else if (name == "mobile")
+        {
+            link = MakeLink(50.0f, 20.0f, LatencyDistribution::Exponential, 0.02f, 3.0f, 0.0f, 0.01f, 1000.0f);
+        }
+        else if (name == "lossy")
+        {
+            link = MakeLink(30.0f, 5.0f, LatencyDistribution::Normal, 0.1f, 4.0f, 0.02f, 0.02f, 0.0f);
+        }
+        else if (name == "awful")
+        {
+            link = MakeLink(150.0f, 60.0f, LatencyDistribution::Exponential, 0.05f, 5.0f, 0.05f, 0.05f, 64.0f);
+        }
+        else
+        {
+            return false;
+        }
+
+        conditions.profile = name;
+        conditions.up = link;
+        conditions.down = link;
+        return true;
+    }
+
+    static bool ParseFloat(const std::string &value, float &result)
+    {
+        char *end = nullptr;
+        result = std::strtof(value.c_str(), &end);
+        return end != value.c_str() && *end == '\0' && std::isfinite(result) && result >= 0.0f;
+    }
+
+    static bool SetLinkParameter(LinkConditions &link, const std::string &key, const std::string &value)
+    {
+        if (key == "distribution")
+        {
+            if (value == "uniform")
+            {
+                link.distribution = LatencyDistribution::Uniform;
+            }
+            else if (value == "normal")
+            {
+                link.distribution = LatencyDistribution::Normal;
+            }
+            else if (value == "exponential")
+            {
+                link.distribution = LatencyDistribution::Exponential;
+            }
+            else
+            {
+                return false;
+            }
+            return true;
+        }
+
+        float number = 0.0f;
+        if (!ParseFloat(value, number))
+        {
+            return false;
+        }
+
+        if (key == "latency")
+        {
+            link.latency = number / 1000.0f;
+        }
+        else if (key == "jitter")
+        {
+            link.jitter = number / 1000.0f;
+        }
+        else if (key == "loss")
+        {
+            link.loss = std::min(number, 1.0f);
+        }
+        else if (key == "burst")
+        {
+            link.burstLength = std::max(number, 1.0f);
+        }
+        else if (key == "duplicate")
+        {
+            link.duplicate = std::min(number, 1.0f);
+        }
+        else if (key == "reorder")
+        {
+            link.reorder = std::min(number, 1.0f);
+        }
+        else if (key == "reorder_delay")
+        {
+            link.reorderDelay = number / 1000.0f;
+        }
+        else if (key == "bandwidth")
+        {
+            link.bandwidth = number * 125.0f;
+        }
+        else if (key == "queue")
+        {
+            link.queueTime = number / 1000.0f;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    bool SetNetworkParameter(NetworkConditions &conditions, const std::string &key, const std::string &value)
+    {
+        bool valid = true;
+        if (key == "profile")
+        {
+            valid = GetNetworkProfile(value, conditions);
+        }
+        else if (key == "seed")
+        {
+            char *end = nullptr;
+            conditions.seed = uint32_t(std::strtoul(value.c_str(), &end, 10));
+            valid = end != value.c_str() && *end == '\0';
+        }
+        else if (key.rfind("up.", 0) == 0)
+        {
+            valid = SetLinkParameter(conditions.up, key.substr(3), value);
+        }
+        else if (key.rfind("down.", 0) == 0)
+        {
+            valid = SetLinkParameter(conditions.down, key.substr(5), value);
+        }
+        else
+        {
+            valid = SetLinkParameter(conditions.up, key, value) && SetLinkParameter(conditions.down, key, value);
+        }
+
+        if (!valid)
+        {
+            std::cerr << "Invalid network parameter " << key << "=" << value << std::endl;
+        }
+        return valid;
+    }
+
+    bool ParseNetworkConditionsUrl(const std::string &url, NetworkConditions &conditions)
+    {
+        const auto parameters = GetUrlParameters(url);
+
+        // The profile goes first so the order of the query does not matter
+        bool valid = true;
+        for (auto &&[key, value] : parameters)
+        {
+            if (key == "net")
+            {
+                valid = SetNetworkParameter(conditions, "profile", value) && valid;
+            }
+        }
+
+        const std::string prefix = "net.";
+        for (auto &&[key, value] : parameters)
+        {
+            if (key.rfind(prefix, 0) == 0)
+            {
+                valid = SetNetworkParameter(conditions, key.substr(prefix.size()), value) && valid;
+            }
+        }
+        return valid;
+    }
+
+    static std::string Trim(const std::string &text)
+    {
+        const size_t start = text.find_first_not_of(" \t\r");
+        const size_t end = text.find_last_not_of(" \t\r");
+        return start == std::string::npos ? "" : text.substr(start, end - start + 1);
+    }
+
+    bool LoadNetworkConditions(const std::string &path, NetworkConditions &conditions)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cerr << "Failed to open network conditions file " << path << std::endl;
+            return false;
+        }
+
+        bool valid = true;
+        std::string line;
+        for (uint32_t lineNumber = 1; std::getline(file, line); lineNumber++)
+        {
+            line = Trim(line.substr(0, line.find('#')));
+            if (line.empty())
+            {
+                continue;
+            }
+
+            const size_t equals = line.find('=');
+            if (equals == std::string::npos || !SetNetworkParameter(conditions, Trim(line.substr(0, equals)), Trim(line.substr(equals + 1))))
+            {
+                std::cerr << path << ":" << lineNumber << ": invalid line" << std::endl;
+                valid = false;
+            }
+        }
+        return valid;
+    }
+
+    void SimulatedLink::Initialize(const LinkConditions &conditions, uint64_t seed)
+    {
+        m_conditions = conditions;
+
+        // splitmix64 of the seed, xorshift64* after that. Written out rather than using <random> so
+        // every standard library produces the same sequence.
+        uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        m_random = (z ^ (z >> 31)) | 1;
+
+        m_inBurst = false;
+        m_queue.clear();
+        m_order = 0;
+        m_lastDelivery = 0.0;
+        m_linkFree = 0.0;
+        m_totalDelay = 0.0;
+        m_stats = {};
+    }
+
+    double SimulatedLink::NextRandom()
+    {
+        m_random ^= m_random >> 12;
+        m_random ^= m_random << 25;
+        m_random ^= m_random >> 27;
+        return double((m_random * 0x2545F4914F6CDD1Dull) >> 11) * 0x1.0p-53;
+    }
+
+    double SimulatedLink::SampleDelay()
+    {
+        const double latency = m_conditions.latency;
+        const double jitter = m_conditions.jitter;
+        double delay = latency;
+        switch (m_conditions.distribution)
+        {
+        case LatencyDistribution::Uniform:
+            delay += (2.0 * NextRandom() - 1.0) * jitter;
+            break;
+        case LatencyDistribution::Normal:
+        {
+            const double u = 1.0 - NextRandom();
+            const double v = NextRandom();
+            delay += std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * c_pi * v) * jitter;
+            break;
+        }
+        case LatencyDistribution::Exponential:
+            delay -= std::log(1.0 - NextRandom()) * jitter;
+            break;
+        }
+        return std::max(delay, 0.0);
+    }
+
+    bool SimulatedLink::SampleLoss()
+    {
+        const float loss = m_conditions.loss;
+        if (loss <= 0.0f)
+        {
+            return false;
+        }
+        if (loss >= 1.0f)
+        {
+            return true;
+        }
+
+        // Two state Gilbert model, every packet in the bad state is lost. Leaving it with probability
+        // 1 / burstLength and entering it as below keeps the average loss at the configured fraction.
+        const double burstLength = std::max(m_conditions.burstLength, 1.0f);
+        const double enter = loss / (burstLength * (1.0 - loss));
+        const double random = NextRandom();
+        m_inBurst = m_inBurst ? random >= 1.0 / burstLength : random < enter;
+        return m_inBurst;
+    }
+
+    bool SimulatedLink::DeliversAfter(const Packet &lhs, const Packet &rhs)
+    {
+        return lhs.deliveryTime != rhs.deliveryTime ? lhs.deliveryTime > rhs.deliveryTime : lhs.order > rhs.order;
+    }
+
+    void SimulatedLink::Enqueue(const uint8_t *data, size_t size, double sendTime, double deliveryTime)
+    {
+        Packet packet;
+        if (!m_freeBuffers.empty())
+        {
+            packet.data = std::move(m_freeBuffers.back());
+            m_freeBuffers.pop_back();
+        }
+        packet.data.assign(data, data + size);
+        packet.sendTime = sendTime;
+        packet.deliveryTime = deliveryTime;
+        packet.order = m_order++;
+
+        m_queue.push_back(std::move(packet));
+        std::push_heap(m_queue.begin(), m_queue.end(), DeliversAfter);
+        m_stats.queued = uint32_t(m_queue.size());
+    }
+
+    void SimulatedLink::Send(const uint8_t *data, size_t size, double now)
+    {
+        m_stats.packets++;
+        if (SampleLoss())
+        {
+            m_stats.lost++;
+            return;
+        }
+
+        // Packets are serialized one after another at the link bandwidth
+        double departure = now;
+        if (m_conditions.bandwidth > 0.0f)
+        {
+            const double start = std::max(now, m_linkFree);
+            if (start - now > m_conditions.queueTime)
+            {
+                m_stats.overflowed++;
+                return;
+            }
+            m_linkFree = start + size / double(m_conditions.bandwidth);
+            departure = m_linkFree;
+        }
+
+        // Jitter alone keeps the packet order, like a real link, only reordered packets are overtaken
+        double delivery = departure + SampleDelay();
+        if (m_conditions.reorder > 0.0f && NextRandom() < m_conditions.reorder)
+        {
+            delivery += m_conditions.reorderDelay;
+            m_stats.reordered++;
+        }
+        else
+        {
+            delivery = std::max(delivery, m_lastDelivery);
+            m_lastDelivery = delivery;
+        }
+        Enqueue(data, size, now, delivery);
+
+        if (m_conditions.duplicate > 0.0f && NextRandom() < m_conditions.duplicate)
+        {
+            Enqueue(data, size, now, std::max(departure + SampleDelay(), delivery));
+            m_stats.duplicated++;
+        }
+    }
+
+    void SimulatedLink::Deliver(double now, ITransport::ReceiveCallback onDeliver, void *userData)
+    {
+        while (!m_queue.empty() && m_queue.front().deliveryTime <= now)
+        {
+            std::pop_heap(m_queue.begin(), m_queue.end(), DeliversAfter);
+            Packet packet = std::move(m_queue.back());
+            m_queue.pop_back();
+
+            const double delay = packet.deliveryTime - packet.sendTime;
+            m_totalDelay += delay;
+            m_stats.delivered++;
+            m_stats.bytes += packet.data.size();
+            m_stats.averageDelay = float(m_totalDelay / m_stats.delivered);
+            m_stats.maxDelay = std::max(m_stats.maxDelay, float(delay));
+
+            if (onDeliver != nullptr)
+            {
+                onDeliver(packet.data.data(), packet.data.size(), userData);
+            }
+            m_freeBuffers.push_back(std::move(packet.data));
+        }
+        m_stats.queued = uint32_t(m_queue.size());
+    }
+
+    SimulatedTransport::SimulatedTransport(std::unique_ptr<ITransport> transport, const NetworkConditions &conditions)
+        : m_transport(std::move(transport)), m_conditions(conditions)
+    {
+    }
+
+    void SimulatedTransport::OnReceive(const uint8_t *data, size_t size, void *userData)
+    {
+        SimulatedTransport *transport = reinterpret_cast<SimulatedTransport *>(userData);
+        transport->m_down.Send(data, size, transport->GetTime());
+    }
+
+    void SimulatedTransport::OnSend(const uint8_t *data, size_t size, void *userData)
+    {
+        SimulatedTransport *transport = reinterpret_cast<SimulatedTransport *>(userData);
+        transport->m_transport->Send(data, size);
+    }
+
+    bool SimulatedTransport::Connect(const std::string &url, ReceiveCallback onReceive, void *userData)
+    {
+        m_onReceive = onReceive;
+        m_userData = userData;
+        m_up.Initialize(m_conditions.up, uint64_t(m_conditions.seed) * 2);
+        m_down.Initialize(m_conditions.down, uint64_t(m_conditions.seed) * 2 + 1);
+        return m_transport->Connect(url, OnReceive, this);
+    }
+
+    bool SimulatedTransport::Send(const uint8_t *data, size_t size)
+    {
+        if (!m_transport->IsOpen())
+        {
+            return false;
+        }
+
+        // Delivering right away keeps a link without delay from adding a frame of latency
+        m_up.Send(data, size, GetTime());
+        m_up.Deliver(GetTime(), OnSend, this);
+        return true;
+    }
+
+    void SimulatedTransport::Poll()
+    {
+        m_transport->Poll();
+
+        const double now = GetTime();
+        m_up.Deliver(now, OnSend, this);
+        m_down.Deliver(now, m_onReceive, m_userData);
+    }
+}
@@ -0,0 +1,105 @@
+#include "pong/PaddlePredictor.h"
+
+#include <glm/glm.hpp>
+
+namespace pong
+{
+    static double GetSendTime(const InputMessage &input)
+    {
+        return input.timestamp / 1000.0;
+    }
+
+    float PaddlePredictor::Direction(bool upPressed, bool downPressed) const
+    {
+        return (float(upPressed) - float(downPressed)) * m_upDirection;
+    }
+
+    void PaddlePredictor::Initialize(const Simulation::Config &rules)
+    {
+        m_minPosition = 0.0f;
+        m_maxPosition = rules.arenaHeight - rules.paddleHeight;
+        m_paddleSpeed = rules.paddleSpeed;
+        m_upDirection = rules.upDirection;
+        m_initialized = false;
+    }
+
+    void PaddlePredictor::Reconcile(float serverPosition, uint32_t acknowledged, double receiveTime, float roundTrip, const InputHistory &pendingInputs, double now)
+    {
+        m_stats.pendingInputs = uint32_t(pendingInputs.size());
+
+        // Inputs are ordered by sequence number, the first one is the acknowledged input if we still have it
+        const InputMessage *acknowledgedInput = nullptr;
+        for (size_t i = 0; i < pendingInputs.size(); i++)
+        {
+            if (pendingInputs[i].sequenceNumber == acknowledged)
+            {
+                acknowledgedInput = &pendingInputs[i];
+                break;
+            }
+        }
+
+        m_stats.roundTrip = roundTrip;
+
+        // The snapshot reflects the inputs we sent about one round trip before it arrived
+        double time = receiveTime - roundTrip;
+        if (acknowledgedInput != nullptr)
+        {
+            time = glm::max(time, GetSendTime(*acknowledgedInput));
+        }
+        time = glm::min(time, now);
+
+        // Replay every input over the time it was held
+        float position = serverPosition;
+        for (size_t i = 0; i < pendingInputs.size(); i++)
+        {
+            const InputMessage &input = pendingInputs[i];
+            if (input.sequenceNumber < acknowledged)
+            {
+                continue;
+            }
+
+            const double end = i + 1 < pendingInputs.size() ? GetSendTime(pendingInputs[i + 1]) : now;
+            const double start = glm::max(time, input.sequenceNumber == acknowledged ? time : GetSendTime(input));
+            if (end <= start)
+            {
+                continue;
+            }
+
+            position += Direction(input.upPressed, input.downPressed) * m_paddleSpeed * float(end - start);
+            position = glm::clamp(position, m_minPosition, m_maxPosition);
+        }
+
+        // Small mispredictions are blended out, large ones are snapped
+        const float error = m_predicted - position;
+        if (!m_initialized || glm::abs(error) > c_snapDistance)
+        {
+            m_correction = 0.0f;
+            m_stats.snaps += m_initialized ? 1 : 0;
+        }
+        else
+        {
+            m_correction += error;
+        }
+
+        m_stats.correction = error;
+        m_predicted = position;
+        m_initialized = true;
+    }
+
+    void PaddlePredictor::Step(const InputState &input, float deltaTime)
+    {
+        if (!m_initialized)
+        {
+            return;
+        }
+
+        m_predicted += Direction(input.upPressed, input.downPressed) * m_paddleSpeed * deltaTime;
+        m_predicted = glm::clamp(m_predicted, m_minPosition, m_maxPosition);
+        Blend(deltaTime);
+    }
+
+    void PaddlePredictor::Blend(float deltaTime)
+    {
+        m_correction *= glm::exp(-c_correctionRate * deltaTime);
+    }
+}
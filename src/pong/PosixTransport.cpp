@@ -0,0 +1,405 @@
+#include "pong/PosixTransport.h"
+
+#ifndef __EMSCRIPTEN__
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace pong
+{
+    enum Opcode : uint8_t
+    {
+        Continuation = 0x0,
+        Text = 0x1,
+        Binary = 0x2,
+        CloseFrame = 0x8,
+        Ping = 0x9,
+        Pong = 0xA,
+    };
+
+    static std::string Base64Encode(const uint8_t *data, size_t size)
+    {
+        static const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        std::string result;
+        for (size_t i = 0; i < size; i += 3)
+        {
+            const uint32_t n = uint32_t(data[i]) << 16 | (i + 1 < size ? uint32_t(data[i + 1]) << 8 : 0) | (i + 2 < size ? data[i + 2] : 0);
+            result += alphabet[(n >> 18) & 63];
+            result += alphabet[(n >> 12) & 63];
+            result += i + 1 < size ? alphabet[(n >> 6) & 63] : '=';
+            result += i + 2 < size ? alphabet[n & 63] : '=';
+        }
+        return result;
+    }
+
+    // Splits ws://host[:port][/path]
+    static bool ParseUrl(const std::string &url, std::string &host, std::string &port, std::string &path)
+    {
+        const std::string scheme = "ws://";
+        if (url.compare(0, scheme.size(), scheme) != 0)
+        {
+            return false;
+        }
+
+        const size_t hostStart = scheme.size();
+        const size_t pathStart = url.find('/', hostStart);
+        const std::string authority = url.substr(hostStart, pathStart == std::string::npos ? std::string::npos : pathStart - hostStart);
+        path = pathStart == std::string::npos ? "/" : url.substr(pathStart);
+
+        const size_t colon = authority.find(':');
+        host = authority.substr(0, colon);
+        port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+        return !host.empty();
+    }
+
+    bool PosixTransport::Connect(const std::string &url, ReceiveCallback onReceive, void *userData)
+    {
+        Close();
+
+        std::string host, port, path;
+        if (!ParseUrl(url, host, port, path))
+        {
+            std::cerr << "Unsupported url: " << url << std::endl;
+            return false;
+        }
+
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo *addresses = nullptr;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0 || addresses == nullptr)
+        {
+            std::cerr << "Failed to resolve " << host << std::endl;
+            return false;
+        }
+
+        m_socket = socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+        if (m_socket < 0)
+        {
+            freeaddrinfo(addresses);
+            std::cerr << "Failed to create socket: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL, 0) | O_NONBLOCK);
+
+        const int result = connect(m_socket, addresses->ai_addr, addresses->ai_addrlen);
+        freeaddrinfo(addresses);
+        if (result < 0 && errno != EINPROGRESS)
+        {
+            std::cerr << "Failed to connect to " << url << ": " << std::strerror(errno) << std::endl;
+            Close();
+            return false;
+        }
+
+        m_onReceive = onReceive;
+        m_userData = userData;
+        m_state = State::Connecting;
+        m_random.seed(std::random_device()());
+
+        // The upgrade request goes out as soon as the connection is established
+        uint8_t key[16];
+        for (auto &&byte : key)
+        {
+            byte = uint8_t(m_random());
+        }
+
+        const std::string request = "GET " + path + " HTTP/1.1\r\n"
+                                    "Host: " + host + ":" + port + "\r\n"
+                                    "Upgrade: websocket\r\n"
+                                    "Connection: Upgrade\r\n"
+                                    "Sec-WebSocket-Key: " + Base64Encode(key, sizeof(key)) + "\r\n"
+                                    "Sec-WebSocket-Version: 13\r\n\r\n";
+        m_sendBuffer.assign(request.begin(), request.end());
+        return true;
+    }
+
+    void PosixTransport::Close()
+    {
+        if (m_socket >= 0)
+        {
+            close(m_socket);
+            m_socket = -1;
+        }
+
+        m_state = State::Closed;
+        m_sendBuffer.clear();
+        m_receiveBuffer.clear();
+        m_message.clear();
+    }
+
+    bool PosixTransport::Send(const uint8_t *data, size_t size)
+    {
+        if (m_state != State::Open)
+        {
+            return false;
+        }
+
+        QueueFrame(Binary, data, size);
+        return Flush();
+    }
+
+    void PosixTransport::Poll()
+    {
+        if (m_state == State::Closed)
+        {
+            return;
+        }
+
+        if (m_state == State::Connecting)
+        {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (getsockopt(m_socket, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || (error != 0 && error != EINPROGRESS))
+            {
+                std::cerr << "Connection failed: " << std::strerror(error) << std::endl;
+                Close();
+                return;
+            }
+            m_state = State::Handshake;
+        }
+
+        if (!Flush() || !ReadAvailable())
+        {
+            Close();
+            return;
+        }
+
+        if (m_state == State::Handshake && !ProcessHandshake())
+        {
+            Close();
+            return;
+        }
+
+        if (m_state == State::Open && !ProcessFrames())
+        {
+            Close();
+        }
+    }
+
+    bool PosixTransport::Flush()
+    {
+        size_t sent = 0;
+        while (sent < m_sendBuffer.size())
+        {
+#ifdef MSG_NOSIGNAL
+            const ssize_t result = send(m_socket, m_sendBuffer.data() + sent, m_sendBuffer.size() - sent, MSG_NOSIGNAL);
+#else
+            const ssize_t result = send(m_socket, m_sendBuffer.data() + sent, m_sendBuffer.size() - sent, 0);
+#endif
+            if (result < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOTCONN)
+                {
+                    break;
+                }
+                std::cerr << "Send failed: " << std::strerror(errno) << std::endl;
+                return false;
+            }
+            sent += size_t(result);
+        }
+
+        m_sendBuffer.erase(m_sendBuffer.begin(), m_sendBuffer.begin() + sent);
+        return true;
+    }
+
+    bool PosixTransport::ReadAvailable()
+    {
+        uint8_t buffer[c_readSize];
+        while (true)
+        {
+            const ssize_t result = recv(m_socket, buffer, sizeof(buffer), 0);
+            if (result > 0)
+            {
+                m_receiveBuffer.insert(m_receiveBuffer.end(), buffer, buffer + result);
+                continue;
+            }
+
+            if (result == 0)
+            {
+                std::cout << "Connection closed by server" << std::endl;
+                return false;
+            }
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOTCONN)
+            {
+                return true;
+            }
+
+            std::cerr << "Receive failed: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    bool PosixTransport::ProcessHandshake()
+    {
+        const char *end = "\r\n\r\n";
+        auto it = std::search(m_receiveBuffer.begin(), m_receiveBuffer.end(), end, end + 4);
+        if (it == m_receiveBuffer.end())
+        {
+            return m_receiveBuffer.size() < c_readSize;
+        }
+
+        // Sec-WebSocket-Accept is not verified, the server is trusted
+        const std::string response(m_receiveBuffer.begin(), it);
+        if (response.compare(0, 12, "HTTP/1.1 101") != 0)
+        {
+            std::cerr << "WebSocket upgrade rejected: " << response.substr(0, response.find('\r')) << std::endl;
+            return false;
+        }
+
+        m_receiveBuffer.erase(m_receiveBuffer.begin(), it + 4);
+        m_state = State::Open;
+        std::cout << "onopen" << std::endl;
+        return true;
+    }
+
+    bool PosixTransport::ProcessFrames()
+    {
+        size_t offset = 0;
+        while (m_receiveBuffer.size() - offset >= 2)
+        {
+            const uint8_t *frame = m_receiveBuffer.data() + offset;
+            const size_t available = m_receiveBuffer.size() - offset;
+
+            const bool fin = frame[0] & 0x80;
+            const uint8_t opcode = frame[0] & 0x0F;
+            const bool masked = frame[1] & 0x80;
+
+            size_t headerSize = 2;
+            uint64_t payloadSize = frame[1] & 0x7F;
+            if (payloadSize == 126)
+            {
+                headerSize += 2;
+                if (available < headerSize)
+                {
+                    break;
+                }
+                payloadSize = uint64_t(frame[2]) << 8 | frame[3];
+            }
+            else if (payloadSize == 127)
+            {
+                headerSize += 8;
+                if (available < headerSize)
+                {
+                    break;
+                }
+                payloadSize = 0;
+                for (uint32_t i = 0; i < 8; i++)
+                {
+                    payloadSize = payloadSize << 8 | frame[2 + i];
+                }
+            }
+
+            if (payloadSize > c_maxMessageSize || m_message.size() + payloadSize > c_maxMessageSize)
+            {
+                std::cerr << "WebSocket message too large" << std::endl;
+                return false;
+            }
+
+            const size_t maskOffset = headerSize;
+            headerSize += masked ? 4 : 0;
+            if (available < headerSize + payloadSize)
+            {
+                break;
+            }
+
+            uint8_t *payload = m_receiveBuffer.data() + offset + headerSize;
+            if (masked)
+            {
+                for (size_t i = 0; i < payloadSize; i++)
+                {
+                    payload[i] ^= frame[maskOffset + (i & 3)];
+                }
+            }
+            offset += headerSize + payloadSize;
+
+            switch (opcode)
+            {
+            case Text:
+            case Binary:
+            case Continuation:
+                if (fin && m_message.empty())
+                {
+                    // Unfragmented messages are delivered straight from the receive buffer
+                    if (m_onReceive != nullptr)
+                    {
+                        m_onReceive(payload, payloadSize, m_userData);
+                    }
+                }
+                else
+                {
+                    m_message.insert(m_message.end(), payload, payload + payloadSize);
+                    if (fin)
+                    {
+                        if (m_onReceive != nullptr)
+                        {
+                            m_onReceive(m_message.data(), m_message.size(), m_userData);
+                        }
+                        m_message.clear();
+                    }
+                }
+                break;
+            case Ping:
+                QueueFrame(Pong, payload, payloadSize);
+                break;
+            case CloseFrame:
+                QueueFrame(CloseFrame, payload, payloadSize < 2 ? payloadSize : 2);
+                Flush();
+                std::cout << "onclose" << std::endl;
+                return false;
+            default:
+                break;
+            }
+        }
+
+        m_receiveBuffer.erase(m_receiveBuffer.begin(), m_receiveBuffer.begin() + offset);
+        return Flush();
+    }
+
+    void PosixTransport::QueueFrame(uint8_t opcode, const uint8_t *data, size_t size)
+    {
+        // Client frames are always masked
+        m_sendBuffer.push_back(0x80 | opcode);
+        if (size < 126)
+        {
+            m_sendBuffer.push_back(0x80 | uint8_t(size));
+        }
+        else if (size <= 0xFFFF)
+        {
+            m_sendBuffer.push_back(0x80 | 126);
+            m_sendBuffer.push_back(uint8_t(size >> 8));
+            m_sendBuffer.push_back(uint8_t(size));
+        }
+        else
+        {
+            m_sendBuffer.push_back(0x80 | 127);
+            for (int32_t i = 7; i >= 0; i--)
+            {
+                m_sendBuffer.push_back(uint8_t(uint64_t(size) >> (8 * i)));
+            }
+        }
+
+        const uint32_t maskKey = m_random();
+        uint8_t mask[4];
+        std::memcpy(mask, &maskKey, sizeof(mask));
+        m_sendBuffer.insert(m_sendBuffer.end(), mask, mask + 4);
+
+        for (size_t i = 0; i < size; i++)
+        {
+            m_sendBuffer.push_back(data[i] ^ mask[i & 3]);
+        }
+    }
+}
+
+#endif
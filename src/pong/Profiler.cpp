@@ -0,0 +1,77 @@
+#include "pong/Profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+namespace pong
+{
+    void Profiler::Initialize(uint32_t threadCount)
+    {
+        m_slots = std::vector<Slot>(threadCount);
+        Reset();
+    }
+
+    void Profiler::Add(std::vector<Entry> &entries, const Entry &entry)
+    {
+        // A handful of task names, a linear search beats hashing
+        auto it = std::find_if(entries.begin(), entries.end(), [&](const Entry &other)
+                               { return other.name == entry.name; });
+        if (it == entries.end())
+        {
+            entries.push_back(entry);
+            return;
+        }
+
+        it->count += entry.count;
+        it->totalTime += entry.totalTime;
+        it->maxTime = std::max(it->maxTime, entry.maxTime);
+    }
+
+    void Profiler::Record(uint32_t thread, const char *name, float time)
+    {
+        if (thread >= m_slots.size())
+        {
+            return;
+        }
+
+        Add(m_slots[thread].entries, {name, 1, time, time});
+    }
+
+    void Profiler::EndFrame()
+    {
+        for (auto &&slot : m_slots)
+        {
+            for (auto &&entry : slot.entries)
+            {
+                Add(m_entries, entry);
+            }
+            // Keeps the capacity, recording stays free of allocations once every task has run
+            slot.entries.clear();
+        }
+        m_frames++;
+    }
+
+    void Profiler::Reset()
+    {
+        m_entries.clear();
+        m_frames = 0;
+    }
+
+    void Profiler::Print(std::ostream &out) const
+    {
+        const std::ios_base::fmtflags flags = out.flags();
+        const std::streamsize precision = out.precision();
+        out << "Profile over " << m_frames << " frames" << std::endl;
+        const float frames = float(std::max<uint32_t>(m_frames, 1));
+        for (auto &&entry : m_entries)
+        {
+            out << "  " << std::left << std::setw(24) << entry.name << std::right << std::fixed << std::setprecision(3)
+                << " tasks/frame " << std::setw(8) << float(entry.count) / frames
+                << " ms/frame " << std::setw(8) << entry.totalTime * 1000.0f / frames
+                << " max ms " << std::setw(8) << entry.maxTime * 1000.0f << std::endl;
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+}
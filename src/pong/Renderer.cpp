@@ -6,6 +6,7 @@
 #include <webgpu/webgpu_cpp.h>
 #include <emscripten/emscripten.h>
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <vector>
@@ -14,6 +15,7 @@ namespace pong
 {
     const char *shaderSource = R"(
     struct VertexInput {
+        @builtin(instance_index) instanceIndex: u32,
         @location(0) position: vec3f,
         @location(1) normal: vec3f,
         @location(2) color: vec3f,
@@ -26,8 +28,7 @@ namespace pong
         @location(2) fragPosLightSpace: vec3f,
     };
 
-    struct Uniforms {
-        model: mat4x4<f32>,
+    struct FrameUniforms {
         view: mat4x4<f32>,
         projection: mat4x4<f32>,
         lightViewProjection: mat4x4<f32>,
@@ -36,17 +37,19 @@ namespace pong
         time: f32,
     };
 
-    @group(0) @binding(0) var<uniform> uUniforms: Uniforms;
-    @group(1) @binding(0) var shadowMap: texture_depth_2d;
-    @group(1) @binding(1) var shadowSampler: sampler_comparison;
+    @group(0) @binding(0) var<uniform> uUniforms: FrameUniforms;
+    @group(1) @binding(0) var<storage, read> instanceBuffer: array<mat4x4<f32>>;
+    @group(2) @binding(0) var shadowMap: texture_depth_2d;
+    @group(2) @binding(1) var shadowSampler: sampler_comparison;
 
     @vertex
     fn vs_main(in: VertexInput) -> VertexOutput {
         var out: VertexOutput;
+        let model = instanceBuffer[in.instanceIndex];
         var position = vec4f(in.position, 1.0);
-        out.position = uUniforms.projection * uUniforms.view * uUniforms.model * position;
+        out.position = uUniforms.projection * uUniforms.view * model * position;
 
-        let posFromLight = uUniforms.lightViewProjection * uUniforms.model * position;
+        let posFromLight = uUniforms.lightViewProjection * model * position;
         out.fragPosLightSpace = vec3f(
             posFromLight.xy * vec2f(0.5, -0.5) + vec2f(0.5),
             posFromLight.z
@@ -98,8 +101,7 @@ namespace pong
 
     const char *shadowShaderSource = R"(
  
-    struct Uniforms {
-        model: mat4x4<f32>,
+    struct FrameUniforms {
         view: mat4x4<f32>,
         projection: mat4x4<f32>,
         lightViewProjection: mat4x4<f32>,
@@ -108,12 +110,13 @@ namespace pong
         time: f32,
     };
 
-    @group(0) @binding(0) var<uniform> uUniforms: Uniforms;
+    @group(0) @binding(0) var<uniform> uUniforms: FrameUniforms;
+    @group(1) @binding(0) var<storage, read> instanceBuffer: array<mat4x4<f32>>;
         
     @vertex
-    fn vs_main(@location(0) position: vec3<f32>) -> @builtin(position) vec4<f32> {
+    fn vs_main(@builtin(instance_index) instanceIndex: u32, @location(0) position: vec3<f32>) -> @builtin(position) vec4<f32> {
         // Output triangle position in clip space
-        return uUniforms.lightViewProjection * uUniforms.model * vec4(position, 1.0);
+        return uUniforms.lightViewProjection * instanceBuffer[instanceIndex] * vec4(position, 1.0);
     }
 
     )";
@@ -136,7 +139,16 @@ namespace pong
         projection: mat4x4<f32>,
     };
 
+    // Quad in the xz-plane, rotated around y, see SpriteBatch::Instance
     struct SpriteInstance {
+        position: vec3<f32>,
+        rotation: f32,
+        offsetAndSize: vec2<u32>,
+        scale: u32,
+        tint: u32,
+    }
+
+    struct SpriteTransformInstance {
         transform: mat4x4<f32>,
         offsetAndSize: vec4<f32>,
         tint: vec4<f32>,
@@ -146,11 +158,29 @@ namespace pong
     @group(0) @binding(1) var spriteSampler: sampler;
     @group(0) @binding(2) var<uniform> uUniforms: SpriteUniforms;
     @group(0) @binding(3) var<storage, read> spriteInstanceBuffer: array<SpriteInstance>;
+    @group(0) @binding(4) var<storage, read> spriteTransformInstanceBuffer: array<SpriteTransformInstance>;
 
     @vertex
     fn vs_main(in: VertexInput) -> VertexOutput {
         var out: VertexOutput;
         let instance = spriteInstanceBuffer[in.instanceIndex];
+        let scale = unpack2x16float(instance.scale);
+        let c = cos(instance.rotation);
+        let s = sin(instance.rotation);
+        let local = vec2f(in.position.x * scale.x, in.position.z * scale.y);
+        let position = instance.position + vec3f(c * local.x + s * local.y, in.position.y, -s * local.x + c * local.y);
+        out.position = uUniforms.projection * uUniforms.view * vec4f(position, 1.0);
+        let offset = unpack2x16unorm(instance.offsetAndSize.x);
+        let size = unpack2x16unorm(instance.offsetAndSize.y);
+        out.texCoord = in.texCoord * size + offset;
+        out.tint = unpack4x8unorm(instance.tint);
+        return out;
+    }
+
+    @vertex
+    fn vs_main_transform(in: VertexInput) -> VertexOutput {
+        var out: VertexOutput;
+        let instance = spriteTransformInstanceBuffer[in.instanceIndex];
         var position = vec4f(in.position, 1.0);
         out.position = uUniforms.projection * uUniforms.view * instance.transform * position;
         out.texCoord = in.texCoord * instance.offsetAndSize.zw + instance.offsetAndSize.xy;
@@ -283,12 +313,12 @@ namespace pong
 
     bool Renderer::InitializeBindGroupLayout()
     {
-        // Binding layout.
+        // Frame binding layout.
         wgpu::BindGroupLayoutEntry bindingLayout = {};
         bindingLayout.binding = 0;
         bindingLayout.visibility = wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment;
         bindingLayout.buffer.type = wgpu::BufferBindingType::Uniform;
-        bindingLayout.buffer.minBindingSize = sizeof(Uniforms);
+        bindingLayout.buffer.minBindingSize = sizeof(FrameUniforms);
         bindingLayout.buffer.hasDynamicOffset = true;
 
         wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
@@ -296,6 +326,18 @@ namespace pong
         bindGroupLayoutDesc.entries = &bindingLayout;
         m_bindGroupLayouts[0] = m_device.CreateBindGroupLayout(&bindGroupLayoutDesc);
 
+        // Instance binding layout.
+        wgpu::BindGroupLayoutEntry instanceBindingLayout = {};
+        instanceBindingLayout.binding = 0;
+        instanceBindingLayout.visibility = wgpu::ShaderStage::Vertex;
+        instanceBindingLayout.buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+        instanceBindingLayout.buffer.minBindingSize = sizeof(glm::mat4);
+        instanceBindingLayout.buffer.hasDynamicOffset = true;
+
+        bindGroupLayoutDesc.entryCount = 1;
+        bindGroupLayoutDesc.entries = &instanceBindingLayout;
+        m_bindGroupLayouts[1] = m_device.CreateBindGroupLayout(&bindGroupLayoutDesc);
+
         // Shadow binding layout.
         std::array<wgpu::BindGroupLayoutEntry, 2> bindingLayouts = {};
         bindingLayouts[0].binding = 0;
@@ -310,10 +352,10 @@ namespace pong
         bindGroupLayoutDesc.entryCount = bindingLayouts.size();
         bindGroupLayoutDesc.entries = bindingLayouts.data();
 
-        m_bindGroupLayouts[1] = m_device.CreateBindGroupLayout(&bindGroupLayoutDesc);
+        m_bindGroupLayouts[2] = m_device.CreateBindGroupLayout(&bindGroupLayoutDesc);
 
         // Sprite binding layout.
-        std::array<wgpu::BindGroupLayoutEntry, 4> spriteBindingLayouts = {};
+        std::array<wgpu::BindGroupLayoutEntry, 5> spriteBindingLayouts = {};
         spriteBindingLayouts[0].binding = 0;
         spriteBindingLayouts[0].visibility = wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment;
         spriteBindingLayouts[0].texture.sampleType = wgpu::TextureSampleType::Float;
@@ -327,18 +369,24 @@ namespace pong
         spriteBindingLayouts[2].visibility = wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment;
         spriteBindingLayouts[2].buffer.type = wgpu::BufferBindingType::Uniform;
         spriteBindingLayouts[2].buffer.minBindingSize = sizeof(SpriteUniforms);
-        spriteBindingLayouts[2].buffer.hasDynamicOffset = false;
+        spriteBindingLayouts[2].buffer.hasDynamicOffset = true;
 
         spriteBindingLayouts[3].binding = 3;
         spriteBindingLayouts[3].visibility = wgpu::ShaderStage::Vertex;
         spriteBindingLayouts[3].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
-        spriteBindingLayouts[3].buffer.minBindingSize = sizeof(SpriteBatch::Instance) * c_maxSprites;
-        spriteBindingLayouts[3].buffer.hasDynamicOffset = false;
+        spriteBindingLayouts[3].buffer.minBindingSize = sizeof(SpriteBatch::Instance);
+        spriteBindingLayouts[3].buffer.hasDynamicOffset = true;
+
+        spriteBindingLayouts[4].binding = 4;
+        spriteBindingLayouts[4].visibility = wgpu::ShaderStage::Vertex;
+        spriteBindingLayouts[4].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+        spriteBindingLayouts[4].buffer.minBindingSize = sizeof(SpriteBatch::TransformInstance);
+        spriteBindingLayouts[4].buffer.hasDynamicOffset = true;
 
         bindGroupLayoutDesc.entryCount = spriteBindingLayouts.size();
         bindGroupLayoutDesc.entries = spriteBindingLayouts.data();
 
-        m_bindGroupLayouts[2] = m_device.CreateBindGroupLayout(&bindGroupLayoutDesc);
+        m_bindGroupLayouts[3] = m_device.CreateBindGroupLayout(&bindGroupLayoutDesc);
 
         for (auto &&layout : m_bindGroupLayouts)
         {
@@ -421,7 +469,7 @@ namespace pong
 
         // Create the pipeline layout
         wgpu::PipelineLayoutDescriptor layoutDesc{};
-        layoutDesc.bindGroupLayoutCount = 1;
+        layoutDesc.bindGroupLayoutCount = 2;
         layoutDesc.bindGroupLayouts = m_bindGroupLayouts.data();
         wgpu::PipelineLayout layout = m_device.CreatePipelineLayout(&layoutDesc);
         pipelineDesc.layout = layout;
@@ -524,14 +572,17 @@ namespace pong
         // Create the pipeline layout
         wgpu::PipelineLayoutDescriptor layoutDesc{};
         layoutDesc.bindGroupLayoutCount = 1;
-        layoutDesc.bindGroupLayouts = &m_bindGroupLayouts[2];
+        layoutDesc.bindGroupLayouts = &m_bindGroupLayouts[3];
         wgpu::PipelineLayout layout = m_device.CreatePipelineLayout(&layoutDesc);
         pipelineDesc.layout = layout;
 
-        // Create the pipeline.
+        // Create the pipelines, compact instances and the opt-in full transform instances.
         m_spritePipeline = m_device.CreateRenderPipeline(&pipelineDesc);
 
-        return m_spritePipeline != nullptr;
+        pipelineDesc.vertex.entryPoint = "vs_main_transform";
+        m_spriteTransformPipeline = m_device.CreateRenderPipeline(&pipelineDesc);
+
+        return m_spritePipeline != nullptr && m_spriteTransformPipeline != nullptr;
     }
 
     bool Renderer::InitializeRenderPipeline()
@@ -631,7 +682,7 @@ namespace pong
 
         // Create the pipeline layout
         wgpu::PipelineLayoutDescriptor layoutDesc{};
-        layoutDesc.bindGroupLayoutCount = 2;
+        layoutDesc.bindGroupLayoutCount = 3;
         layoutDesc.bindGroupLayouts = m_bindGroupLayouts.data();
         wgpu::PipelineLayout layout = m_device.CreatePipelineLayout(&layoutDesc);
         pipelineDesc.layout = layout;
@@ -720,63 +771,58 @@ namespace pong
     bool Renderer::InitializeUniforms()
     {
         std::cout << "Initializing WebGPU uniforms" << std::endl;
-        // Create uniform buffer
-        wgpu::BufferDescriptor bufferDesc{};
-        const size_t bufferStride = CeilToNextMultiple(sizeof(Uniforms), c_minUniformBufferOffsetAlignment);
-        bufferDesc.size = 5 * bufferStride;
-        bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
-        bufferDesc.mappedAtCreation = false;
-
-        m_uniformBuffer = m_device.CreateBuffer(&bufferDesc);
         m_uniforms.lightDirection = glm::vec4(0.0f, -1.0f, 0.0f, 0.0f);
         m_uniforms.projection = glm::perspective(glm::radians(52.5f), float(m_width) / float(m_height), 0.1f, 1000.0f);
 
-        wgpu::BufferDescriptor spriteBufferDesc{};
-        const size_t spriteBufferStride = CeilToNextMultiple(sizeof(SpriteUniforms), c_minUniformBufferOffsetAlignment);
-        spriteBufferDesc.size = 5 * spriteBufferStride;
-        spriteBufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform;
-        spriteBufferDesc.mappedAtCreation = false;
-
-        m_spriteUniformBuffer = m_device.CreateBuffer(&spriteBufferDesc);
-
-        wgpu::BufferDescriptor instanceBufferDesc{};
-        instanceBufferDesc.size = c_maxSprites * sizeof(SpriteBatch::Instance);
-        instanceBufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
-        instanceBufferDesc.mappedAtCreation = false;
-
-        m_spriteInstanceBuffer = m_device.CreateBuffer(&instanceBufferDesc);
-
-        return m_uniformBuffer != nullptr && m_spriteUniformBuffer != nullptr;
+        return m_uploadRing.Initialize(m_device, m_queue, c_uploadRingSize, c_uploadBindingWindow, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::Storage);
     }
 
     bool Renderer::InitializeBindGroup()
     {
+        m_uploadGeneration = m_uploadRing.GetGeneration();
+
         // Create a binding
         wgpu::BindGroupEntry uniformBinding = {};
         uniformBinding.binding = 0;
-        uniformBinding.buffer = m_uniformBuffer;
-        uniformBinding.size = sizeof(Uniforms);
+        uniformBinding.buffer = m_uploadRing.GetBuffer();
+        uniformBinding.size = sizeof(FrameUniforms);
 
         // A bind group contains one or multiple bindings
         wgpu::BindGroupDescriptor bindGroupDesc{};
         bindGroupDesc.layout = m_bindGroupLayouts[0];
         bindGroupDesc.entryCount = 1;
         bindGroupDesc.entries = &uniformBinding;
-        m_bindGroup = m_device.CreateBindGroup(&bindGroupDesc);
-
-        std::array<wgpu::BindGroupEntry, 2> shadowMapBindings{};
-        shadowMapBindings[0].binding = 0;
-        shadowMapBindings[0].textureView = m_shadowDepthTextureView;
+        m_frameBindGroup = m_device.CreateBindGroup(&bindGroupDesc);
 
-        shadowMapBindings[1].binding = 1;
-        shadowMapBindings[1].sampler = m_shadowDepthSampler;
+        wgpu::BindGroupEntry instanceBinding = {};
+        instanceBinding.binding = 0;
+        instanceBinding.buffer = m_uploadRing.GetBuffer();
+        instanceBinding.size = m_uploadRing.GetBindingWindow();
 
         bindGroupDesc.layout = m_bindGroupLayouts[1];
-        bindGroupDesc.entryCount = shadowMapBindings.size();
-        bindGroupDesc.entries = shadowMapBindings.data();
-        m_shadowBindGroup = m_device.CreateBindGroup(&bindGroupDesc);
+        bindGroupDesc.entryCount = 1;
+        bindGroupDesc.entries = &instanceBinding;
+        m_instanceBindGroup = m_device.CreateBindGroup(&bindGroupDesc);
+
+        // Sprite bind groups reference the ring as well, they are recreated on demand
+        m_spriteBindGroups.clear();
+
+        if (m_shadowBindGroup == nullptr)
+        {
+            std::array<wgpu::BindGroupEntry, 2> shadowMapBindings{};
+            shadowMapBindings[0].binding = 0;
+            shadowMapBindings[0].textureView = m_shadowDepthTextureView;
+
+            shadowMapBindings[1].binding = 1;
+            shadowMapBindings[1].sampler = m_shadowDepthSampler;
+
+            bindGroupDesc.layout = m_bindGroupLayouts[2];
+            bindGroupDesc.entryCount = shadowMapBindings.size();
+            bindGroupDesc.entries = shadowMapBindings.data();
+            m_shadowBindGroup = m_device.CreateBindGroup(&bindGroupDesc);
+        }
 
-        return m_bindGroup != nullptr && m_shadowBindGroup != nullptr;
+        return m_frameBindGroup != nullptr && m_instanceBindGroup != nullptr && m_shadowBindGroup != nullptr;
     }
 
     void Renderer::AddSpriteBindGroup(Texture *texture)
@@ -786,7 +832,7 @@ namespace pong
             return;
         }
 
-        std::array<wgpu::BindGroupEntry, 4> spriteBindings = {};
+        std::array<wgpu::BindGroupEntry, 5> spriteBindings = {};
         spriteBindings[0].binding = 0;
         spriteBindings[0].textureView = texture->GetTextureView();
 
@@ -794,37 +840,104 @@ namespace pong
         spriteBindings[1].sampler = texture->GetSampler();
 
         spriteBindings[2].binding = 2;
-        spriteBindings[2].buffer = m_spriteUniformBuffer;
+        spriteBindings[2].buffer = m_uploadRing.GetBuffer();
         spriteBindings[2].size = sizeof(SpriteUniforms);
 
         spriteBindings[3].binding = 3;
-        spriteBindings[3].buffer = m_spriteInstanceBuffer;
-        spriteBindings[3].size = c_maxSprites * sizeof(SpriteBatch::Instance);
+        spriteBindings[3].buffer = m_uploadRing.GetBuffer();
+        spriteBindings[3].size = m_uploadRing.GetBindingWindow();
+
+        spriteBindings[4].binding = 4;
+        spriteBindings[4].buffer = m_uploadRing.GetBuffer();
+        spriteBindings[4].size = m_uploadRing.GetBindingWindow();
 
         wgpu::BindGroupDescriptor bindGroupDesc{};
-        bindGroupDesc.layout = m_bindGroupLayouts[2];
+        bindGroupDesc.layout = m_bindGroupLayouts[3];
         bindGroupDesc.entryCount = spriteBindings.size();
         bindGroupDesc.entries = spriteBindings.data();
 
         m_spriteBindGroups.emplace(texture->GetId(), m_device.CreateBindGroup(&bindGroupDesc));
     }
 
-    void Renderer::RenderBatches(wgpu::RenderPassEncoder &pass)
+    void Renderer::UploadBatches()
     {
-        static const size_t uniformBufferStride = CeilToNextMultiple(sizeof(Uniforms), c_minUniformBufferOffsetAlignment);
-
         static std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
         std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
-        float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+        m_uniforms.time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+
+        m_frameUniformAllocation = m_uploadRing.Upload(&m_uniforms, sizeof(FrameUniforms), c_minUniformBufferOffsetAlignment);
+
+        // Batches were packed back to back on submit, each batch then draws its own range
+        const uint32_t instanceCount = uint32_t(m_modelInstances.size());
+        m_instanceAllocation = m_uploadRing.Allocate(glm::max(instanceCount, 1u) * sizeof(glm::mat4), c_minUniformBufferOffsetAlignment);
+        glm::mat4 *instances = static_cast<glm::mat4 *>(m_uploadRing.GetData(m_instanceAllocation));
+        std::copy(m_modelInstances.begin(), m_modelInstances.end(), instances);
+    }
+
+    void Renderer::UploadSpriteBatches()
+    {
+        m_spriteUniforms.projection = m_uniforms.projection;
+        m_spriteUniforms.view = m_uniforms.view;
 
-        Uniforms uniforms = m_uniforms;
-        uniforms.time = time;
+        m_spriteUniformAllocation = m_uploadRing.Upload(&m_spriteUniforms, sizeof(SpriteUniforms), c_minUniformBufferOffsetAlignment);
+
+        // Group batches by instance format and texture, ties keep their submission order
+        std::sort(m_spriteBatches.begin(), m_spriteBatches.end(),
+                  [](const SpriteBatch &lhs, const SpriteBatch &rhs)
+                  {
+                      if (lhs.transform != rhs.transform)
+                      {
+                          return lhs.transform < rhs.transform;
+                      }
+                      if (lhs.texture->GetId() != rhs.texture->GetId())
+                      {
+                          return lhs.texture->GetId() < rhs.texture->GetId();
+                      }
+                      return lhs.firstInstance < rhs.firstInstance;
+                  });
+
+        m_spriteInstanceAllocation = m_uploadRing.Allocate(glm::max(uint32_t(m_spriteInstances.size()), 1u) * sizeof(SpriteBatch::Instance), c_minUniformBufferOffsetAlignment);
+        m_spriteTransformInstanceAllocation = m_uploadRing.Allocate(glm::max(uint32_t(m_spriteTransformInstances.size()), 1u) * sizeof(SpriteBatch::TransformInstance), c_minUniformBufferOffsetAlignment);
+
+        // Pack the batches in sorted order and merge neighbours with the same texture into one draw
+        m_spriteDraws.clear();
+        uint32_t instanceCount = 0;
+        uint32_t transformInstanceCount = 0;
+        for (auto &&batch : m_spriteBatches)
+        {
+            uint32_t &first = batch.transform ? transformInstanceCount : instanceCount;
+            if (batch.transform)
+            {
+                auto *dst = static_cast<SpriteBatch::TransformInstance *>(m_uploadRing.GetData(m_spriteTransformInstanceAllocation));
+                std::copy_n(m_spriteTransformInstances.begin() + batch.firstInstance, batch.instanceCount, dst + first);
+            }
+            else
+            {
+                auto *dst = static_cast<SpriteBatch::Instance *>(m_uploadRing.GetData(m_spriteInstanceAllocation));
+                std::copy_n(m_spriteInstances.begin() + batch.firstInstance, batch.instanceCount, dst + first);
+            }
+
+            if (m_spriteDraws.empty() || m_spriteDraws.back().texture != batch.texture || m_spriteDraws.back().transform != batch.transform)
+            {
+                m_spriteDraws.push_back({batch.texture, first, 0, batch.transform});
+            }
+
+            m_spriteDraws.back().instanceCount += batch.instanceCount;
+            first += batch.instanceCount;
+        }
+    }
+
+    void Renderer::RenderBatches(wgpu::RenderPassEncoder &pass)
+    {
+        uint32_t frameOffset = m_uploadRing.GetOffset(m_frameUniformAllocation);
+        uint32_t instanceOffset = m_uploadRing.GetOffset(m_instanceAllocation);
+        pass.SetBindGroup(0, m_frameBindGroup, 1, &frameOffset);
+        pass.SetBindGroup(1, m_instanceBindGroup, 1, &instanceOffset);
 
-        uint32_t index = 0;
         for (auto &&batch : m_batches)
         {
             Model *model = batch.model;
-            if (model == nullptr)
+            if (model == nullptr || batch.instanceCount == 0)
             {
                 continue;
             }
@@ -835,48 +948,44 @@ namespace pong
             size_t indexCount = model->GetIndexCount();
             pass.SetIndexBuffer(model->GetIndexBuffer(), wgpu::IndexFormat::Uint32, 0, indexCount * sizeof(uint32_t));
 
-            for (auto &&transform : batch.transforms)
-            {
-                uint32_t dynamicOffset = index * uniformBufferStride;
-                uniforms.model = transform;
-                m_queue.WriteBuffer(m_uniformBuffer, dynamicOffset, &uniforms, sizeof(Uniforms));
-                pass.SetBindGroup(0, m_bindGroup, 1, &dynamicOffset);
-                pass.DrawIndexed(indexCount);
-                index++;
-            }
+            pass.DrawIndexed(indexCount, batch.instanceCount, 0, 0, batch.firstInstance);
         }
     }
 
     void Renderer::RenderSpriteBatches(wgpu::RenderPassEncoder &pass)
     {
-        m_spriteUniforms.projection = m_uniforms.projection;
-        m_spriteUniforms.view = m_uniforms.view;
-        SpriteUniforms uniforms = m_spriteUniforms;
-
-        m_queue.WriteBuffer(m_spriteUniformBuffer, 0, &uniforms, sizeof(SpriteUniforms));
-
         size_t vertexCount = m_quad->GetVertexCount();
         pass.SetVertexBuffer(0, m_quad->GetVertexBuffer(), 0, vertexCount * sizeof(Model::SpriteVertex));
 
         size_t indexCount = m_quad->GetIndexCount();
         pass.SetIndexBuffer(m_quad->GetIndexBuffer(), wgpu::IndexFormat::Uint32, 0, indexCount * sizeof(uint32_t));
 
-        for (auto &&batch : m_spriteBatches)
+        std::array<uint32_t, 3> dynamicOffsets = {
+            m_uploadRing.GetOffset(m_spriteUniformAllocation),
+            m_uploadRing.GetOffset(m_spriteInstanceAllocation),
+            m_uploadRing.GetOffset(m_spriteTransformInstanceAllocation),
+        };
+
+        pass.SetPipeline(m_spritePipeline);
+        bool transform = false;
+        for (auto &&draw : m_spriteDraws)
         {
-            if (batch.texture == nullptr || batch.texture->GetId() == 0 || m_spriteBindGroups.find(batch.texture->GetId()) == m_spriteBindGroups.end() || batch.instances.empty())
+            if (draw.transform != transform)
             {
-                continue;
+                transform = draw.transform;
+                pass.SetPipeline(transform ? m_spriteTransformPipeline : m_spritePipeline);
             }
 
-            wgpu::BindGroup &bindGroup = m_spriteBindGroups[batch.texture->GetId()];
-            pass.SetBindGroup(0, bindGroup);
+            if (m_spriteBindGroups.find(draw.texture->GetId()) == m_spriteBindGroups.end())
+            {
+                AddSpriteBindGroup(draw.texture);
+            }
 
-            m_queue.WriteBuffer(m_spriteInstanceBuffer, 0, batch.instances.data(), batch.instances.size() * sizeof(SpriteBatch::Instance));
+            wgpu::BindGroup &bindGroup = m_spriteBindGroups[draw.texture->GetId()];
+            pass.SetBindGroup(0, bindGroup, dynamicOffsets.size(), dynamicOffsets.data());
 
-            pass.DrawIndexed(indexCount, batch.instances.size());
+            pass.DrawIndexed(indexCount, draw.instanceCount, 0, 0, draw.firstInstance);
         }
-
-        m_spriteBatches.clear();
     }
 
     void Renderer::Resize(uint32_t width, uint32_t height)
@@ -892,7 +1001,21 @@ namespace pong
         m_depthTextureView.Release();
         InitializeDepthTexture();
 
-        m_uniforms.projection = glm::perspective(glm::radians(52.5f), float(m_width) / float(m_height), 0.1f, 1000.0f);
+        m_uniforms.projection = glm::perspective(glm::radians(52.5f), float(m_width) / float(m_height), 0.1f, m_farPlane);
+    }
+
+    void Renderer::SetFarPlane(float farPlane)
+    {
+        m_farPlane = farPlane;
+        m_uniforms.projection = glm::perspective(glm::radians(52.5f), float(m_width) / float(m_height), 0.1f, m_farPlane);
+    }
+
+    void Renderer::SetShadowBounds(const glm::vec3 &center, const glm::vec2 &size)
+    {
+        // Looking straight down, nudged along z so the up vector is not parallel to the view direction
+        m_uniforms.lightViewProjection =
+            glm::ortho(-size.x / 2.0f, size.x / 2.0f, -size.y / 2.0f, size.y / 2.0f, 1.0f, 1000.0f) *
+            glm::lookAt(center + glm::vec3(0.0f, 900.0f, 0.01f), center, glm::vec3(0.0f, 1.0f, 0.0f));
     }
 
     void Renderer::Render()
@@ -906,6 +1029,27 @@ namespace pong
 
         wgpu::CommandEncoder encoder = m_device.CreateCommandEncoder();
 
+        m_uploadRing.BeginFrame();
+        UploadBatches();
+        UploadSpriteBatches();
+
+        if (!m_uploadRing.Flush())
+        {
+            std::cerr << "Cannot flush upload ring" << std::endl;
+            m_batches.clear();
+            m_modelInstances.clear();
+            m_spriteBatches.clear();
+            m_spriteInstances.clear();
+            m_spriteTransformInstances.clear();
+            return;
+        }
+
+        // The ring has been reallocated, rebind it
+        if (m_uploadGeneration != m_uploadRing.GetGeneration())
+        {
+            InitializeBindGroup();
+        }
+
         { // Shadow pass
             wgpu::RenderPassDescriptor shadowPassDesc;
 
@@ -968,10 +1112,9 @@ namespace pong
             wgpu::RenderPassEncoder renderPass = encoder.BeginRenderPass(&renderPassDesc);
 
             renderPass.SetPipeline(m_renderPipeline);
-            renderPass.SetBindGroup(1, m_shadowBindGroup);
+            renderPass.SetBindGroup(2, m_shadowBindGroup);
             RenderBatches(renderPass);
 
-            renderPass.SetPipeline(m_spritePipeline);
             RenderSpriteBatches(renderPass);
 
             renderPass.End();
@@ -979,12 +1122,17 @@ namespace pong
 
         wgpu::CommandBuffer command = encoder.Finish();
         m_queue.Submit(1, &command);
+        m_uploadRing.EndFrame();
 
 #ifndef __EMSCRIPTEN__
         m_swapChain.Present();
         m_device.Tick();
 #endif
         m_batches.clear();
+        m_modelInstances.clear();
+        m_spriteBatches.clear();
+        m_spriteInstances.clear();
+        m_spriteTransformInstances.clear();
     }
 
     void Renderer::Tick()
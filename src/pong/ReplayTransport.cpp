@@ -0,0 +1,81 @@
+#include "pong/ReplayTransport.h"
+
+#include <iostream>
+
+namespace pong
+{
+    bool ReplayTransport::Connect(const std::string &url, ReceiveCallback onReceive, void *userData)
+    {
+        const std::string scheme = "replay://";
+        const std::string path = url.substr(scheme.size(), url.find('?') - scheme.size());
+        if (!m_reader.Open(path))
+        {
+            return false;
+        }
+
+        m_fast = GetUrlParameter(url, "fast", 0.0f) != 0.0f;
+        m_step = GetUrlParameter(url, "step", float(m_step));
+        m_time = 0.0;
+        m_startTime = std::chrono::steady_clock::now();
+        m_onReceive = onReceive;
+        m_userData = userData;
+        m_delivered = 0;
+
+        m_open = true;
+        m_hasRecord = ReadReceived();
+        std::cout << "Replaying " << m_reader.GetRecordCount() << " records from " << path << (m_fast ? " as fast as possible" : "") << std::endl;
+        return true;
+    }
+
+    void ReplayTransport::Close()
+    {
+        m_reader.Close();
+        m_hasRecord = false;
+        m_open = false;
+    }
+
+    bool ReplayTransport::ReadReceived()
+    {
+        while (m_reader.Next(m_record))
+        {
+            if (m_record.direction == CaptureDirection::Received)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ReplayTransport::Poll()
+    {
+        if (!m_open)
+        {
+            return;
+        }
+
+        if (m_fast)
+        {
+            m_time += m_step;
+        }
+        else
+        {
+            m_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+        }
+
+        while (m_hasRecord && m_record.time <= m_time)
+        {
+            if (m_onReceive != nullptr)
+            {
+                m_onReceive(m_record.payload.data(), m_record.payload.size(), m_userData);
+            }
+            m_delivered++;
+            m_hasRecord = ReadReceived();
+        }
+
+        if (!m_hasRecord)
+        {
+            std::cout << "Replay finished after " << m_delivered << " frames" << std::endl;
+            Close();
+        }
+    }
+}
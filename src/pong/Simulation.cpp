@@ -0,0 +1,212 @@
+#include "pong/Simulation.h"
+
+#include <glm/glm.hpp>
+
+namespace pong
+{
+    static constexpr uint32_t c_maxFolds = 8;
+
+    // Reflects y back into [low, high] as often as it takes, returns the number of reflections
+    static uint32_t Fold(float &y, float low, float high)
+    {
+        uint32_t folds = 0;
+        while ((y < low || y > high) && folds < c_maxFolds)
+        {
+            y = y < low ? 2.0f * low - y : 2.0f * high - y;
+            folds++;
+        }
+        y = glm::clamp(y, low, high);
+        return folds;
+    }
+
+    void Simulation::Initialize(const Config &config)
+    {
+        m_config = config;
+        m_state = {};
+        m_state.state = GameState::Starting;
+
+        const float startY = (m_config.arenaHeight - m_config.paddleHeight) / 2.0f;
+        m_state.players.push_back({c_leftPlayerId, 0, glm::vec2(m_config.paddleMargin, startY)});
+        m_state.players.push_back({c_rightPlayerId, 0, glm::vec2(m_config.arenaWidth - m_config.paddleMargin - m_config.paddleWidth, startY)});
+
+        m_inputs = {};
+        m_appliedInputs = {};
+        m_hasInput = {};
+        m_stateTime = 0.0f;
+        m_rounds = 0;
+        m_stats = {};
+
+        ResetBall();
+    }
+
+    bool Simulation::ApplyInput(uint32_t player, uint32_t sequenceNumber, const InputState &input)
+    {
+        if (player >= c_playerCount || (m_hasInput[player] && int32_t(sequenceNumber - m_appliedInputs[player]) <= 0))
+        {
+            return false;
+        }
+
+        m_inputs[player] = input;
+        m_appliedInputs[player] = sequenceNumber;
+        m_hasInput[player] = true;
+        return true;
+    }
+
+    void Simulation::ResetBall()
+    {
+        // Alternate serve direction and angle every round. The serve is 0.3 radians off the x axis, written
+        // out since libm cos and sin may round differently between platforms.
+        const float cosAngle = 0.955336511f;
+        const float sinAngle = 0.295520216f;
+        const float direction = m_rounds % 2 == 0 ? -1.0f : 1.0f;
+        const float side = m_rounds % 4 < 2 ? 1.0f : -1.0f;
+        m_state.ball.position = glm::vec2(m_config.arenaWidth, m_config.arenaHeight) / 2.0f;
+        m_state.ball.velocity = glm::vec2(direction * cosAngle, side * sinAngle) * m_config.ballSpeed;
+    }
+
+    void Simulation::MovePaddles(float deltaTime)
+    {
+        const float maxY = m_config.arenaHeight - m_config.paddleHeight;
+        for (uint32_t player = 0; player < c_playerCount; player++)
+        {
+            Player &paddle = m_state.players[player];
+            if (player == 1 && m_config.rightPlayerAI)
+            {
+                const float target = m_state.ball.position.y - m_config.paddleHeight / 2.0f;
+                const float step = glm::clamp(target - paddle.position.y, -m_config.aiSpeed * deltaTime, m_config.aiSpeed * deltaTime);
+                paddle.position.y = glm::clamp(paddle.position.y + step, 0.0f, maxY);
+            }
+            else
+            {
+                const InputState &input = m_inputs[player];
+                const float direction = (float(input.upPressed) - float(input.downPressed)) * m_config.upDirection;
+                paddle.position.y = glm::clamp(paddle.position.y + direction * m_config.paddleSpeed * deltaTime, 0.0f, maxY);
+            }
+        }
+    }
+
+    bool Simulation::CollidePaddle(uint32_t player, const glm::vec2 &start, float deltaTime)
+    {
+        const Player &paddle = m_state.players[player];
+        Ball &ball = m_state.ball;
+        const float radius = m_config.ballRadius;
+
+        const bool left = player == 0;
+        if (left != (ball.velocity.x < 0.0f))
+        {
+            return false;
+        }
+
+        // Plane the ball center crosses when its edge reaches the inner face of the paddle
+        const glm::vec2 travel = ball.velocity * deltaTime;
+        const float face = left ? paddle.position.x + m_config.paddleWidth + radius : paddle.position.x - radius;
+        const float endX = start.x + travel.x;
+        const bool crosses = left ? start.x >= face && endX < face : start.x <= face && endX > face;
+        // The paddle can also move onto a ball that is already past its face
+        const bool overlapsAtEnd = endX + radius >= paddle.position.x && endX - radius <= paddle.position.x + m_config.paddleWidth;
+        if (!crosses && !overlapsAtEnd)
+        {
+            return false;
+        }
+
+        // Where the ball is when it touches, walls it bounced off on the way fold it back
+        const float t = crosses ? (face - start.x) / travel.x : 1.0f;
+        glm::vec2 contact = glm::vec2(start.x + travel.x * t, start.y + travel.y * t);
+        const bool flipped = Fold(contact.y, radius, m_config.arenaHeight - radius) % 2 == 1;
+        if (contact.y < paddle.position.y || contact.y > paddle.position.y + m_config.paddleHeight)
+        {
+            return false;
+        }
+
+        // Deflect depending on where the paddle was hit
+        const float offset = (contact.y - (paddle.position.y + m_config.paddleHeight / 2.0f)) / (m_config.paddleHeight / 2.0f);
+        ball.velocity.x = -ball.velocity.x * m_config.ballSpeedup;
+        ball.velocity.y = (flipped ? -ball.velocity.y : ball.velocity.y) + offset * m_config.ballSpeed * 0.5f;
+
+        // The rest of the step continues from the contact with the new velocity
+        ball.position = contact + ball.velocity * (deltaTime * (1.0f - t));
+        if (Fold(ball.position.y, radius, m_config.arenaHeight - radius) % 2 == 1)
+        {
+            ball.velocity.y = -ball.velocity.y;
+        }
+
+        m_state.events.hasHit = true;
+        m_stats.hits++;
+        m_stats.sweptHits += crosses && !overlapsAtEnd;
+        return true;
+    }
+
+    void Simulation::MoveBall(float deltaTime)
+    {
+        Ball &ball = m_state.ball;
+        const glm::vec2 start = ball.position;
+        for (uint32_t player = 0; player < c_playerCount; player++)
+        {
+            if (CollidePaddle(player, start, deltaTime))
+            {
+                return;
+            }
+        }
+
+        ball.position += ball.velocity * deltaTime;
+        const uint32_t bounces = Fold(ball.position.y, m_config.ballRadius, m_config.arenaHeight - m_config.ballRadius);
+        if (bounces % 2 == 1)
+        {
+            ball.velocity.y = -ball.velocity.y;
+        }
+        m_stats.wallBounces += bounces;
+    }
+
+    void Simulation::Step()
+    {
+        const float deltaTime = GetTimeStep();
+        m_state.events = {};
+        m_state.tick++;
+        m_stats.steps++;
+        m_stateTime += deltaTime;
+
+        MovePaddles(deltaTime);
+
+        Player &left = m_state.players[0];
+        Player &right = m_state.players[1];
+        switch (m_state.state)
+        {
+        case GameState::WaitingForPlayers:
+        case GameState::Starting:
+        case GameState::InBetweenRounds:
+            if (m_stateTime >= m_config.roundDelay)
+            {
+                m_state.state = GameState::Running;
+                m_state.events.newRound = true;
+                m_stateTime = 0.0f;
+            }
+            return;
+        case GameState::GameOver:
+            if (m_stateTime >= 3.0f * m_config.roundDelay)
+            {
+                left.score = 0;
+                right.score = 0;
+                m_state.state = GameState::Starting;
+                m_stateTime = 0.0f;
+            }
+            return;
+        case GameState::Running:
+            break;
+        }
+
+        MoveBall(deltaTime);
+
+        const Ball &ball = m_state.ball;
+        if (ball.position.x < 0.0f || ball.position.x > m_config.arenaWidth)
+        {
+            Player &scorer = ball.position.x < 0.0f ? right : left;
+            scorer.score++;
+            m_state.events.playerWasHit = true;
+            m_state.state = scorer.score >= m_config.winningScore ? GameState::GameOver : GameState::InBetweenRounds;
+            m_stateTime = 0.0f;
+            m_rounds++;
+            m_stats.rounds++;
+            ResetBall();
+        }
+    }
+}
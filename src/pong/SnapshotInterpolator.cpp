@@ -0,0 +1,139 @@
+#include "pong/SnapshotInterpolator.h"
+
+#include <glm/glm.hpp>
+
+namespace pong
+{
+    void SnapshotInterpolator::Initialize(float serverTickRate)
+    {
+        m_serverStep = 1.0 / double(serverTickRate);
+        m_hasClockOffset = false;
+    }
+
+    void SnapshotInterpolator::AddArrival(const GameStateMessage &message)
+    {
+        const double receiveTime = message.receiveTime;
+        if (m_lastReceiveTime >= 0.0)
+        {
+            const float interArrival = float(receiveTime - m_lastReceiveTime);
+            m_interval += (interArrival - m_interval) * c_estimateGain;
+        }
+        m_lastReceiveTime = receiveTime;
+
+        // The fastest arrival is the best guess of when the server sent a tick, later ones only drift the
+        // offset slowly so clock rate differences are followed. Ticks going back mean the server restarted.
+        const double transit = receiveTime - GetServerTime(message);
+        if (!m_hasClockOffset || transit < m_clockOffset || message.tick < m_lastTick)
+        {
+            m_clockOffset = transit;
+            m_hasClockOffset = true;
+        }
+        else
+        {
+            m_clockOffset += (transit - m_clockOffset) * c_offsetGain;
+        }
+
+        // Jitter is how much later than the fastest arrival snapshots come in on average, the delay has to
+        // cover it for playback to stay behind the newest snapshot
+        m_jitter += (float(transit - m_clockOffset) - m_jitter) * c_estimateGain;
+        m_delay = glm::clamp(m_interval + c_jitterMultiplier * m_jitter, c_minDelay, c_maxDelay);
+        m_lastTick = message.tick;
+    }
+
+    const SnapshotInterpolator::Sample &SnapshotInterpolator::Update(const MessageHistory &messages, double now, float deltaTime)
+    {
+        for (size_t i = 0; i < messages.size(); i++)
+        {
+            if (messages[i].receiveTime > m_lastReceiveTime)
+            {
+                AddArrival(messages[i]);
+            }
+        }
+
+        m_sample.valid = !messages.empty();
+        if (!m_sample.valid)
+        {
+            return m_sample;
+        }
+
+        // Advance the playback clock and steer it gently towards the target instead of jumping
+        const double target = now - m_clockOffset - m_delay;
+        m_playbackTime += deltaTime;
+        const double error = target - m_playbackTime;
+        if (glm::abs(error) > c_clockSnapThreshold)
+        {
+            m_playbackTime = target;
+        }
+        else
+        {
+            m_playbackTime += glm::clamp(error, -double(deltaTime * c_clockAdjustRate), double(deltaTime * c_clockAdjustRate));
+        }
+
+        // Find the snapshots surrounding the playback time
+        size_t next = 0;
+        while (next < messages.size() && GetServerTime(messages[next]) <= m_playbackTime)
+        {
+            next++;
+        }
+
+        m_stats.bufferDepth = uint32_t(messages.size() - next);
+        m_stats.interpDelay = m_delay;
+        m_stats.interval = m_interval;
+        m_stats.jitter = m_jitter;
+
+        if (next == 0)
+        {
+            // Playback is behind everything we have, hold the oldest snapshot
+            const GameStateMessage &oldest = messages.front();
+            m_sample.players = oldest.players;
+            m_sample.ball = oldest.ball;
+            m_sample.extrapolated = false;
+            m_extrapolating = false;
+        }
+        else if (next == messages.size())
+        {
+            // The next snapshot is late, hold the newest one and let the caller dead reckon the ball
+            const GameStateMessage &newest = messages.back();
+            const float extrapolation = float(m_playbackTime - GetServerTime(newest));
+
+            if (!m_extrapolating)
+            {
+                m_stats.lateSnapshots++;
+            }
+            m_extrapolating = true;
+            m_stats.extrapolationTime = extrapolation;
+
+            m_sample.players = newest.players;
+            m_sample.ball = newest.ball;
+            m_sample.extrapolated = true;
+        }
+        else
+        {
+            const GameStateMessage &from = messages[next - 1];
+            const GameStateMessage &to = messages[next];
+            const double fromTime = GetServerTime(from);
+            const float alpha = float((m_playbackTime - fromTime) / glm::max(GetServerTime(to) - fromTime, 1e-6));
+
+            m_sample.players = to.players;
+            for (auto &&player : m_sample.players)
+            {
+                for (auto &&previous : from.players)
+                {
+                    if (previous.playerId == player.playerId)
+                    {
+                        player.position = glm::mix(previous.position, player.position, alpha);
+                        break;
+                    }
+                }
+            }
+
+            m_sample.ball.position = glm::mix(from.ball.position, to.ball.position, alpha);
+            m_sample.ball.velocity = glm::mix(from.ball.velocity, to.ball.velocity, alpha);
+            m_sample.extrapolated = false;
+            m_extrapolating = false;
+            m_stats.extrapolationTime = 0.0f;
+        }
+
+        return m_sample;
+    }
+}
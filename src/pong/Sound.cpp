@@ -27,7 +27,7 @@ namespace pong
         uint32_t dataSize;
     };
 
-    std::unique_ptr<Sound> Sound::Create(const std::string &path)
+    bool Sound::Load(const std::string &path, Data &data)
     {
         WavHeader header;
         std::ifstream file(path, std::ios::binary);
@@ -35,7 +35,7 @@ namespace pong
         if (!file.is_open())
         {
             std::cerr << "Failed to open .wav-file: " << path << std::endl;
-            return nullptr;
+            return false;
         }
 
         file.read(reinterpret_cast<char *>(&header), sizeof(WavHeader));
@@ -43,26 +43,33 @@ namespace pong
         if (std::strncmp(header.riff, "RIFF", 4) || std::strncmp(header.wave, "WAVE", 4))
         {
             std::cerr << "Invalid .wav-file: " << path << std::endl;
-            return nullptr;
+            return false;
         }
 
+        data.channels = header.channels;
+        data.bitsPerSample = header.bitsPerSample;
+        data.sampleRate = header.sampleRate;
+        data.samples.resize(header.dataSize);
+        file.read(data.samples.data(), data.samples.size());
+        file.close();
+        return true;
+    }
+
+    std::unique_ptr<Sound> Sound::Create(const Data &data)
+    {
         ALenum format;
-        if (header.bitsPerSample == 16)
+        if (data.bitsPerSample == 16)
         {
-            format = (header.channels == 2) ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+            format = (data.channels == 2) ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
         }
         else
         {
-            format = (header.channels == 2) ? AL_FORMAT_STEREO8 : AL_FORMAT_MONO8;
+            format = (data.channels == 2) ? AL_FORMAT_STEREO8 : AL_FORMAT_MONO8;
         }
 
-        std::vector<char> data(header.dataSize);
-        file.read(data.data(), data.size());
-        file.close();
-
         uint32_t bufId = 0;
         alGenBuffers(1, &bufId);
-        alBufferData(bufId, format, data.data(), data.size(), header.sampleRate);
+        alBufferData(bufId, format, data.samples.data(), data.samples.size(), data.sampleRate);
 
         uint32_t srcId = 0;
         alGenSources(1, &srcId);
@@ -71,6 +78,16 @@ namespace pong
         return std::make_unique<Sound>(bufId, srcId);
     }
 
+    std::unique_ptr<Sound> Sound::Create(const std::string &path)
+    {
+        Data data;
+        if (!Load(path, data))
+        {
+            return nullptr;
+        }
+        return Create(data);
+    }
+
     Sound::~Sound()
     {
         alDeleteSources(1, &sourceId);
@@ -0,0 +1,139 @@
+#include "pong/TextCache.h"
+
+#include <cassert>
+
+namespace pong
+{
+    void TextCache::Initialize(Texture *font)
+    {
+        m_font = font;
+        if (m_font == nullptr || m_font->GetWidth() == 0)
+        {
+            return;
+        }
+
+        // The atlas holds A-Z followed by 0-9, lower case letters share the upper case glyphs
+        const float glyphSize = letterWidth / m_font->GetWidth();
+        auto setGlyph = [&](char c, uint32_t index)
+        {
+            Glyph &glyph = m_glyphs[uint8_t(c)];
+            glyph.offsetAndSize = glm::vec4(index * glyphSize, 0.0f, glyphSize, 1.0f);
+            glyph.visible = true;
+        };
+
+        for (char c = 'A'; c <= 'Z'; c++)
+        {
+            setGlyph(c, c - 'A');
+            setGlyph(c - 'A' + 'a', c - 'A');
+        }
+
+        for (char c = '0'; c <= '9'; c++)
+        {
+            setGlyph(c, 26 + c - '0');
+        }
+
+        // Unknown characters take up space but are not drawn
+        for (auto &&glyph : m_glyphs)
+        {
+            glyph.advance = letterWorldWidth + letterSpacing;
+        }
+    }
+
+    void TextCache::Layout(TextBlock &block) const
+    {
+        block.glyphs.clear();
+
+        float width = 0.0f;
+        for (char c : block.text)
+        {
+            width += m_glyphs[uint8_t(c)].advance;
+        }
+
+        const glm::vec2 letterScale = block.scale * letterWorldWidth;
+        float x = -width / 2.0f;
+        for (char c : block.text)
+        {
+            const Glyph &glyph = m_glyphs[uint8_t(c)];
+            if (glyph.visible)
+            {
+                glm::vec3 position = block.position + glm::vec3(block.scale.x * x, 0.0f, 0.0f);
+                block.glyphs.emplace_back(position, letterScale, 0.0f, glyph.offsetAndSize, block.tint);
+            }
+            x += glyph.advance;
+        }
+    }
+
+    TextCache::Handle TextCache::Create(std::string_view text, const glm::vec3 &position, const glm::vec2 &scale, const glm::vec4 &tint)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Handle handle = c_invalidHandle;
+        if (!m_freeHandles.empty())
+        {
+            handle = m_freeHandles.back();
+            m_freeHandles.pop_back();
+        }
+        else
+        {
+            handle = Handle(m_blocks.size());
+            m_blocks.emplace_back();
+        }
+
+        TextBlock &block = m_blocks[handle];
+        block.alive = true;
+        block.visible = true;
+        block.text = text;
+        block.position = position;
+        block.scale = scale;
+        block.tint = tint;
+        Layout(block);
+
+        return handle;
+    }
+
+    void TextCache::Destroy(Handle handle)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (handle >= m_blocks.size() || !m_blocks[handle].alive)
+        {
+            return;
+        }
+
+        // Keep the block's buffers around for reuse
+        m_blocks[handle].alive = false;
+        m_freeHandles.push_back(handle);
+    }
+
+    void TextCache::Set(Handle handle, std::string_view text, const glm::vec3 &position, const glm::vec2 &scale, const glm::vec4 &tint)
+    {
+        assert(handle < m_blocks.size() && m_blocks[handle].alive);
+
+        TextBlock &block = m_blocks[handle];
+        if (block.text == text && block.position == position && block.scale == scale && block.tint == tint)
+        {
+            return;
+        }
+
+        block.text = text;
+        block.position = position;
+        block.scale = scale;
+        block.tint = tint;
+        Layout(block);
+    }
+
+    void TextCache::SetVisible(Handle handle, bool visible)
+    {
+        assert(handle < m_blocks.size() && m_blocks[handle].alive);
+        m_blocks[handle].visible = visible;
+    }
+
+    void TextCache::Submit(Renderer &renderer) const
+    {
+        for (auto &&block : m_blocks)
+        {
+            if (block.alive && block.visible)
+            {
+                renderer.SubmitInstances(m_font, block.glyphs.data(), block.glyphs.size());
+            }
+        }
+    }
+}
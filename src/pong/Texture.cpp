@@ -18,12 +18,13 @@ namespace pong
         uint32_t bytesPerChannel = 0;
     };
 
-    std::unique_ptr<Texture> Texture::Create(const wgpu::Device &device, const wgpu::Queue &queue, const std::string &path)
+    bool Texture::Load(const std::string &path, Data &data)
     {
         std::fstream file(path, std::ios::binary | std::ios::in);
         if (!file.is_open())
         {
-            return nullptr;
+            std::cerr << "Failed to open texture: " << path << std::endl;
+            return false;
         }
 
         TextureHeader header;
@@ -32,7 +33,7 @@ namespace pong
         if (header.bytesPerChannel != 1)
         {
             std::cerr << "Unsupported texture format: " << path << std::endl;
-            return nullptr;
+            return false;
         }
 
         std::cout << "width: " << header.width << std::endl;
@@ -40,12 +41,21 @@ namespace pong
         std::cout << "numChannels: " << header.numChannels << std::endl;
         std::cout << "bytesPerChannel: " << header.bytesPerChannel << std::endl;
 
-        std::vector<uint8_t> data(header.width * header.height * header.numChannels);
-        file.read(reinterpret_cast<char *>(data.data()), data.size());
+        data.width = header.width;
+        data.height = header.height;
+        data.numChannels = header.numChannels;
+        data.pixels.resize(header.width * header.height * header.numChannels);
+        file.read(reinterpret_cast<char *>(data.pixels.data()), data.pixels.size());
         file.close();
 
+        std::cout << "Texture loaded: " << path << std::endl;
+        return true;
+    }
+
+    std::unique_ptr<Texture> Texture::Create(const wgpu::Device &device, const wgpu::Queue &queue, const Data &data)
+    {
         wgpu::TextureFormat format = wgpu::TextureFormat::Undefined;
-        switch (header.numChannels)
+        switch (data.numChannels)
         {
         case 1:
             format = wgpu::TextureFormat::R8Unorm;
@@ -57,14 +67,14 @@ namespace pong
             format = wgpu::TextureFormat::RGBA8Unorm;
             break;
         default:
-            std::cerr << "Unsupported texture format: " << path << std::endl;
+            std::cerr << "Unsupported texture channel count: " << data.numChannels << std::endl;
             return nullptr;
         }
 
         wgpu::TextureDescriptor descriptor;
         descriptor.dimension = wgpu::TextureDimension::e2D;
-        descriptor.size.width = header.width;
-        descriptor.size.height = header.height;
+        descriptor.size.width = data.width;
+        descriptor.size.height = data.height;
         descriptor.size.depthOrArrayLayers = 1;
         descriptor.sampleCount = 1;
         descriptor.format = format;
@@ -81,10 +91,10 @@ namespace pong
 
         wgpu::TextureDataLayout source;
         source.offset = 0;
-        source.bytesPerRow = header.numChannels * header.width * header.bytesPerChannel;
-        source.rowsPerImage = header.height;
+        source.bytesPerRow = data.numChannels * data.width;
+        source.rowsPerImage = data.height;
 
-        queue.WriteTexture(&imageCopyTexture, data.data(), header.width * header.height * header.numChannels * header.bytesPerChannel, &source, &descriptor.size);
+        queue.WriteTexture(&imageCopyTexture, data.pixels.data(), data.pixels.size(), &source, &descriptor.size);
 
         wgpu::TextureViewDescriptor viewDescriptor;
         viewDescriptor.format = format;
@@ -110,8 +120,18 @@ namespace pong
         wgpu::Sampler sampler = device.CreateSampler(&samplerDescriptor);
 
         uint32_t id = s_nextId++;
-        std::cout << "Texture id: " << id << ":" << path << std::endl;
+        std::cout << "Texture id: " << id << std::endl;
 
-        return std::make_unique<Texture>(id, header.width, header.height, texture, textureView, sampler);
+        return std::make_unique<Texture>(id, data.width, data.height, texture, textureView, sampler);
+    }
+
+    std::unique_ptr<Texture> Texture::Create(const wgpu::Device &device, const wgpu::Queue &queue, const std::string &path)
+    {
+        Data data;
+        if (!Load(path, data))
+        {
+            return nullptr;
+        }
+        return Create(device, queue, data);
     }
 }
\ No newline at end of file
@@ -0,0 +1,310 @@
+#include "pong/TransformKernel.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define PONG_TRANSFORM_SSE
+#if defined(__GNUC__) || defined(__clang__)
+// Compiled for AVX2 on its own and only called when the CPU has it, the rest of the build stays baseline
+#define PONG_TRANSFORM_AVX2
+#define PONG_TARGET_AVX2 __attribute__((target("avx2,fma")))
+// The shared block template is only ever inlined into the AVX2 entry point, never called with AVX2 vectors
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+#endif
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PONG_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define PONG_ALWAYS_INLINE inline
+#endif
+
+namespace pong
+{
+    // One block of Simd::c_width transforms. The rotation part is the usual quaternion to matrix expansion,
+    // written once for every vector width so all paths compute exactly the same expressions.
+    template <typename Simd>
+    static PONG_ALWAYS_INLINE void BuildBlock(const TransformArrays &arrays, size_t i, glm::mat4 *out)
+    {
+        using V = typename Simd::Vector;
+        const V one = Simd::Set(1.0f);
+        const V zero = Simd::Set(0.0f);
+
+        const V x = Simd::Load(arrays.rotationX + i);
+        const V y = Simd::Load(arrays.rotationY + i);
+        const V z = Simd::Load(arrays.rotationZ + i);
+        const V w = Simd::Load(arrays.rotationW + i);
+
+        const V x2 = Simd::Add(x, x);
+        const V y2 = Simd::Add(y, y);
+        const V z2 = Simd::Add(z, z);
+        const V xx = Simd::Mul(x, x2);
+        const V yy = Simd::Mul(y, y2);
+        const V zz = Simd::Mul(z, z2);
+        const V xy = Simd::Mul(x, y2);
+        const V xz = Simd::Mul(x, z2);
+        const V yz = Simd::Mul(y, z2);
+        const V wx = Simd::Mul(w, x2);
+        const V wy = Simd::Mul(w, y2);
+        const V wz = Simd::Mul(w, z2);
+
+        const V sx = arrays.scaleX != nullptr ? Simd::Load(arrays.scaleX + i) : one;
+        const V sy = arrays.scaleY != nullptr ? Simd::Load(arrays.scaleY + i) : one;
+        const V sz = arrays.scaleZ != nullptr ? Simd::Load(arrays.scaleZ + i) : one;
+
+        // [column][row], each lane is one transform
+        const V columns[4][4] = {
+            {Simd::Mul(Simd::Sub(one, Simd::Add(yy, zz)), sx), Simd::Mul(Simd::Add(xy, wz), sx), Simd::Mul(Simd::Sub(xz, wy), sx), zero},
+            {Simd::Mul(Simd::Sub(xy, wz), sy), Simd::Mul(Simd::Sub(one, Simd::Add(xx, zz)), sy), Simd::Mul(Simd::Add(yz, wx), sy), zero},
+            {Simd::Mul(Simd::Add(xz, wy), sz), Simd::Mul(Simd::Sub(yz, wx), sz), Simd::Mul(Simd::Sub(one, Simd::Add(xx, yy)), sz), zero},
+            {Simd::Load(arrays.positionX + i), Simd::Load(arrays.positionY + i), Simd::Load(arrays.positionZ + i), one},
+        };
+
+        Simd::Store(columns, reinterpret_cast<float *>(out + i));
+    }
+
+    struct ScalarOps
+    {
+        using Vector = float;
+        static constexpr size_t c_width = 1;
+
+        static PONG_ALWAYS_INLINE float Set(float value) { return value; }
+        static PONG_ALWAYS_INLINE float Load(const float *data) { return *data; }
+        static PONG_ALWAYS_INLINE float Add(float a, float b) { return a + b; }
+        static PONG_ALWAYS_INLINE float Sub(float a, float b) { return a - b; }
+        static PONG_ALWAYS_INLINE float Mul(float a, float b) { return a * b; }
+
+        static PONG_ALWAYS_INLINE void Store(const float (&columns)[4][4], float *out)
+        {
+            for (size_t column = 0; column < 4; column++)
+            {
+                for (size_t row = 0; row < 4; row++)
+                {
+                    out[column * 4 + row] = columns[column][row];
+                }
+            }
+        }
+    };
+
+#ifdef PONG_TRANSFORM_SSE
+    struct SseOps
+    {
+        using Vector = __m128;
+        static constexpr size_t c_width = 4;
+
+        static PONG_ALWAYS_INLINE __m128 Set(float value) { return _mm_set1_ps(value); }
+        static PONG_ALWAYS_INLINE __m128 Load(const float *data) { return _mm_loadu_ps(data); }
+        static PONG_ALWAYS_INLINE __m128 Add(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+        static PONG_ALWAYS_INLINE __m128 Sub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+        static PONG_ALWAYS_INLINE __m128 Mul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+
+        // Rows of one column for four transforms are transposed into that column of each matrix
+        static PONG_ALWAYS_INLINE void Store(const __m128 (&columns)[4][4], float *out)
+        {
+            for (size_t column = 0; column < 4; column++)
+            {
+                __m128 r0 = columns[column][0];
+                __m128 r1 = columns[column][1];
+                __m128 r2 = columns[column][2];
+                __m128 r3 = columns[column][3];
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                _mm_storeu_ps(out + 0 * 16 + column * 4, r0);
+                _mm_storeu_ps(out + 1 * 16 + column * 4, r1);
+                _mm_storeu_ps(out + 2 * 16 + column * 4, r2);
+                _mm_storeu_ps(out + 3 * 16 + column * 4, r3);
+            }
+        }
+    };
+#endif
+
+#ifdef PONG_TRANSFORM_AVX2
+    struct Avx2Ops
+    {
+        using Vector = __m256;
+        static constexpr size_t c_width = 8;
+
+        PONG_TARGET_AVX2 static inline __m256 Set(float value) { return _mm256_set1_ps(value); }
+        PONG_TARGET_AVX2 static inline __m256 Load(const float *data) { return _mm256_loadu_ps(data); }
+        PONG_TARGET_AVX2 static inline __m256 Add(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+        PONG_TARGET_AVX2 static inline __m256 Sub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+        PONG_TARGET_AVX2 static inline __m256 Mul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+
+        // Each half is four transforms, transposed like the SSE path
+        PONG_TARGET_AVX2 static inline void Store(const __m256 (&columns)[4][4], float *out)
+        {
+            for (size_t column = 0; column < 4; column++)
+            {
+                for (size_t half = 0; half < 2; half++)
+                {
+                    __m128 r0 = half == 0 ? _mm256_castps256_ps128(columns[column][0]) : _mm256_extractf128_ps(columns[column][0], 1);
+                    __m128 r1 = half == 0 ? _mm256_castps256_ps128(columns[column][1]) : _mm256_extractf128_ps(columns[column][1], 1);
+                    __m128 r2 = half == 0 ? _mm256_castps256_ps128(columns[column][2]) : _mm256_extractf128_ps(columns[column][2], 1);
+                    __m128 r3 = half == 0 ? _mm256_castps256_ps128(columns[column][3]) : _mm256_extractf128_ps(columns[column][3], 1);
+                    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                    float *block = out + half * 4 * 16 + column * 4;
+                    _mm_storeu_ps(block + 0 * 16, r0);
+                    _mm_storeu_ps(block + 1 * 16, r1);
+                    _mm_storeu_ps(block + 2 * 16, r2);
+                    _mm_storeu_ps(block + 3 * 16, r3);
+                }
+            }
+        }
+    };
+#endif
+
+#if defined(__wasm_simd128__)
+    struct WasmOps
+    {
+        using Vector = v128_t;
+        static constexpr size_t c_width = 4;
+
+        static PONG_ALWAYS_INLINE v128_t Set(float value) { return wasm_f32x4_splat(value); }
+        static PONG_ALWAYS_INLINE v128_t Load(const float *data) { return wasm_v128_load(data); }
+        static PONG_ALWAYS_INLINE v128_t Add(v128_t a, v128_t b) { return wasm_f32x4_add(a, b); }
+        static PONG_ALWAYS_INLINE v128_t Sub(v128_t a, v128_t b) { return wasm_f32x4_sub(a, b); }
+        static PONG_ALWAYS_INLINE v128_t Mul(v128_t a, v128_t b) { return wasm_f32x4_mul(a, b); }
+
+        static PONG_ALWAYS_INLINE void Store(const v128_t (&columns)[4][4], float *out)
+        {
+            for (size_t column = 0; column < 4; column++)
+            {
+                const v128_t t0 = wasm_i32x4_shuffle(columns[column][0], columns[column][1], 0, 4, 1, 5);
+                const v128_t t1 = wasm_i32x4_shuffle(columns[column][0], columns[column][1], 2, 6, 3, 7);
+                const v128_t t2 = wasm_i32x4_shuffle(columns[column][2], columns[column][3], 0, 4, 1, 5);
+                const v128_t t3 = wasm_i32x4_shuffle(columns[column][2], columns[column][3], 2, 6, 3, 7);
+                wasm_v128_store(out + 0 * 16 + column * 4, wasm_i32x4_shuffle(t0, t2, 0, 1, 4, 5));
+                wasm_v128_store(out + 1 * 16 + column * 4, wasm_i32x4_shuffle(t0, t2, 2, 3, 6, 7));
+                wasm_v128_store(out + 2 * 16 + column * 4, wasm_i32x4_shuffle(t1, t3, 0, 1, 4, 5));
+                wasm_v128_store(out + 3 * 16 + column * 4, wasm_i32x4_shuffle(t1, t3, 2, 3, 6, 7));
+            }
+        }
+    };
+#endif
+
+    template <typename Simd>
+    static PONG_ALWAYS_INLINE size_t BuildBlocks(const TransformArrays &arrays, size_t count, glm::mat4 *out)
+    {
+        size_t i = 0;
+        for (; i + Simd::c_width <= count; i += Simd::c_width)
+        {
+            BuildBlock<Simd>(arrays, i, out);
+        }
+        return i;
+    }
+
+    void BuildTransformsScalar(const TransformArrays &arrays, size_t count, glm::mat4 *out)
+    {
+        BuildBlocks<ScalarOps>(arrays, count, out);
+    }
+
+#ifdef PONG_TRANSFORM_AVX2
+    PONG_TARGET_AVX2 static size_t BuildTransformsAvx2(const TransformArrays &arrays, size_t count, glm::mat4 *out)
+    {
+        return BuildBlocks<Avx2Ops>(arrays, count, out);
+    }
+#endif
+
+    bool IsTransformKernelAvailable(TransformKernel kernel)
+    {
+        switch (kernel)
+        {
+        case TransformKernel::Scalar:
+            return true;
+#ifdef PONG_TRANSFORM_SSE
+        case TransformKernel::Sse:
+            return true;
+#endif
+#ifdef PONG_TRANSFORM_AVX2
+        case TransformKernel::Avx2:
+        {
+            static const bool hasAvx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+            return hasAvx2;
+        }
+#endif
+#if defined(__wasm_simd128__)
+        case TransformKernel::WasmSimd:
+            return true;
+#endif
+        default:
+            return false;
+        }
+    }
+
+    TransformKernel GetTransformKernel()
+    {
+        for (TransformKernel kernel : {TransformKernel::Avx2, TransformKernel::Sse, TransformKernel::WasmSimd})
+        {
+            if (IsTransformKernelAvailable(kernel))
+            {
+                return kernel;
+            }
+        }
+        return TransformKernel::Scalar;
+    }
+
+    const char *ToString(TransformKernel kernel)
+    {
+        switch (kernel)
+        {
+        case TransformKernel::Scalar:
+            return "scalar";
+        case TransformKernel::Sse:
+            return "sse";
+        case TransformKernel::Avx2:
+            return "avx2";
+        case TransformKernel::WasmSimd:
+            return "wasm-simd128";
+        }
+        return "unknown";
+    }
+
+    bool BuildTransforms(const TransformArrays &arrays, size_t count, glm::mat4 *out, TransformKernel kernel)
+    {
+        if (!IsTransformKernelAvailable(kernel))
+        {
+            return false;
+        }
+
+        size_t done = 0;
+        switch (kernel)
+        {
+#ifdef PONG_TRANSFORM_AVX2
+        case TransformKernel::Avx2:
+            done = BuildTransformsAvx2(arrays, count, out);
+            break;
+#endif
+#ifdef PONG_TRANSFORM_SSE
+        case TransformKernel::Sse:
+            done = BuildBlocks<SseOps>(arrays, count, out);
+            break;
+#endif
+#if defined(__wasm_simd128__)
+        case TransformKernel::WasmSimd:
+            done = BuildBlocks<WasmOps>(arrays, count, out);
+            break;
+#endif
+        default:
+            break;
+        }
+
+        // Whatever does not fill a whole vector
+        if (done < count)
+        {
+            TransformArrays tail = arrays;
+            for (const float **array : {&tail.positionX, &tail.positionY, &tail.positionZ, &tail.rotationX, &tail.rotationY, &tail.rotationZ, &tail.rotationW, &tail.scaleX, &tail.scaleY, &tail.scaleZ})
+            {
+                *array = *array != nullptr ? *array + done : nullptr;
+            }
+            BuildTransformsScalar(tail, count - done, out + done);
+        }
+        return true;
+    }
+
+    void BuildTransforms(const TransformArrays &arrays, size_t count, glm::mat4 *out)
+    {
+        BuildTransforms(arrays, count, out, GetTransformKernel());
+    }
+}
@@ -0,0 +1,68 @@
+#include "pong/Transport.h"
+
+#include "pong/EmscriptenTransport.h"
+#include "pong/LoopbackTransport.h"
+#include "pong/PosixTransport.h"
+#include "pong/ReplayTransport.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace pong
+{
+    // Returns the value of key in the url query, or fallback
+    float GetUrlParameter(const std::string &url, const std::string &key, float fallback)
+    {
+        for (auto &&[name, value] : GetUrlParameters(url))
+        {
+            if (name == key)
+            {
+                return std::strtof(value.c_str(), nullptr);
+            }
+        }
+        return fallback;
+    }
+
+    std::vector<std::pair<std::string, std::string>> GetUrlParameters(const std::string &url)
+    {
+        std::vector<std::pair<std::string, std::string>> parameters;
+        const size_t query = url.find('?');
+        if (query == std::string::npos)
+        {
+            return parameters;
+        }
+
+        size_t start = query + 1;
+        while (start < url.size())
+        {
+            const size_t end = std::min(url.find('&', start), url.size());
+            const size_t equals = std::min(url.find('=', start), end);
+            if (equals > start)
+            {
+                const size_t valueStart = std::min(equals + 1, end);
+                parameters.emplace_back(url.substr(start, equals - start), url.substr(valueStart, end - valueStart));
+            }
+            start = end + 1;
+        }
+        return parameters;
+    }
+
+    std::unique_ptr<ITransport> CreateTransport(const std::string &url)
+    {
+        if (url.rfind("loopback://", 0) == 0)
+        {
+            return std::make_unique<LoopbackTransport>();
+        }
+
+        if (url.rfind("replay://", 0) == 0)
+        {
+            return std::make_unique<ReplayTransport>();
+        }
+
+#ifdef __EMSCRIPTEN__
+        return std::make_unique<EmscriptenTransport>();
+#else
+        return std::make_unique<PosixTransport>();
+#endif
+    }
+}
@@ -0,0 +1,183 @@
+#include "pong/UploadRing.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+namespace pong
+{
+    static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    bool UploadRing::Initialize(const wgpu::Device &device, const wgpu::Queue &queue, uint64_t capacity, uint32_t bindingWindow, wgpu::BufferUsage usage)
+    {
+        m_device = device;
+        m_queue = queue;
+        m_usage = usage | wgpu::BufferUsage::CopyDst;
+
+        return CreateBuffer(capacity, bindingWindow);
+    }
+
+    bool UploadRing::CreateBuffer(uint64_t capacity, uint32_t bindingWindow)
+    {
+        // The binding window is kept as slack after the ring so any offset inside it can be bound with a fixed size
+        wgpu::BufferDescriptor bufferDesc{};
+        bufferDesc.label = "Upload Ring Buffer";
+        bufferDesc.size = capacity + bindingWindow;
+        bufferDesc.usage = m_usage;
+        bufferDesc.mappedAtCreation = false;
+
+        wgpu::Buffer buffer = m_device.CreateBuffer(&bufferDesc);
+        if (buffer == nullptr)
+        {
+            std::cerr << "Cannot allocate upload ring of " << bufferDesc.size << " bytes" << std::endl;
+            return false;
+        }
+
+        // Frames still in flight keep a reference to the old buffer through their bind groups
+        m_buffer = buffer;
+        m_capacity = capacity;
+        m_bindingWindow = bindingWindow;
+        m_generation++;
+        m_head = 0;
+        m_stats.capacity = capacity;
+
+        return true;
+    }
+
+    bool UploadRing::Overlaps(uint64_t offset, uint64_t size) const
+    {
+        for (auto &&frame : m_frames)
+        {
+            if (!frame.pending || frame.generation != m_generation)
+            {
+                continue;
+            }
+
+            if (offset < frame.offset + frame.size && frame.offset < offset + size)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void UploadRing::BeginFrame()
+    {
+        m_staging.clear();
+        m_largestAllocation = 0;
+        m_stats.usedBytes = 0;
+        m_stats.allocations = 0;
+    }
+
+    UploadRing::Allocation UploadRing::Allocate(uint32_t size, uint32_t alignment)
+    {
+        assert(alignment > 0);
+
+        const uint64_t offset = AlignUp(m_staging.size(), alignment);
+        m_staging.resize(offset + size);
+
+        m_largestAllocation = std::max(m_largestAllocation, size);
+        m_stats.allocations++;
+
+        return {uint32_t(offset), size};
+    }
+
+    UploadRing::Allocation UploadRing::Upload(const void *data, uint32_t size, uint32_t alignment)
+    {
+        Allocation allocation = Allocate(size, alignment);
+        std::memcpy(GetData(allocation), data, size);
+        return allocation;
+    }
+
+    bool UploadRing::Flush()
+    {
+        const uint64_t frameSize = AlignUp(m_staging.size(), 256);
+        m_stats.usedBytes = m_staging.size();
+        m_stats.peakBytes = std::max(m_stats.peakBytes, m_stats.usedBytes);
+
+        if (m_largestAllocation > m_bindingWindow)
+        {
+            uint32_t bindingWindow = std::max(m_bindingWindow, 256u);
+            while (bindingWindow < m_largestAllocation)
+            {
+                bindingWindow *= 2;
+            }
+
+            m_stats.grows++;
+            if (!CreateBuffer(m_capacity, bindingWindow))
+            {
+                return false;
+            }
+        }
+
+        uint64_t offset = m_head + frameSize > m_capacity ? 0 : m_head;
+        if (frameSize > m_capacity || Overlaps(offset, frameSize))
+        {
+            // Room for this frame plus the ones still in flight
+            uint64_t capacity = std::max(m_capacity, uint64_t(256));
+            while (capacity < frameSize * c_maxFramesInFlight)
+            {
+                capacity *= 2;
+            }
+
+            m_stats.grows++;
+            if (!CreateBuffer(capacity, m_bindingWindow))
+            {
+                return false;
+            }
+            offset = 0;
+        }
+
+        m_frameBase = offset;
+        m_head = offset + frameSize;
+
+        if (!m_staging.empty())
+        {
+            // Writes must be a multiple of four bytes
+            m_staging.resize(AlignUp(m_staging.size(), 4));
+            m_queue.WriteBuffer(m_buffer, m_frameBase, m_staging.data(), m_staging.size());
+        }
+
+        return true;
+    }
+
+    void UploadRing::EndFrame()
+    {
+        InFlightFrame &frame = m_frames[m_serial % c_maxFramesInFlight];
+        if (frame.pending)
+        {
+            // Queue writes are ordered so reusing the slot is still safe, but the GPU is falling behind
+            m_stats.stalls++;
+        }
+
+        frame.offset = m_frameBase;
+        frame.size = m_head - m_frameBase;
+        frame.generation = m_generation;
+        frame.serial = m_serial++;
+        frame.pending = true;
+
+        m_queue.OnSubmittedWorkDone(
+            [](WGPUQueueWorkDoneStatus, void *userdata)
+            {
+                Submission *submission = static_cast<Submission *>(userdata);
+                InFlightFrame &frame = submission->ring->m_frames[submission->serial % c_maxFramesInFlight];
+                if (frame.serial == submission->serial)
+                {
+                    frame.pending = false;
+                }
+                delete submission;
+            },
+            new Submission{this, frame.serial});
+
+        m_stats.framesInFlight = 0;
+        for (auto &&inFlight : m_frames)
+        {
+            m_stats.framesInFlight += inFlight.pending ? 1 : 0;
+        }
+    }
+}
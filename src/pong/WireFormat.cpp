@@ -0,0 +1,605 @@
+#include "pong/WireFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace pong
+{
+    const char *ToString(DecodeResult result)
+    {
+        switch (result)
+        {
+        case DecodeResult::Ok:
+            return "Ok";
+        case DecodeResult::TooShort:
+            return "TooShort";
+        case DecodeResult::TooLong:
+            return "TooLong";
+        case DecodeResult::BadLength:
+            return "BadLength";
+        case DecodeResult::BadEvent:
+            return "BadEvent";
+        case DecodeResult::BadState:
+            return "BadState";
+        case DecodeResult::BadMagic:
+            return "BadMagic";
+        case DecodeResult::MissingBaseline:
+            return "MissingBaseline";
+        case DecodeResult::BadDelta:
+            return "BadDelta";
+        }
+        return "Unknown";
+    }
+
+    static bool ReadFlag(WireReader &reader, bool &valid)
+    {
+        const uint8_t value = reader.ReadU8();
+        valid = valid && value <= 1;
+        return value == 1;
+    }
+
+    DecodeResult DecodeGameState(const uint8_t *data, size_t size, GameStateMessage &msg)
+    {
+        // Reject on length before touching any field
+        if (size < wire::c_fixedSize)
+        {
+            return DecodeResult::TooShort;
+        }
+        if (size > wire::c_maxFrameSize)
+        {
+            return DecodeResult::TooLong;
+        }
+        if ((size - wire::c_fixedSize) % wire::c_playerSize != 0)
+        {
+            return DecodeResult::BadLength;
+        }
+
+        const size_t numPlayers = (size - wire::c_fixedSize) / wire::c_playerSize;
+        WireReader reader(data, size);
+
+        msg.head.playerId = reader.ReadU32();
+        msg.head.sequenceNumber = reader.ReadU32();
+
+        msg.players.clear();
+        for (size_t i = 0; i < numPlayers; i++)
+        {
+            Player player;
+            player.playerId = reader.ReadU32();
+            player.score = reader.ReadI32();
+            player.position.x = reader.ReadF32();
+            player.position.y = reader.ReadF32();
+            msg.players.push_back(player);
+        }
+
+        msg.ball.position.x = reader.ReadF32();
+        msg.ball.position.y = reader.ReadF32();
+        msg.ball.velocity.x = reader.ReadF32();
+        msg.ball.velocity.y = reader.ReadF32();
+
+        bool validEvents = true;
+        msg.events.hasHit = ReadFlag(reader, validEvents);
+        msg.events.playerWasHit = ReadFlag(reader, validEvents);
+        msg.events.hasSmashed = ReadFlag(reader, validEvents);
+        msg.events.newRound = ReadFlag(reader, validEvents);
+
+        const uint8_t state = reader.ReadU8();
+
+        // The length checks above guarantee every read was in bounds
+        if (!reader.IsOk() || reader.GetRemaining() != 0)
+        {
+            return DecodeResult::BadLength;
+        }
+        if (!validEvents)
+        {
+            return DecodeResult::BadEvent;
+        }
+        if (state > uint8_t(GameState::GameOver))
+        {
+            return DecodeResult::BadState;
+        }
+
+        msg.state = GameState(state);
+        return DecodeResult::Ok;
+    }
+
+    size_t EncodeGameState(const GameStateMessage &msg, uint8_t *data, size_t capacity)
+    {
+        WireWriter writer(data, capacity);
+        writer.WriteU32(msg.head.playerId);
+        writer.WriteU32(msg.head.sequenceNumber);
+        for (auto &&player : msg.players)
+        {
+            writer.WriteU32(player.playerId);
+            writer.WriteU32(uint32_t(player.score));
+            writer.WriteU32(std::bit_cast<uint32_t>(player.position.x));
+            writer.WriteU32(std::bit_cast<uint32_t>(player.position.y));
+        }
+        writer.WriteU32(std::bit_cast<uint32_t>(msg.ball.position.x));
+        writer.WriteU32(std::bit_cast<uint32_t>(msg.ball.position.y));
+        writer.WriteU32(std::bit_cast<uint32_t>(msg.ball.velocity.x));
+        writer.WriteU32(std::bit_cast<uint32_t>(msg.ball.velocity.y));
+        writer.WriteU8(msg.events.hasHit);
+        writer.WriteU8(msg.events.playerWasHit);
+        writer.WriteU8(msg.events.hasSmashed);
+        writer.WriteU8(msg.events.newRound);
+        writer.WriteU8(uint8_t(msg.state));
+        return writer.IsOk() ? writer.GetSize() : 0;
+    }
+
+    static uint16_t QuantizePosition(float value, float size)
+    {
+        const float extent = size * (1.0f + 2.0f * wire::c_arenaMargin);
+        const float t = std::clamp((value + size * wire::c_arenaMargin) / extent, 0.0f, 1.0f);
+        return uint16_t(std::lround(t * 65535.0f));
+    }
+
+    static float DequantizePosition(uint16_t value, float size)
+    {
+        const float extent = size * (1.0f + 2.0f * wire::c_arenaMargin);
+        return value / 65535.0f * extent - size * wire::c_arenaMargin;
+    }
+
+    static int16_t QuantizeVelocity(float value)
+    {
+        return int16_t(std::lround(std::clamp(value * wire::c_velocityScale, -32767.0f, 32767.0f)));
+    }
+
+    static uint8_t PackEvents(const Events &events)
+    {
+        return uint8_t(events.hasHit) | uint8_t(events.playerWasHit) << 1 | uint8_t(events.hasSmashed) << 2 | uint8_t(events.newRound) << 3;
+    }
+
+    static const QuantizedPlayer *FindPlayer(const QuantizedSnapshot &snapshot, uint32_t playerId)
+    {
+        for (auto &&player : snapshot.players)
+        {
+            if (player.playerId == playerId)
+            {
+                return &player;
+            }
+        }
+        return nullptr;
+    }
+
+    void SnapshotBaselines::Store(const QuantizedSnapshot &snapshot)
+    {
+        m_snapshots[snapshot.snapshotId % c_size] = snapshot;
+        m_valid[snapshot.snapshotId % c_size] = true;
+    }
+
+    const QuantizedSnapshot *SnapshotBaselines::Find(uint16_t snapshotId) const
+    {
+        const uint32_t index = snapshotId % c_size;
+        if (!m_valid[index] || m_snapshots[index].snapshotId != snapshotId)
+        {
+            return nullptr;
+        }
+        return &m_snapshots[index];
+    }
+
+    bool IsGameStateV2(const uint8_t *data, size_t size)
+    {
+        return size >= 2 && data[0] == wire::c_magic[0] && data[1] == wire::c_magic[1];
+    }
+
+    DecodeResult DecodeGameStateV2(const uint8_t *data, size_t size, const SnapshotBaselines &baselines, QuantizedSnapshot &snapshot)
+    {
+        if (size > wire::c_maxFrameSizeV2)
+        {
+            return DecodeResult::TooLong;
+        }
+        if (!IsGameStateV2(data, size))
+        {
+            return DecodeResult::BadMagic;
+        }
+
+        WireReader reader(data + 2, size - 2);
+        const uint8_t flags = reader.ReadU8();
+        snapshot.snapshotId = reader.ReadU16();
+
+        const QuantizedSnapshot *baseline = nullptr;
+        if (flags & wire::c_flagDelta)
+        {
+            const uint16_t baselineId = reader.ReadU16();
+            if (!reader.IsOk())
+            {
+                return DecodeResult::TooShort;
+            }
+
+            baseline = baselines.Find(baselineId);
+            if (baseline == nullptr)
+            {
+                return DecodeResult::MissingBaseline;
+            }
+        }
+
+        // Anything not in the frame must come from the baseline
+        auto require = [&](bool present)
+        {
+            return present || baseline != nullptr;
+        };
+
+        if (!require(flags & wire::c_flagPlayerId) || !require(flags & wire::c_flagInputSequence))
+        {
+            return DecodeResult::BadDelta;
+        }
+        snapshot.playerId = (flags & wire::c_flagPlayerId) ? reader.ReadU32() : baseline->playerId;
+        snapshot.inputSequence = (flags & wire::c_flagInputSequence) ? reader.ReadU32() : baseline->inputSequence;
+
+        const uint8_t stateAndEvents = reader.ReadU8();
+        snapshot.state = stateAndEvents & 0x0F;
+        snapshot.events = stateAndEvents >> 4;
+        if (snapshot.state > uint8_t(GameState::GameOver))
+        {
+            return DecodeResult::BadState;
+        }
+
+        const uint8_t ballMask = reader.ReadU8();
+        if (!require(ballMask & wire::c_fieldPosition) || !require(ballMask & wire::c_fieldVelocity))
+        {
+            return DecodeResult::BadDelta;
+        }
+
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            snapshot.ballPosition[i] = (ballMask & wire::c_fieldPosition) ? reader.ReadU16() : baseline->ballPosition[i];
+        }
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            snapshot.ballVelocity[i] = (ballMask & wire::c_fieldVelocity) ? reader.ReadI16() : baseline->ballVelocity[i];
+        }
+
+        const uint8_t playerCount = reader.ReadU8();
+        if (playerCount > c_maxPlayers)
+        {
+            return DecodeResult::TooLong;
+        }
+
+        snapshot.players.clear();
+        for (uint32_t i = 0; i < playerCount; i++)
+        {
+            QuantizedPlayer player;
+            player.playerId = reader.ReadU32();
+            const uint8_t mask = reader.ReadU8();
+
+            const QuantizedPlayer *previous = baseline != nullptr ? FindPlayer(*baseline, player.playerId) : nullptr;
+            if ((!(mask & wire::c_fieldScore) || !(mask & wire::c_fieldPosition)) && previous == nullptr)
+            {
+                return reader.IsOk() ? DecodeResult::BadDelta : DecodeResult::TooShort;
+            }
+
+            player.score = (mask & wire::c_fieldScore) ? reader.ReadI16() : previous->score;
+            for (uint32_t j = 0; j < 2; j++)
+            {
+                player.position[j] = (mask & wire::c_fieldPosition) ? reader.ReadU16() : previous->position[j];
+            }
+            snapshot.players.push_back(player);
+        }
+
+        if (!reader.IsOk())
+        {
+            return DecodeResult::TooShort;
+        }
+        if (reader.GetRemaining() != 0)
+        {
+            return DecodeResult::BadLength;
+        }
+
+        return DecodeResult::Ok;
+    }
+
+    size_t EncodeGameStateV2(const QuantizedSnapshot &snapshot, const QuantizedSnapshot *baseline, uint8_t *data, size_t capacity)
+    {
+        WireWriter writer(data, capacity);
+        writer.WriteU8(wire::c_magic[0]);
+        writer.WriteU8(wire::c_magic[1]);
+
+        uint8_t flags = 0;
+        if (baseline != nullptr)
+        {
+            flags |= wire::c_flagDelta;
+        }
+        if (baseline == nullptr || baseline->playerId != snapshot.playerId)
+        {
+            flags |= wire::c_flagPlayerId;
+        }
+        if (baseline == nullptr || baseline->inputSequence != snapshot.inputSequence)
+        {
+            flags |= wire::c_flagInputSequence;
+        }
+
+        writer.WriteU8(flags);
+        writer.WriteU16(snapshot.snapshotId);
+        if (baseline != nullptr)
+        {
+            writer.WriteU16(baseline->snapshotId);
+        }
+        if (flags & wire::c_flagPlayerId)
+        {
+            writer.WriteU32(snapshot.playerId);
+        }
+        if (flags & wire::c_flagInputSequence)
+        {
+            writer.WriteU32(snapshot.inputSequence);
+        }
+
+        writer.WriteU8(uint8_t(snapshot.state & 0x0F) | uint8_t(snapshot.events << 4));
+
+        uint8_t ballMask = 0;
+        if (baseline == nullptr || !std::equal(std::begin(snapshot.ballPosition), std::end(snapshot.ballPosition), std::begin(baseline->ballPosition)))
+        {
+            ballMask |= wire::c_fieldPosition;
+        }
+        if (baseline == nullptr || !std::equal(std::begin(snapshot.ballVelocity), std::end(snapshot.ballVelocity), std::begin(baseline->ballVelocity)))
+        {
+            ballMask |= wire::c_fieldVelocity;
+        }
+
+        writer.WriteU8(ballMask);
+        if (ballMask & wire::c_fieldPosition)
+        {
+            writer.WriteU16(snapshot.ballPosition[0]);
+            writer.WriteU16(snapshot.ballPosition[1]);
+        }
+        if (ballMask & wire::c_fieldVelocity)
+        {
+            writer.WriteI16(snapshot.ballVelocity[0]);
+            writer.WriteI16(snapshot.ballVelocity[1]);
+        }
+
+        writer.WriteU8(uint8_t(snapshot.players.size()));
+        for (auto &&player : snapshot.players)
+        {
+            const QuantizedPlayer *previous = baseline != nullptr ? FindPlayer(*baseline, player.playerId) : nullptr;
+
+            uint8_t mask = 0;
+            if (previous == nullptr || previous->score != player.score)
+            {
+                mask |= wire::c_fieldScore;
+            }
+            if (previous == nullptr || !std::equal(std::begin(player.position), std::end(player.position), std::begin(previous->position)))
+            {
+                mask |= wire::c_fieldPosition;
+            }
+
+            writer.WriteU32(player.playerId);
+            writer.WriteU8(mask);
+            if (mask & wire::c_fieldScore)
+            {
+                writer.WriteI16(player.score);
+            }
+            if (mask & wire::c_fieldPosition)
+            {
+                writer.WriteU16(player.position[0]);
+                writer.WriteU16(player.position[1]);
+            }
+        }
+
+        return writer.IsOk() ? writer.GetSize() : 0;
+    }
+
+    size_t EncodeSnapshotAck(uint16_t snapshotId, uint8_t *data, size_t capacity)
+    {
+        WireWriter writer(data, capacity);
+        writer.WriteU8(wire::c_ackMagic[0]);
+        writer.WriteU8(wire::c_ackMagic[1]);
+        writer.WriteU16(snapshotId);
+        return writer.IsOk() ? writer.GetSize() : 0;
+    }
+
+    size_t EncodeInputPacket(const InputMessage *inputs, size_t count, uint8_t *data, size_t capacity)
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        const size_t sent = std::min<size_t>(count, wire::c_inputRedundancy);
+        const InputMessage &newest = inputs[count - 1];
+
+        WireWriter writer(data, capacity);
+        writer.WriteU8(wire::c_inputMagic[0]);
+        writer.WriteU8(wire::c_inputMagic[1]);
+        writer.WriteU8(uint8_t(sent));
+        writer.WriteU32(newest.sequenceNumber);
+        writer.WriteU64(newest.timestamp);
+        for (size_t i = 0; i < sent; i++)
+        {
+            const InputMessage &input = inputs[count - 1 - i];
+            writer.WriteU8(uint8_t(input.upPressed) | uint8_t(input.downPressed) << 1);
+        }
+
+        return writer.IsOk() ? writer.GetSize() : 0;
+    }
+
+    DecodeResult DecodeSnapshotAck(const uint8_t *data, size_t size, uint16_t &snapshotId)
+    {
+        if (size != wire::c_ackSize)
+        {
+            return DecodeResult::BadLength;
+        }
+        if (data[0] != wire::c_ackMagic[0] || data[1] != wire::c_ackMagic[1])
+        {
+            return DecodeResult::BadMagic;
+        }
+
+        WireReader reader(data + 2, size - 2);
+        snapshotId = reader.ReadU16();
+        return DecodeResult::Ok;
+    }
+
+    DecodeResult DecodeInputPacket(const uint8_t *data, size_t size, InputPacket &packet)
+    {
+        if (size < 2 || data[0] != wire::c_inputMagic[0] || data[1] != wire::c_inputMagic[1])
+        {
+            return DecodeResult::BadMagic;
+        }
+
+        WireReader reader(data + 2, size - 2);
+        const uint8_t count = reader.ReadU8();
+        packet.newestSequence = reader.ReadU32();
+        packet.timestamp = reader.ReadU64();
+        if (count == 0 || count > wire::c_inputRedundancy)
+        {
+            return DecodeResult::BadLength;
+        }
+
+        packet.inputs.clear();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint8_t buttons = reader.ReadU8();
+            if (buttons > 3)
+            {
+                return DecodeResult::BadEvent;
+            }
+            packet.inputs.push_back({bool(buttons & 1), bool(buttons & 2)});
+        }
+
+        if (!reader.IsOk())
+        {
+            return DecodeResult::TooShort;
+        }
+        return reader.GetRemaining() == 0 ? DecodeResult::Ok : DecodeResult::BadLength;
+    }
+
+    DecodeResult DecodeInputMessage(const uint8_t *data, size_t size, InputMessage &input)
+    {
+        // Raw struct layout: two bools, two bytes of padding, u32 sequence, u64 timestamp
+        if (size != 16)
+        {
+            return DecodeResult::BadLength;
+        }
+
+        WireReader reader(data, size);
+        input.upPressed = reader.ReadU8() != 0;
+        input.downPressed = reader.ReadU8() != 0;
+        reader.ReadU8();
+        reader.ReadU8();
+        input.sequenceNumber = reader.ReadU32();
+        input.timestamp = reader.ReadU64();
+        return DecodeResult::Ok;
+    }
+
+    size_t EncodePing(uint32_t pingId, uint64_t clientTime, uint8_t *data, size_t capacity)
+    {
+        WireWriter writer(data, capacity);
+        writer.WriteU8(wire::c_pingMagic[0]);
+        writer.WriteU8(wire::c_pingMagic[1]);
+        writer.WriteU32(pingId);
+        writer.WriteU64(clientTime);
+        return writer.IsOk() ? writer.GetSize() : 0;
+    }
+
+    DecodeResult DecodePing(const uint8_t *data, size_t size, PingExchange &exchange)
+    {
+        if (size != wire::c_pingSize)
+        {
+            return DecodeResult::BadLength;
+        }
+        if (data[0] != wire::c_pingMagic[0] || data[1] != wire::c_pingMagic[1])
+        {
+            return DecodeResult::BadMagic;
+        }
+
+        WireReader reader(data + 2, size - 2);
+        exchange.pingId = reader.ReadU32();
+        exchange.clientTime = reader.ReadU64();
+        return DecodeResult::Ok;
+    }
+
+    size_t EncodePong(const PingExchange &exchange, uint8_t *data, size_t capacity)
+    {
+        WireWriter writer(data, capacity);
+        writer.WriteU8(wire::c_pongMagic[0]);
+        writer.WriteU8(wire::c_pongMagic[1]);
+        writer.WriteU32(exchange.pingId);
+        writer.WriteU64(exchange.clientTime);
+        writer.WriteU64(exchange.serverReceiveTime);
+        writer.WriteU64(exchange.serverSendTime);
+        return writer.IsOk() ? writer.GetSize() : 0;
+    }
+
+    bool IsPong(const uint8_t *data, size_t size)
+    {
+        return size >= 2 && data[0] == wire::c_pongMagic[0] && data[1] == wire::c_pongMagic[1];
+    }
+
+    DecodeResult DecodePong(const uint8_t *data, size_t size, PingExchange &exchange)
+    {
+        if (size != wire::c_pongSize)
+        {
+            return DecodeResult::BadLength;
+        }
+        if (!IsPong(data, size))
+        {
+            return DecodeResult::BadMagic;
+        }
+
+        WireReader reader(data + 2, size - 2);
+        exchange.pingId = reader.ReadU32();
+        exchange.clientTime = reader.ReadU64();
+        exchange.serverReceiveTime = reader.ReadU64();
+        exchange.serverSendTime = reader.ReadU64();
+        return DecodeResult::Ok;
+    }
+
+    int32_t SnapshotIdDifference(uint16_t newer, uint16_t older)
+    {
+        const int32_t period = wire::c_noBaseline;
+        const int32_t difference = (int32_t(newer) - int32_t(older) + period) % period;
+        return difference > period / 2 ? difference - period : difference;
+    }
+
+    QuantizedSnapshot QuantizeSnapshot(const GameStateMessage &msg, uint16_t snapshotId)
+    {
+        QuantizedSnapshot snapshot;
+        snapshot.snapshotId = snapshotId;
+        snapshot.playerId = msg.head.playerId;
+        snapshot.inputSequence = msg.head.sequenceNumber;
+        snapshot.state = uint8_t(msg.state);
+        snapshot.events = PackEvents(msg.events);
+        snapshot.ballPosition[0] = QuantizePosition(msg.ball.position.x, wire::c_arenaWidth);
+        snapshot.ballPosition[1] = QuantizePosition(msg.ball.position.y, wire::c_arenaHeight);
+        snapshot.ballVelocity[0] = QuantizeVelocity(msg.ball.velocity.x);
+        snapshot.ballVelocity[1] = QuantizeVelocity(msg.ball.velocity.y);
+
+        for (auto &&player : msg.players)
+        {
+            QuantizedPlayer quantized;
+            quantized.playerId = player.playerId;
+            quantized.score = int16_t(std::clamp(player.score, -32768, 32767));
+            quantized.position[0] = QuantizePosition(player.position.x, wire::c_arenaWidth);
+            quantized.position[1] = QuantizePosition(player.position.y, wire::c_arenaHeight);
+            snapshot.players.push_back(quantized);
+        }
+
+        return snapshot;
+    }
+
+    void DequantizeSnapshot(const QuantizedSnapshot &snapshot, GameStateMessage &msg)
+    {
+        msg.head.playerId = snapshot.playerId;
+        msg.head.sequenceNumber = snapshot.inputSequence;
+        msg.state = GameState(snapshot.state);
+        msg.events.hasHit = snapshot.events & (1 << 0);
+        msg.events.playerWasHit = snapshot.events & (1 << 1);
+        msg.events.hasSmashed = snapshot.events & (1 << 2);
+        msg.events.newRound = snapshot.events & (1 << 3);
+        msg.ball.position.x = DequantizePosition(snapshot.ballPosition[0], wire::c_arenaWidth);
+        msg.ball.position.y = DequantizePosition(snapshot.ballPosition[1], wire::c_arenaHeight);
+        msg.ball.velocity.x = snapshot.ballVelocity[0] / wire::c_velocityScale;
+        msg.ball.velocity.y = snapshot.ballVelocity[1] / wire::c_velocityScale;
+
+        msg.players.clear();
+        for (auto &&quantized : snapshot.players)
+        {
+            Player player;
+            player.playerId = quantized.playerId;
+            player.score = quantized.score;
+            player.position.x = DequantizePosition(quantized.position[0], wire::c_arenaWidth);
+            player.position.y = DequantizePosition(quantized.position[1], wire::c_arenaHeight);
+            msg.players.push_back(player);
+        }
+    }
+}
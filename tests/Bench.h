@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace pong::bench
+{
+    // Keeps the compiler from dropping work whose result is otherwise unused
+    template <typename T>
+    inline void DoNotOptimize(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Calls function in growing batches until a batch takes at least minTime seconds, returns
+    // nanoseconds per call of the last batch
+    template <typename Function>
+    double Measure(Function &&function, double minTime = 0.25)
+    {
+        for (size_t iterations = 1;; iterations *= 2)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; i++)
+            {
+                function();
+            }
+            const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (elapsed >= minTime)
+            {
+                return elapsed * 1e9 / double(iterations);
+            }
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#include "Bench.h"
+
+#include "pong/BotBatch.h"
+#include "pong/JobSystem.h"
+#include "pong/Profiler.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace pong;
+
+// Observations of bots spread over many matches, balls heading both ways
+static std::vector<BotObservation> MakeObservations(uint32_t count)
+{
+    uint32_t random = 2463534242u;
+    auto next = [&]
+    {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        return float(random >> 8) / float(1 << 24);
+    };
+
+    std::vector<BotObservation> observations(count);
+    for (auto &&observation : observations)
+    {
+        observation.ball.position = {100.0f + 600.0f * next(), 20.0f + 560.0f * next()};
+        observation.ball.velocity = {(next() - 0.5f) * 800.0f, (next() - 0.5f) * 600.0f};
+        observation.paddle = {next() < 0.5f ? 20.0f : 770.0f, 500.0f * next()};
+        observation.valid = true;
+    }
+    return observations;
+}
+
+static void Initialize(BotBatch &batch, uint32_t count)
+{
+    batch.Initialize({});
+    for (uint32_t i = 0; i < count; i++)
+    {
+        // Reacting every frame, so every decision predicts an intercept
+        batch.Add({0.0f, 30.0f, 4.0f}, i);
+    }
+}
+
+static bool SameDecisions(const std::vector<InputMessage> &a, const std::vector<InputMessage> &b)
+{
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (a[i].upPressed != b[i].upPressed || a[i].downPressed != b[i].downPressed || a[i].sequenceNumber != b[i].sequenceNumber)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Usage: BotBench [bots] [max workers]
+int main(int argc, char **argv)
+{
+    const uint32_t botCount = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    const uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    const uint32_t maxWorkers = argc > 2 ? uint32_t(std::strtoul(argv[2], nullptr, 10)) : hardwareThreads - 1;
+    const float deltaTime = 1.0f / 60.0f;
+
+    const std::vector<BotObservation> observations = MakeObservations(botCount);
+    std::printf("%u bots, %u hardware threads\n", botCount, hardwareThreads);
+
+    // Decided inline once, every worker count has to reach the same decisions
+    std::vector<InputMessage> reference(botCount);
+    {
+        BotBatch batch;
+        Initialize(batch, botCount);
+        batch.DecideAll(observations.data(), reference.data(), deltaTime, 0, nullptr);
+    }
+
+    double baseline = 0.0;
+    bool consistent = true;
+    for (uint32_t workers = 0; workers <= maxWorkers; workers++)
+    {
+        Profiler profiler;
+        JobSystem jobs;
+        profiler.Initialize(workers + 1);
+        jobs.Initialize(workers, &profiler);
+
+        BotBatch batch;
+        Initialize(batch, botCount);
+        std::vector<InputMessage> decisions(botCount);
+        batch.DecideAll(observations.data(), decisions.data(), deltaTime, 0, &jobs);
+        consistent = consistent && SameDecisions(reference, decisions);
+
+        const double ns = bench::Measure([&]
+                                         {
+                                             batch.DecideAll(observations.data(), decisions.data(), deltaTime, 0, &jobs);
+                                             bench::DoNotOptimize(decisions.data()); });
+        baseline = workers == 0 ? ns : baseline;
+
+        const double decisionsPerSecond = double(botCount) * 1e9 / ns;
+        std::printf("%3u workers %10.3f ms/batch %12.0f decisions/s %6.2fx\n", workers, ns / 1e6, decisionsPerSecond, baseline / ns);
+        jobs.Terminate();
+    }
+
+    if (!consistent)
+    {
+        std::fprintf(stderr, "BotBench: decisions differ between worker counts\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,226 @@
+#include "Test.h"
+
+#include "pong/Capture.h"
+#include "pong/ReplayTransport.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace pong;
+
+static constexpr uint32_t c_recordCount = 600; // Past two index intervals
+static constexpr double c_startTime = 100.0;
+
+static CaptureDirection GetDirection(uint32_t i)
+{
+    return i % 3 == 2 ? CaptureDirection::Sent : CaptureDirection::Received;
+}
+
+static double GetTime(uint32_t i)
+{
+    return 0.01 * i;
+}
+
+static std::vector<uint8_t> GetPayload(uint32_t i)
+{
+    std::vector<uint8_t> payload(i % 37);
+    for (size_t j = 0; j < payload.size(); j++)
+    {
+        payload[j] = uint8_t(i * 31 + j);
+    }
+    return payload;
+}
+
+static bool WriteCapture(const std::string &path)
+{
+    CaptureWriter writer;
+    if (!writer.Open(path, c_startTime))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < c_recordCount; i++)
+    {
+        const std::vector<uint8_t> payload = GetPayload(i);
+        if (!writer.Write(GetDirection(i), c_startTime + GetTime(i), payload.data(), payload.size()))
+        {
+            return false;
+        }
+    }
+    writer.Close();
+    return true;
+}
+
+static bool IsRecord(const CaptureRecord &record, uint32_t i)
+{
+    return record.direction == GetDirection(i) && std::abs(record.time - GetTime(i)) < 1e-6 && record.payload == GetPayload(i);
+}
+
+// Reads from the current position to the end, returns the number of records that matched in order
+static uint32_t ReadAll(CaptureReader &reader, uint32_t first)
+{
+    CaptureRecord record;
+    uint32_t i = first;
+    while (reader.Next(record))
+    {
+        if (!PONG_CHECK(IsRecord(record, i)))
+        {
+            break;
+        }
+        i++;
+    }
+    return i - first;
+}
+
+static uint64_t ReadU64(const std::vector<uint8_t> &data, size_t offset)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < 8; i++)
+    {
+        value |= uint64_t(data[offset + i]) << (8 * i);
+    }
+    return value;
+}
+
+// Turns a closed capture into what a crash leaves behind: no index and zero counts in the header
+static void Unclose(const std::string &path)
+{
+    std::vector<uint8_t> data;
+    {
+        std::ifstream file(path, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    const uint64_t indexOffset = ReadU64(data, 8);
+    data.resize(indexOffset);
+    std::fill(data.begin() + 8, data.begin() + 24, 0);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(data.data()), std::streamsize(data.size()));
+}
+
+static void TestRoundTrip(const std::string &path)
+{
+    PONG_CHECK(WriteCapture(path));
+
+    CaptureReader reader;
+    PONG_CHECK(reader.Open(path));
+    PONG_CHECK(reader.HasIndex());
+    PONG_CHECK(reader.GetRecordCount() == c_recordCount);
+    PONG_CHECK(reader.GetStartTime() == c_startTime);
+    // Stops at the index instead of reading it as records
+    PONG_CHECK(ReadAll(reader, 0) == c_recordCount);
+}
+
+static void TestSeek(const std::string &path, bool indexed)
+{
+    CaptureReader reader;
+    PONG_CHECK(reader.Open(path));
+    PONG_CHECK(reader.HasIndex() == indexed);
+
+    // Between records 300 and 301, past the second index entry
+    PONG_CHECK(reader.Seek(3.005));
+    PONG_CHECK(ReadAll(reader, 301) == c_recordCount - 301);
+
+    PONG_CHECK(reader.Seek(0.0));
+    PONG_CHECK(ReadAll(reader, 0) == c_recordCount);
+
+    PONG_CHECK(!reader.Seek(GetTime(c_recordCount)));
+}
+
+static void TestUnclosed(const std::string &path)
+{
+    PONG_CHECK(WriteCapture(path));
+    Unclose(path);
+
+    CaptureReader reader;
+    PONG_CHECK(reader.Open(path));
+    PONG_CHECK(!reader.HasIndex());
+    PONG_CHECK(ReadAll(reader, 0) == c_recordCount);
+    TestSeek(path, false);
+}
+
+static void TestTruncated(const std::string &path)
+{
+    PONG_CHECK(WriteCapture(path));
+    Unclose(path);
+
+    // Cut into the payload of the last record
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+    CaptureReader reader;
+    PONG_CHECK(reader.Open(path));
+    PONG_CHECK(ReadAll(reader, 0) == c_recordCount - 1);
+    CaptureRecord record;
+    PONG_CHECK(!reader.Next(record));
+
+    // Cut into a record header
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - GetPayload(c_recordCount - 1).size() - capture::c_recordHeaderSize + 4);
+    PONG_CHECK(reader.Open(path));
+    PONG_CHECK(ReadAll(reader, 0) == c_recordCount - 1);
+
+    // Too short for a header
+    std::filesystem::resize_file(path, capture::c_headerSize - 1);
+    PONG_CHECK(!reader.Open(path));
+}
+
+struct ReplayState
+{
+    std::vector<std::vector<uint8_t>> frames;
+};
+
+static void OnReplay(const uint8_t *data, size_t size, void *userData)
+{
+    reinterpret_cast<ReplayState *>(userData)->frames.emplace_back(data, data + size);
+}
+
+static void TestReplay(const std::string &path)
+{
+    PONG_CHECK(WriteCapture(path));
+
+    ReplayState state;
+    ReplayTransport transport;
+    PONG_CHECK(transport.Connect("replay://" + path + "?fast=1&step=0.5", OnReplay, &state));
+    PONG_CHECK(transport.IsOpen());
+    PONG_CHECK(transport.GetTime() == c_startTime);
+
+    // Half a second per poll delivers 50 records worth of time, only the received ones
+    transport.Poll();
+    PONG_CHECK(state.frames.size() == 34);
+
+    for (uint32_t polls = 0; transport.IsOpen() && polls < 100; polls++)
+    {
+        transport.Poll();
+    }
+    PONG_CHECK(!transport.IsOpen());
+
+    uint32_t received = 0;
+    for (uint32_t i = 0; i < c_recordCount; i++)
+    {
+        if (GetDirection(i) == CaptureDirection::Received)
+        {
+            PONG_CHECK(received < state.frames.size() && state.frames[received] == GetPayload(i));
+            received++;
+        }
+    }
+    PONG_CHECK(state.frames.size() == received);
+}
+
+int main()
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "pong_capture_test.pongcap").string();
+    TestRoundTrip(path);
+    TestSeek(path, true);
+    TestUnclosed(path);
+    TestTruncated(path);
+    TestReplay(path);
+
+    CaptureWriter writer;
+    PONG_CHECK(!writer.Open((std::filesystem::temp_directory_path() / "missing" / "capture.pongcap").string(), 0.0));
+    PONG_CHECK(!writer.IsOpen());
+
+    std::filesystem::remove(path);
+    return test::Finish("CaptureTest");
+}
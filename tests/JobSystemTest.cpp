@@ -0,0 +1,124 @@
+#include "Test.h"
+
+#include "pong/JobSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace pong;
+
+static constexpr uint32_t c_children = 8;
+
+struct FamilyData
+{
+    std::atomic<uint32_t> children = 0;
+    std::atomic<uint32_t> continuations = 0;
+    uint32_t childrenSeenByContinuation = 0;
+};
+
+static void ChildJob(void *userData)
+{
+    // Long enough that the parent's own function is usually done first
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    static_cast<FamilyData *>(userData)->children.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void ParentJob(void *)
+{
+}
+
+static void ContinuationJob(void *userData)
+{
+    auto *data = static_cast<FamilyData *>(userData);
+    data->childrenSeenByContinuation = data->children.load(std::memory_order_relaxed);
+    data->continuations.fetch_add(1, std::memory_order_relaxed);
+}
+
+// A parent is only done once its children are, and then starts its continuation exactly once
+static void TestFamilies(JobSystem &jobs)
+{
+    for (uint32_t round = 0; round < 200; round++)
+    {
+        FamilyData data;
+        JobSystem::Job *parent = jobs.Create("Parent", ParentJob, &data);
+        JobSystem::Job *continuation = jobs.Create("Continuation", ContinuationJob, &data);
+        PONG_CHECK(jobs.AddContinuation(parent, continuation));
+        for (uint32_t i = 0; i < c_children; i++)
+        {
+            jobs.Run(jobs.Create("Child", ChildJob, &data, parent));
+        }
+        jobs.Run(parent);
+
+        jobs.Wait(parent);
+        const uint32_t children = data.children.load(std::memory_order_relaxed);
+        jobs.Wait(continuation);
+
+        if (!PONG_CHECK(children == c_children && data.childrenSeenByContinuation == c_children && data.continuations.load() == 1))
+        {
+            return;
+        }
+    }
+}
+
+struct NestedData
+{
+    JobSystem *jobs = nullptr;
+    std::vector<std::atomic<uint32_t>> hits;
+};
+
+static constexpr size_t c_outer = 48;
+static constexpr size_t c_inner = 1000;
+
+static void InnerRange(size_t begin, size_t end, void *userData)
+{
+    auto *hits = static_cast<std::atomic<uint32_t> *>(userData);
+    for (size_t i = begin; i < end; i++)
+    {
+        hits[i].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static void OuterRange(size_t begin, size_t end, void *userData)
+{
+    auto *data = static_cast<NestedData *>(userData);
+    for (size_t i = begin; i < end; i++)
+    {
+        data->jobs->ParallelFor(c_inner, 16, InnerRange, &data->hits[i * c_inner], "Inner");
+    }
+}
+
+// Loops started from inside loop chunks still cover every index exactly once
+static void TestNestedLoops(JobSystem &jobs)
+{
+    NestedData data;
+    data.jobs = &jobs;
+    data.hits = std::vector<std::atomic<uint32_t>>(c_outer * c_inner);
+
+    jobs.ParallelFor(c_outer, 1, OuterRange, &data, "Outer");
+
+    uint32_t wrong = 0;
+    for (auto &&hit : data.hits)
+    {
+        wrong += hit.load(std::memory_order_relaxed) != 1 ? 1 : 0;
+    }
+    PONG_CHECK(wrong == 0);
+}
+
+int main()
+{
+    // Without workers everything runs inline, with them jobs are stolen even on a single core machine
+    for (uint32_t workers : {0u, 3u})
+    {
+        JobSystem jobs;
+        jobs.Initialize(workers);
+        PONG_CHECK(jobs.GetWorkerCount() == workers);
+
+        TestFamilies(jobs);
+        TestNestedLoops(jobs);
+    }
+
+    return test::Finish("job_system");
+}
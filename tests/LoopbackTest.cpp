@@ -0,0 +1,189 @@
+#include "Test.h"
+
+#include "pong/Capture.h"
+#include "pong/Connection.h"
+#include "pong/PaddlePredictor.h"
+#include "pong/SnapshotInterpolator.h"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+using namespace pong;
+
+struct SentCounts
+{
+    uint32_t acks = 0;
+    uint32_t inputPackets = 0;
+    uint32_t rawInputs = 0;
+    uint32_t pings = 0;
+    uint32_t received = 0;
+    uint32_t pongs = 0;
+};
+
+// What the client sent and received, read back from its capture
+static SentCounts CountCapture(const std::string &path)
+{
+    SentCounts counts;
+    CaptureReader reader;
+    if (!PONG_CHECK(reader.Open(path)))
+    {
+        return counts;
+    }
+
+    CaptureRecord record;
+    while (reader.Next(record))
+    {
+        if (record.direction == CaptureDirection::Received)
+        {
+            counts.received++;
+            counts.pongs += IsPong(record.payload.data(), record.payload.size());
+            continue;
+        }
+
+        const uint8_t *data = record.payload.data();
+        const size_t size = record.payload.size();
+        uint16_t snapshotId = 0;
+        InputPacket packet;
+        InputMessage input;
+        PingExchange ping;
+        // A packet with one input has the length of a raw input, so the magic decides first
+        if (DecodeSnapshotAck(data, size, snapshotId) == DecodeResult::Ok)
+        {
+            counts.acks++;
+        }
+        else if (DecodeInputPacket(data, size, packet) == DecodeResult::Ok)
+        {
+            counts.inputPackets++;
+        }
+        else if (DecodePing(data, size, ping) == DecodeResult::Ok)
+        {
+            counts.pings++;
+        }
+        else if (DecodeInputMessage(data, size, input) == DecodeResult::Ok)
+        {
+            counts.rawInputs++;
+        }
+    }
+    return counts;
+}
+
+// Plays two seconds against the in-process server like a match would, holding the up key throughout
+static void TestLoopback(uint32_t protocolVersion)
+{
+    const std::string capturePath = (std::filesystem::temp_directory_path() / "pong_loopback_test.pongcap").string();
+    const float deltaTime = 1.0f / 60.0f;
+    const Simulation::Config rules;
+
+    Connection connection;
+    connection.Initialize("loopback://?proto=" + std::to_string(protocolVersion));
+    PONG_CHECK(connection.IsOpen());
+    PONG_CHECK(connection.StartCapture(capturePath));
+
+    SnapshotInterpolator interpolator;
+    interpolator.Initialize(rules.tickRate);
+    PaddlePredictor predictor;
+    predictor.Initialize(rules);
+
+    glm::vec2 firstBall = {};
+    glm::vec2 lastBall = {};
+    uint32_t validSamples = 0;
+    uint32_t lastTick = 0;
+    bool ticksIncrease = true;
+    float firstPrediction = -1.0f;
+    float firstServerPaddle = -1.0f;
+    float lastServerPaddle = -1.0f;
+
+    for (uint32_t step = 0; step < 120; step++)
+    {
+        std::this_thread::sleep_for(std::chrono::duration<float>(deltaTime));
+        connection.PollMessages();
+        connection.SetPressedUp(true);
+        connection.UpdateInput(deltaTime);
+
+        const double now = connection.GetTime();
+        GameStateMessage *msg = connection.GetLatestMessage();
+        if (msg != nullptr && !msg->handeled)
+        {
+            ticksIncrease = ticksIncrease && msg->tick > lastTick;
+            lastTick = msg->tick;
+
+            for (auto &&player : msg->players)
+            {
+                if (player.playerId == msg->head.playerId)
+                {
+                    firstServerPaddle = firstServerPaddle < 0.0f ? player.position.y : firstServerPaddle;
+                    lastServerPaddle = player.position.y;
+                    predictor.Reconcile(player.position.y, msg->head.sequenceNumber, msg->receiveTime, connection.GetClockStats().roundTrip, connection.GetPendingInputs(), now);
+                    connection.AcknowledgeInput(msg->head.sequenceNumber);
+                }
+            }
+            msg->handeled = true;
+            predictor.Blend(deltaTime);
+        }
+        else
+        {
+            predictor.Step(connection.GetInputState(), deltaTime);
+        }
+
+        if (predictor.IsActive() && firstPrediction < 0.0f)
+        {
+            firstPrediction = predictor.GetPosition();
+        }
+
+        const SnapshotInterpolator::Sample &sample = interpolator.Update(connection.GetMessages(), now, deltaTime);
+        if (sample.valid)
+        {
+            firstBall = validSamples == 0 ? sample.ball.position : firstBall;
+            lastBall = sample.ball.position;
+            validSamples++;
+        }
+    }
+    connection.StopCapture();
+
+    const Connection::ReceiveStats stats = connection.GetReceiveStats();
+    PONG_CHECK(stats.protocolVersion == protocolVersion);
+    PONG_CHECK(stats.frames > 60);
+    PONG_CHECK(stats.rejected == 0 && stats.stale == 0 && stats.dropped == 0);
+    PONG_CHECK(ticksIncrease);
+
+    // Playback lags the newest snapshot by the interpolation delay, the serve starts after a second
+    const SnapshotInterpolator::Stats &interpolation = interpolator.GetStats();
+    PONG_CHECK(validSamples > 60);
+    PONG_CHECK(firstBall != lastBall);
+    PONG_CHECK(interpolation.interpDelay >= 0.03f && interpolation.interpDelay <= 0.25f);
+
+    // Up moves the paddle towards zero, on the server as well as in the prediction
+    PONG_CHECK(predictor.IsActive());
+    if (!PONG_CHECK(predictor.GetPosition() < firstPrediction))
+    {
+        std::fprintf(stderr, "  v%u prediction %g after %g\n", protocolVersion, predictor.GetPosition(), firstPrediction);
+    }
+    PONG_CHECK(lastServerPaddle < firstServerPaddle);
+
+    const SentCounts counts = CountCapture(capturePath);
+    PONG_CHECK(counts.received == stats.frames);
+    if (protocolVersion >= 2)
+    {
+        // Every decoded snapshot is acked, inputs go out as redundant packets and the clock is pinged
+        PONG_CHECK(counts.acks == counts.received - counts.pongs && counts.acks > 60);
+        PONG_CHECK(counts.inputPackets > 30 && counts.rawInputs == 0);
+        PONG_CHECK(counts.pings >= 1 && counts.pongs >= 1);
+        PONG_CHECK(connection.GetClockStats().hasOffset);
+    }
+    else
+    {
+        PONG_CHECK(counts.acks == 0 && counts.inputPackets == 0 && counts.pings == 0);
+        PONG_CHECK(counts.rawInputs > 30);
+    }
+
+    std::filesystem::remove(capturePath);
+}
+
+int main()
+{
+    TestLoopback(1);
+    TestLoopback(2);
+    return test::Finish("LoopbackTest");
+}
@@ -0,0 +1,102 @@
+#include "Bench.h"
+
+#include "pong/Simulation.h"
+#include "pong/WireFormat.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace pong;
+
+// Snapshots the server would send over a minute of play, the left player holding keys in bursts
+static std::vector<GameStateMessage> RecordMatch(uint32_t steps)
+{
+    Simulation simulation;
+    simulation.Initialize({});
+
+    std::vector<GameStateMessage> states;
+    states.reserve(steps);
+    for (uint32_t i = 0; i < steps; i++)
+    {
+        const uint32_t phase = (i / 20) % 4;
+        simulation.ApplyInput(0, i + 1, {phase == 1, phase == 3});
+        simulation.Step();
+
+        GameStateMessage state = simulation.GetState();
+        state.head.playerId = Simulation::c_leftPlayerId;
+        state.head.sequenceNumber = simulation.GetAppliedInput(0);
+        states.push_back(state);
+    }
+    return states;
+}
+
+int main()
+{
+    // Acks arrive a round trip after the snapshot, deltas are against the snapshot that many ticks back
+    const uint32_t c_steps = 3600;
+    const uint32_t c_ackLag = 6;
+
+    const std::vector<GameStateMessage> states = RecordMatch(c_steps);
+    std::vector<QuantizedSnapshot> snapshots;
+    for (uint32_t i = 0; i < c_steps; i++)
+    {
+        snapshots.push_back(QuantizeSnapshot(states[i], uint16_t(i % wire::c_noBaseline)));
+    }
+
+    std::vector<std::vector<uint8_t>> v1Frames(c_steps), fullFrames(c_steps), deltaFrames(c_steps);
+    size_t v1Bytes = 0, fullBytes = 0, deltaBytes = 0;
+    for (uint32_t i = 0; i < c_steps; i++)
+    {
+        v1Frames[i].resize(wire::c_maxFrameSize);
+        v1Frames[i].resize(EncodeGameState(states[i], v1Frames[i].data(), v1Frames[i].size()));
+        fullFrames[i].resize(wire::c_maxFrameSizeV2);
+        fullFrames[i].resize(EncodeGameStateV2(snapshots[i], nullptr, fullFrames[i].data(), fullFrames[i].size()));
+        deltaFrames[i].resize(wire::c_maxFrameSizeV2);
+        const QuantizedSnapshot *baseline = i >= c_ackLag ? &snapshots[i - c_ackLag] : nullptr;
+        deltaFrames[i].resize(EncodeGameStateV2(snapshots[i], baseline, deltaFrames[i].data(), deltaFrames[i].size()));
+
+        v1Bytes += v1Frames[i].size();
+        fullBytes += fullFrames[i].size();
+        deltaBytes += deltaFrames[i].size();
+    }
+
+    const float tickRate = Simulation::Config().tickRate;
+    std::printf("%u snapshots at %.0f Hz, deltas %u ticks behind\n", c_steps, tickRate, c_ackLag);
+    std::printf("%-16s %8.1f bytes/snapshot %8.2f KB/s\n", "v1", double(v1Bytes) / c_steps, v1Bytes * tickRate / c_steps / 1024.0);
+    std::printf("%-16s %8.1f bytes/snapshot %8.2f KB/s\n", "v2 full", double(fullBytes) / c_steps, fullBytes * tickRate / c_steps / 1024.0);
+    std::printf("%-16s %8.1f bytes/snapshot %8.2f KB/s\n", "v2 delta", double(deltaBytes) / c_steps, deltaBytes * tickRate / c_steps / 1024.0);
+
+    GameStateMessage msg;
+    size_t next = 0;
+    const double v1Decode = bench::Measure([&]
+                                           {
+                                               const std::vector<uint8_t> &frame = v1Frames[next++ % c_steps];
+                                               bench::DoNotOptimize(DecodeGameState(frame.data(), frame.size(), msg)); });
+
+    SnapshotBaselines baselines;
+    QuantizedSnapshot decoded;
+    const double fullDecode = bench::Measure([&]
+                                             {
+                                                 const std::vector<uint8_t> &frame = fullFrames[next++ % c_steps];
+                                                 bench::DoNotOptimize(DecodeGameStateV2(frame.data(), frame.size(), baselines, decoded));
+                                                 DequantizeSnapshot(decoded, msg); });
+
+    // Every baseline is stored up front, a client would have stored them as the full frames arrived
+    for (auto &&snapshot : snapshots)
+    {
+        baselines.Store(snapshot);
+    }
+    size_t failed = 0;
+    const double deltaDecode = bench::Measure([&]
+                                              {
+                                                  // Baselines hold the newest 32 snapshots, so only the last ones resolve
+                                                  const uint32_t i = c_steps - 32 + c_ackLag + uint32_t(next++ % (32 - c_ackLag));
+                                                  const std::vector<uint8_t> &frame = deltaFrames[i];
+                                                  failed += DecodeGameStateV2(frame.data(), frame.size(), baselines, decoded) != DecodeResult::Ok;
+                                                  DequantizeSnapshot(decoded, msg); });
+
+    std::printf("%-16s %8.1f ns/op\n", "v1 decode", v1Decode);
+    std::printf("%-16s %8.1f ns/op (with dequantize)\n", "v2 full decode", fullDecode);
+    std::printf("%-16s %8.1f ns/op (with dequantize)\n", "v2 delta decode", deltaDecode);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+#include "Test.h"
+
+#include "pong/SnapshotInterpolator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace pong;
+
+struct PlaybackResult
+{
+    float maxDeviation = 0.0f; // Ticks, how far one frame's advance strayed from the render step
+    uint32_t frames = 0;
+    uint32_t lateSnapshots = 0;
+    float interpDelay = 0.0f;
+};
+
+// A 60 Hz server sends snapshots with the tick in ball.position.x, they arrive after 20 ms plus up to
+// maxJitter of uniform jitter and are played back at 144 Hz for twenty seconds
+static PlaybackResult Play(float maxJitter)
+{
+    constexpr double serverStep = 1.0 / 60.0;
+    constexpr double renderStep = 1.0 / 144.0;
+    constexpr uint32_t ticks = 60 * 20;
+
+    struct Arrival
+    {
+        double time;
+        uint32_t tick;
+    };
+
+    // Fixed LCG so every run sees the same arrivals
+    uint32_t seed = 12345;
+    std::vector<Arrival> arrivals;
+    for (uint32_t tick = 1; tick <= ticks; tick++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        const double jitter = double(seed >> 8) / double(1u << 24) * maxJitter;
+        arrivals.push_back({tick * serverStep + 0.02 + jitter, tick});
+    }
+    std::sort(arrivals.begin(), arrivals.end(), [](const Arrival &a, const Arrival &b)
+              { return a.time < b.time; });
+
+    SnapshotInterpolator interpolator;
+    interpolator.Initialize(60.0f);
+    MessageHistory messages;
+
+    PlaybackResult result;
+    size_t next = 0;
+    uint32_t newestTick = 0;
+    float previousTick = -1.0f;
+    const uint32_t frames = uint32_t(ticks * serverStep / renderStep);
+    for (uint32_t frame = 1; frame <= frames; frame++)
+    {
+        const double now = frame * renderStep;
+
+        // Snapshots older than the newest one are dropped, as Connection does
+        for (; next < arrivals.size() && arrivals[next].time <= now; next++)
+        {
+            if (arrivals[next].tick <= newestTick)
+            {
+                continue;
+            }
+
+            newestTick = arrivals[next].tick;
+            GameStateMessage &message = messages.Push();
+            message = {};
+            message.tick = newestTick;
+            message.receiveTime = arrivals[next].time;
+            message.ball.position.x = float(newestTick);
+        }
+
+        const SnapshotInterpolator::Sample &sample = interpolator.Update(messages, now, float(renderStep));
+        if (!sample.valid)
+        {
+            continue;
+        }
+
+        // The first seconds settle the clock offset and the delay
+        const float tick = sample.ball.position.x;
+        if (now > 2.0 && previousTick >= 0.0f)
+        {
+            const float deviation = std::abs(tick - previousTick - float(renderStep / serverStep));
+            result.maxDeviation = std::max(result.maxDeviation, deviation);
+            result.frames++;
+        }
+        previousTick = tick;
+    }
+
+    result.lateSnapshots = interpolator.GetStats().lateSnapshots;
+    result.interpDelay = interpolator.GetStats().interpDelay;
+    return result;
+}
+
+int main()
+{
+    const PlaybackResult steady = Play(0.0f);
+    PONG_CHECK(steady.frames > 2000);
+    PONG_CHECK(steady.maxDeviation < 0.01f);
+    PONG_CHECK(steady.lateSnapshots == 0);
+
+    // Jitter only sizes the delay, playback still advances at the render rate. The delay covers twice the
+    // average jitter rather than the worst case, so a few percent of the 1200 snapshots may still be late.
+    const PlaybackResult jittered = Play(0.04f);
+    PONG_CHECK(jittered.frames > 2000);
+    PONG_CHECK(jittered.maxDeviation < 0.5f);
+    PONG_CHECK(jittered.lateSnapshots < 60);
+    PONG_CHECK(jittered.interpDelay > steady.interpDelay);
+
+    std::printf("steady: %.4f ticks max deviation, %u late\n", steady.maxDeviation, steady.lateSnapshots);
+    std::printf("jittered: %.4f ticks max deviation, %u late, %.3f s delay\n", jittered.maxDeviation, jittered.lateSnapshots, jittered.interpDelay);
+    return test::Finish("snapshot_interpolator");
+}
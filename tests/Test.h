@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdio>
+
+namespace pong::test
+{
+    inline int s_failures = 0;
+
+    inline bool Check(bool condition, const char *expression, const char *file, int line)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+            s_failures++;
+        }
+        return condition;
+    }
+
+    // Returns the exit code of the test executable
+    inline int Finish(const char *name)
+    {
+        if (s_failures != 0)
+        {
+            std::fprintf(stderr, "%s: %d checks failed\n", name, s_failures);
+            return 1;
+        }
+
+        std::printf("%s: passed\n", name);
+        return 0;
+    }
+}
+
+// Reports a failed check and keeps going, so one run shows every failure
+#define PONG_CHECK(condition) ::pong::test::Check((condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,36 @@
+#include "Bench.h"
+
+#include "pong/TransformKernel.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace pong;
+
+int main()
+{
+    for (size_t count : {size_t(10000), size_t(100000), size_t(1000000)})
+    {
+        // Identity rotations, the kernel does the same work for any values
+        std::vector<float> positions(count, 1.0f), zeros(count, 0.0f), ones(count, 1.0f);
+        const TransformArrays arrays = {positions.data(), positions.data(), positions.data(), zeros.data(), zeros.data(), zeros.data(), ones.data()};
+        std::vector<glm::mat4> out(count);
+
+        for (TransformKernel kernel : {TransformKernel::Scalar, TransformKernel::Sse, TransformKernel::Avx2, TransformKernel::WasmSimd})
+        {
+            if (!IsTransformKernelAvailable(kernel))
+            {
+                continue;
+            }
+
+            const double ns = bench::Measure([&]
+                                             {
+                                                 BuildTransforms(arrays, count, out.data(), kernel);
+                                                 bench::DoNotOptimize(out.data()); });
+            // 7 floats read and 16 written per transform
+            const double bytes = double(count) * (7 + 16) * sizeof(float);
+            std::printf("%8zu transforms %-14s %10.3f ms %8.2f ns/transform %8.2f GB/s\n", count, ToString(kernel), ns / 1e6, ns / double(count), bytes / ns);
+        }
+    }
+    return 0;
+}
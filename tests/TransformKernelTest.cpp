@@ -0,0 +1,171 @@
+#include "Test.h"
+
+#include "pong/TransformKernel.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+using namespace pong;
+
+static constexpr size_t c_padding = 8;
+
+struct Inputs
+{
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+    std::vector<float> scaleX, scaleY, scaleZ;
+
+    TransformArrays View(bool scaled) const
+    {
+        TransformArrays arrays = {positionX.data(), positionY.data(), positionZ.data(), rotationX.data(), rotationY.data(), rotationZ.data(), rotationW.data()};
+        if (scaled)
+        {
+            arrays.scaleX = scaleX.data();
+            arrays.scaleY = scaleY.data();
+            arrays.scaleZ = scaleZ.data();
+        }
+        return arrays;
+    }
+};
+
+static Inputs MakeInputs(size_t count)
+{
+    uint32_t random = 12345;
+    auto next = [&]
+    {
+        random = random * 1664525u + 1013904223u;
+        return float(random >> 8) / float(1 << 24) * 2.0f - 1.0f;
+    };
+
+    Inputs inputs;
+    for (size_t i = 0; i < count; i++)
+    {
+        inputs.positionX.push_back(next() * 400.0f);
+        inputs.positionY.push_back(next() * 300.0f);
+        inputs.positionZ.push_back(next() * 10.0f);
+
+        float q[4] = {next(), next(), next(), next()};
+        const float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        inputs.rotationX.push_back(q[0] / length);
+        inputs.rotationY.push_back(q[1] / length);
+        inputs.rotationZ.push_back(q[2] / length);
+        inputs.rotationW.push_back(q[3] / length);
+
+        inputs.scaleX.push_back(1.0f + next());
+        inputs.scaleY.push_back(1.5f + next());
+        inputs.scaleZ.push_back(2.0f + next());
+    }
+    return inputs;
+}
+
+// Output with a poisoned tail, so writes past count show up
+static std::vector<glm::mat4> MakeOutput(size_t count)
+{
+    std::vector<glm::mat4> out(count + c_padding);
+    std::memset(static_cast<void *>(out.data()), 0xFF, out.size() * sizeof(glm::mat4));
+    return out;
+}
+
+static bool IsPoisoned(const glm::mat4 &matrix)
+{
+    uint8_t bytes[sizeof(glm::mat4)];
+    std::memcpy(bytes, &matrix, sizeof(bytes));
+    for (uint8_t byte : bytes)
+    {
+        if (byte != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static float MaxDifference(const glm::mat4 &a, const glm::mat4 &b)
+{
+    float difference = 0.0f;
+    for (int column = 0; column < 4; column++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            difference = std::max(difference, std::abs(a[column][row] - b[column][row]));
+        }
+    }
+    return difference;
+}
+
+static void TestReference()
+{
+    // Quarter turn around z, scaled by 2 on x, at (1, 2, 3)
+    const float half = std::sqrt(0.5f);
+    const float positionX = 1.0f, positionY = 2.0f, positionZ = 3.0f;
+    const float rotationX = 0.0f, rotationY = 0.0f, rotationZ = half, rotationW = half;
+    const float scaleX = 2.0f, scaleY = 1.0f, scaleZ = 1.0f;
+    const TransformArrays arrays = {&positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ, &rotationW, &scaleX, &scaleY, &scaleZ};
+
+    glm::mat4 matrix;
+    BuildTransformsScalar(arrays, 1, &matrix);
+
+    const float expected[4][4] = {{0, 2, 0, 0}, {-1, 0, 0, 0}, {0, 0, 1, 0}, {1, 2, 3, 1}};
+    for (int column = 0; column < 4; column++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            PONG_CHECK(std::abs(matrix[column][row] - expected[column][row]) < 1e-6f);
+        }
+    }
+}
+
+// Every path against the scalar reference, over sizes that leave every possible tail for widths 4 and 8
+static void TestKernels()
+{
+    const size_t sizes[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 11, 12, 13, 15, 16, 17, 31, 64, 1021};
+    const Inputs inputs = MakeInputs(1021);
+
+    for (TransformKernel kernel : {TransformKernel::Scalar, TransformKernel::Sse, TransformKernel::Avx2, TransformKernel::WasmSimd})
+    {
+        if (!IsTransformKernelAvailable(kernel))
+        {
+            std::printf("TransformKernelTest: %s not available, skipped\n", ToString(kernel));
+            continue;
+        }
+
+        for (bool scaled : {false, true})
+        {
+            const TransformArrays arrays = inputs.View(scaled);
+            for (size_t count : sizes)
+            {
+                std::vector<glm::mat4> expected = MakeOutput(count);
+                std::vector<glm::mat4> actual = MakeOutput(count);
+                BuildTransformsScalar(arrays, count, expected.data());
+                PONG_CHECK(BuildTransforms(arrays, count, actual.data(), kernel));
+
+                // Same expressions in every path, only contraction into FMA could change the last bit
+                float difference = 0.0f;
+                for (size_t i = 0; i < count; i++)
+                {
+                    difference = std::max(difference, MaxDifference(expected[i], actual[i]));
+                }
+                if (!PONG_CHECK(difference <= 1e-4f))
+                {
+                    std::fprintf(stderr, "  %s, %zu transforms, scaled %d: differs by %g\n", ToString(kernel), count, int(scaled), difference);
+                }
+
+                for (size_t i = count; i < actual.size(); i++)
+                {
+                    PONG_CHECK(IsPoisoned(actual[i]));
+                }
+            }
+        }
+    }
+
+    PONG_CHECK(IsTransformKernelAvailable(GetTransformKernel()));
+}
+
+int main()
+{
+    TestReference();
+    TestKernels();
+    return test::Finish("TransformKernelTest");
+}
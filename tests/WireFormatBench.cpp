@@ -0,0 +1,63 @@
+#include "Bench.h"
+
+#include "pong/WireFormat.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace pong;
+
+static GameStateMessage MakeMessage(uint32_t playerCount)
+{
+    GameStateMessage msg;
+    msg.head = {7, 1234};
+    for (uint32_t i = 0; i < playerCount; i++)
+    {
+        msg.players.push_back({100 + i, int32_t(i), {-350.0f + 700.0f * float(i % 2), 12.5f * float(i)}});
+    }
+    msg.ball = {{3.0f, -4.5f}, {-220.0f, 97.125f}};
+    msg.state = GameState::Running;
+    return msg;
+}
+
+static void Report(const char *name, double ns, size_t bytes)
+{
+    if (bytes == 0)
+    {
+        std::printf("%-32s %8.1f ns/op\n", name, ns);
+        return;
+    }
+    std::printf("%-32s %8.1f ns/op %10.1f MB/s\n", name, ns, double(bytes) * 1e3 / ns);
+}
+
+int main()
+{
+    for (uint32_t count : {2u, c_maxPlayers})
+    {
+        const GameStateMessage msg = MakeMessage(count);
+        std::vector<uint8_t> frame(wire::c_maxFrameSize);
+        frame.resize(EncodeGameState(msg, frame.data(), frame.size()));
+
+        GameStateMessage decoded;
+        const double decode = bench::Measure([&]
+                                             {
+                                                 bench::DoNotOptimize(DecodeGameState(frame.data(), frame.size(), decoded));
+                                                 bench::DoNotOptimize(decoded); });
+        const double encode = bench::Measure([&]
+                                             { bench::DoNotOptimize(EncodeGameState(msg, frame.data(), frame.size())); });
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "v1 decode, %u players", count);
+        Report(name, decode, frame.size());
+        std::snprintf(name, sizeof(name), "v1 encode, %u players", count);
+        Report(name, encode, frame.size());
+    }
+
+    // Rejecting garbage has to stay cheap, it is checked on length alone
+    std::vector<uint8_t> garbage(wire::c_fixedSize + 7);
+    GameStateMessage decoded;
+    const double reject = bench::Measure([&]
+                                         { bench::DoNotOptimize(DecodeGameState(garbage.data(), garbage.size(), decoded)); });
+    Report("v1 reject, bad length", reject, 0);
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include "pong/WireFormat.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// Feeds arbitrary bytes to every decoder that reads from the network. Built with PONG_FUZZ it is a
+// libFuzzer target, otherwise main replays the corpus and a fixed set of mutations of it, so the same
+// inputs run under ctest on any compiler.
+
+using namespace pong;
+
+static void Require(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::fprintf(stderr, "WireFormatFuzz: %s\n", what);
+        std::abort();
+    }
+}
+
+static bool operator==(const QuantizedSnapshot &a, const QuantizedSnapshot &b)
+{
+    if (a.snapshotId != b.snapshotId || a.playerId != b.playerId || a.inputSequence != b.inputSequence ||
+        a.state != b.state || a.events != b.events || a.players.size() != b.players.size() ||
+        std::memcmp(a.ballPosition, b.ballPosition, sizeof(a.ballPosition)) != 0 ||
+        std::memcmp(a.ballVelocity, b.ballVelocity, sizeof(a.ballVelocity)) != 0)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.players.size(); i++)
+    {
+        const QuantizedPlayer &p = a.players[i];
+        const QuantizedPlayer &q = b.players[i];
+        if (p.playerId != q.playerId || p.score != q.score || p.position[0] != q.position[0] || p.position[1] != q.position[1])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    // Kept across inputs so delta frames from the corpus find their baselines
+    static SnapshotBaselines baselines;
+
+    GameStateMessage msg;
+    if (DecodeGameState(data, size, msg) == DecodeResult::Ok)
+    {
+        uint8_t frame[wire::c_maxFrameSize];
+        const size_t frameSize = EncodeGameState(msg, frame, sizeof(frame));
+        Require(frameSize == size && std::memcmp(frame, data, size) == 0, "v1 frame does not encode back to the same bytes");
+    }
+
+    QuantizedSnapshot snapshot;
+    if (DecodeGameStateV2(data, size, baselines, snapshot) == DecodeResult::Ok)
+    {
+        // Whatever decodes, deltas included, has to survive a full frame round trip
+        uint8_t frame[wire::c_maxFrameSizeV2];
+        const size_t frameSize = EncodeGameStateV2(snapshot, nullptr, frame, sizeof(frame));
+        Require(frameSize != 0, "decoded v2 snapshot does not fit a full frame");
+
+        QuantizedSnapshot decoded;
+        Require(DecodeGameStateV2(frame, frameSize, baselines, decoded) == DecodeResult::Ok, "re-encoded v2 frame does not decode");
+        Require(decoded == snapshot, "v2 snapshot changed in a round trip");
+        baselines.Store(snapshot);
+    }
+
+    uint16_t snapshotId = 0;
+    DecodeSnapshotAck(data, size, snapshotId);
+    InputPacket packet;
+    DecodeInputPacket(data, size, packet);
+    InputMessage input;
+    DecodeInputMessage(data, size, input);
+    PingExchange exchange;
+    DecodePing(data, size, exchange);
+    DecodePong(data, size, exchange);
+    return 0;
+}
+
+#ifndef PONG_LIBFUZZER
+
+static constexpr uint32_t c_mutations = 200000;
+
+static uint32_t NextRandom(uint32_t &state)
+{
+    // xorshift32, fixed seed so every run feeds the same inputs
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static bool ReadFile(const std::filesystem::path &path, std::vector<uint8_t> &data)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Usage: WireFormatFuzz <corpus directory or file>...
+int main(int argc, char **argv)
+{
+    std::vector<std::vector<uint8_t>> corpus;
+    for (int i = 1; i < argc; i++)
+    {
+        std::vector<std::filesystem::path> paths;
+        if (std::filesystem::is_directory(argv[i]))
+        {
+            for (auto &&entry : std::filesystem::directory_iterator(argv[i]))
+            {
+                paths.push_back(entry.path());
+            }
+        }
+        else
+        {
+            paths.push_back(argv[i]);
+        }
+
+        // Sorted so full frames are seen before the deltas that refer to them
+        std::sort(paths.begin(), paths.end());
+        for (auto &&path : paths)
+        {
+            std::vector<uint8_t> data;
+            if (!ReadFile(path, data))
+            {
+                std::fprintf(stderr, "WireFormatFuzz: could not read %s\n", path.string().c_str());
+                return 1;
+            }
+            corpus.push_back(std::move(data));
+        }
+    }
+
+    if (corpus.empty())
+    {
+        std::fprintf(stderr, "WireFormatFuzz: empty corpus\n");
+        return 1;
+    }
+
+    for (auto &&data : corpus)
+    {
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+    }
+
+    uint32_t random = 0x9E3779B9u;
+    std::vector<uint8_t> input;
+    for (uint32_t i = 0; i < c_mutations; i++)
+    {
+        input = corpus[NextRandom(random) % corpus.size()];
+        const uint32_t edits = 1 + NextRandom(random) % 4;
+        for (uint32_t j = 0; j < edits; j++)
+        {
+            const uint32_t value = NextRandom(random);
+            switch (value % 4)
+            {
+            case 0: // Flip a bit
+                if (!input.empty())
+                {
+                    input[(value >> 8) % input.size()] ^= uint8_t(1 << (value >> 4) % 8);
+                }
+                break;
+            case 1: // Overwrite a byte
+                if (!input.empty())
+                {
+                    input[(value >> 8) % input.size()] = uint8_t(value >> 24);
+                }
+                break;
+            case 2: // Truncate
+                input.resize((value >> 8) % (input.size() + 1));
+                break;
+            case 3: // Append
+                input.push_back(uint8_t(value >> 24));
+                break;
+            }
+        }
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+
+    std::printf("WireFormatFuzz: %zu corpus inputs and %u mutations passed\n", corpus.size(), c_mutations);
+    return 0;
+}
+
+#endif
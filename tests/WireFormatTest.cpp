@@ -0,0 +1,279 @@
+#include "Test.h"
+
+#include "pong/WireFormat.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <vector>
+
+// Counts heap allocations, decoding a frame must not make any
+static size_t s_allocations = 0;
+
+__attribute__((noinline)) void *operator new(size_t size)
+{
+    s_allocations++;
+    if (void *p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+using namespace pong;
+
+static GameStateMessage MakeMessage(uint32_t playerCount)
+{
+    GameStateMessage msg;
+    msg.head = {7, 1234};
+    for (uint32_t i = 0; i < playerCount; i++)
+    {
+        msg.players.push_back({100 + i, int32_t(i) - 2, {-350.25f + float(i), 12.5f * float(i)}});
+    }
+    msg.ball = {{3.0f, -4.5f}, {-220.0f, 97.125f}};
+    msg.events.hasHit = true;
+    msg.events.newRound = true;
+    msg.state = GameState::Running;
+    return msg;
+}
+
+static std::vector<uint8_t> Encode(const GameStateMessage &msg)
+{
+    std::vector<uint8_t> frame(wire::c_maxFrameSize);
+    frame.resize(EncodeGameState(msg, frame.data(), frame.size()));
+    return frame;
+}
+
+static void TestRoundTrip()
+{
+    for (uint32_t count = 0; count <= c_maxPlayers; count++)
+    {
+        const GameStateMessage msg = MakeMessage(count);
+        const std::vector<uint8_t> frame = Encode(msg);
+        PONG_CHECK(frame.size() == wire::c_fixedSize + count * wire::c_playerSize);
+
+        GameStateMessage decoded;
+        const size_t allocations = s_allocations;
+        PONG_CHECK(DecodeGameState(frame.data(), frame.size(), decoded) == DecodeResult::Ok);
+        PONG_CHECK(s_allocations == allocations);
+
+        PONG_CHECK(decoded.head.playerId == msg.head.playerId);
+        PONG_CHECK(decoded.head.sequenceNumber == msg.head.sequenceNumber);
+        PONG_CHECK(decoded.players.size() == count);
+        for (uint32_t i = 0; i < decoded.players.size(); i++)
+        {
+            PONG_CHECK(decoded.players[i].playerId == msg.players[i].playerId);
+            PONG_CHECK(decoded.players[i].score == msg.players[i].score);
+            PONG_CHECK(decoded.players[i].position == msg.players[i].position);
+        }
+        PONG_CHECK(decoded.ball.position == msg.ball.position);
+        PONG_CHECK(decoded.ball.velocity == msg.ball.velocity);
+        PONG_CHECK(decoded.events.hasHit && !decoded.events.playerWasHit && !decoded.events.hasSmashed && decoded.events.newRound);
+        PONG_CHECK(decoded.state == GameState::Running);
+
+        // Whatever decodes encodes back to the same bytes
+        PONG_CHECK(Encode(decoded) == frame);
+    }
+}
+
+static void TestMalformed()
+{
+    const std::vector<uint8_t> frame = Encode(MakeMessage(2));
+    GameStateMessage decoded;
+
+    for (size_t size = 0; size < wire::c_fixedSize; size++)
+    {
+        PONG_CHECK(DecodeGameState(frame.data(), size, decoded) == DecodeResult::TooShort);
+    }
+    for (size_t size = wire::c_fixedSize + 1; size < frame.size(); size++)
+    {
+        if ((size - wire::c_fixedSize) % wire::c_playerSize != 0)
+        {
+            PONG_CHECK(DecodeGameState(frame.data(), size, decoded) == DecodeResult::BadLength);
+        }
+    }
+
+    std::vector<uint8_t> tooLong(wire::c_maxFrameSize + wire::c_playerSize);
+    PONG_CHECK(DecodeGameState(tooLong.data(), tooLong.size(), decoded) == DecodeResult::TooLong);
+
+    // Events are the 5 bytes before the end, state is the last
+    std::vector<uint8_t> badEvent = frame;
+    badEvent[badEvent.size() - 3] = 2;
+    PONG_CHECK(DecodeGameState(badEvent.data(), badEvent.size(), decoded) == DecodeResult::BadEvent);
+
+    std::vector<uint8_t> badState = frame;
+    badState.back() = uint8_t(GameState::GameOver) + 1;
+    PONG_CHECK(DecodeGameState(badState.data(), badState.size(), decoded) == DecodeResult::BadState);
+}
+
+// Reference snapshots of the v2 fixtures, built field by field so the fixture bytes do not depend on float quantization
+static QuantizedSnapshot MakeSnapshot()
+{
+    QuantizedSnapshot snapshot;
+    snapshot.snapshotId = 41;
+    snapshot.playerId = 1;
+    snapshot.inputSequence = 900;
+    snapshot.state = uint8_t(GameState::Running);
+    snapshot.events = 0b0001;
+    snapshot.ballPosition[0] = 32768;
+    snapshot.ballPosition[1] = 30000;
+    snapshot.ballVelocity[0] = -3520;
+    snapshot.ballVelocity[1] = 1554;
+    snapshot.players.push_back({1, 2, {11000, 32768}});
+    snapshot.players.push_back({2, -1, {54536, 31000}});
+    return snapshot;
+}
+
+static QuantizedSnapshot MakeNextSnapshot()
+{
+    QuantizedSnapshot snapshot = MakeSnapshot();
+    snapshot.snapshotId = 42;
+    snapshot.inputSequence = 903;
+    snapshot.events = 0;
+    snapshot.ballPosition[0] = 32500;
+    snapshot.ballPosition[1] = 30120;
+    snapshot.players[1].position[1] = 31200;
+    return snapshot;
+}
+
+static bool Equal(const QuantizedSnapshot &a, const QuantizedSnapshot &b)
+{
+    bool equal = a.snapshotId == b.snapshotId && a.playerId == b.playerId && a.inputSequence == b.inputSequence &&
+                 a.state == b.state && a.events == b.events && a.players.size() == b.players.size() &&
+                 std::memcmp(a.ballPosition, b.ballPosition, sizeof(a.ballPosition)) == 0 &&
+                 std::memcmp(a.ballVelocity, b.ballVelocity, sizeof(a.ballVelocity)) == 0;
+    for (size_t i = 0; equal && i < a.players.size(); i++)
+    {
+        equal = a.players[i].playerId == b.players[i].playerId && a.players[i].score == b.players[i].score &&
+                std::memcmp(a.players[i].position, b.players[i].position, sizeof(a.players[i].position)) == 0;
+    }
+    return equal;
+}
+
+static std::vector<uint8_t> EncodeV2(const QuantizedSnapshot &snapshot, const QuantizedSnapshot *baseline)
+{
+    std::vector<uint8_t> frame(wire::c_maxFrameSizeV2);
+    frame.resize(EncodeGameStateV2(snapshot, baseline, frame.data(), frame.size()));
+    return frame;
+}
+
+static std::vector<uint8_t> ReadFile(const std::filesystem::path &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void WriteFile(const std::filesystem::path &path, const std::vector<uint8_t> &data)
+{
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(data.data()), std::streamsize(data.size()));
+}
+
+// The fixtures are the byte exact frames a server has to produce for these snapshots
+static void TestSnapshotFixtures(const std::filesystem::path &fixtures, bool write)
+{
+    const QuantizedSnapshot first = MakeSnapshot();
+    const QuantizedSnapshot second = MakeNextSnapshot();
+    const std::vector<uint8_t> full = EncodeV2(first, nullptr);
+    const std::vector<uint8_t> delta = EncodeV2(second, &first);
+    PONG_CHECK(full.size() == 24 + 11 * first.players.size());
+    PONG_CHECK(!delta.empty() && delta.size() < full.size());
+
+    if (write)
+    {
+        WriteFile(fixtures / "snapshot_v2_full.bin", full);
+        WriteFile(fixtures / "snapshot_v2_delta.bin", delta);
+    }
+
+    const std::vector<uint8_t> fullFixture = ReadFile(fixtures / "snapshot_v2_full.bin");
+    const std::vector<uint8_t> deltaFixture = ReadFile(fixtures / "snapshot_v2_delta.bin");
+    PONG_CHECK(fullFixture == full);
+    PONG_CHECK(deltaFixture == delta);
+
+    SnapshotBaselines baselines;
+    QuantizedSnapshot decoded;
+    PONG_CHECK(DecodeGameStateV2(deltaFixture.data(), deltaFixture.size(), baselines, decoded) == DecodeResult::MissingBaseline);
+    PONG_CHECK(DecodeGameStateV2(fullFixture.data(), fullFixture.size(), baselines, decoded) == DecodeResult::Ok);
+    PONG_CHECK(Equal(decoded, first));
+    baselines.Store(decoded);
+    PONG_CHECK(DecodeGameStateV2(deltaFixture.data(), deltaFixture.size(), baselines, decoded) == DecodeResult::Ok);
+    PONG_CHECK(Equal(decoded, second));
+
+    for (size_t size = 0; size < deltaFixture.size(); size++)
+    {
+        PONG_CHECK(DecodeGameStateV2(deltaFixture.data(), size, baselines, decoded) != DecodeResult::Ok);
+    }
+}
+
+static void TestQuantization()
+{
+    GameStateMessage msg = MakeMessage(2);
+    const QuantizedSnapshot snapshot = QuantizeSnapshot(msg, 7);
+
+    GameStateMessage restored;
+    DequantizeSnapshot(snapshot, restored);
+    const float positionStep = wire::c_arenaWidth * (1.0f + 2.0f * wire::c_arenaMargin) / 65535.0f;
+    PONG_CHECK(restored.players.size() == 2);
+    for (size_t i = 0; i < restored.players.size(); i++)
+    {
+        PONG_CHECK(restored.players[i].playerId == msg.players[i].playerId);
+        PONG_CHECK(restored.players[i].score == msg.players[i].score);
+        PONG_CHECK(std::abs(restored.players[i].position.x - msg.players[i].position.x) <= positionStep);
+    }
+    PONG_CHECK(std::abs(restored.ball.position.x - msg.ball.position.x) <= positionStep);
+    PONG_CHECK(std::abs(restored.ball.velocity.x - msg.ball.velocity.x) <= 1.0f / wire::c_velocityScale);
+    PONG_CHECK(restored.events.hasHit && restored.events.newRound);
+    PONG_CHECK(restored.state == msg.state);
+}
+
+// The client tells the versions apart by length until one has decoded, a full v2 frame never has the length of a v1 frame
+static void TestVersionLengths()
+{
+    for (size_t v2Players = 0; v2Players <= c_maxPlayers; v2Players++)
+    {
+        for (size_t v1Players = 0; v1Players <= c_maxPlayers; v1Players++)
+        {
+            PONG_CHECK(24 + 11 * v2Players != wire::c_fixedSize + wire::c_playerSize * v1Players);
+        }
+    }
+}
+
+static void TestSnapshotIdDifference()
+{
+    PONG_CHECK(SnapshotIdDifference(5, 4) == 1);
+    PONG_CHECK(SnapshotIdDifference(4, 5) == -1);
+    PONG_CHECK(SnapshotIdDifference(9, 9) == 0);
+    // Ids wrap from 0xFFFE to 0, 0xFFFF is never an id
+    PONG_CHECK(SnapshotIdDifference(0, 0xFFFE) == 1);
+    PONG_CHECK(SnapshotIdDifference(0xFFFE, 0) == -1);
+    PONG_CHECK(SnapshotIdDifference(3, 0xFFFC) == 6);
+    PONG_CHECK(SnapshotIdDifference(0xFFFC, 3) == -6);
+    PONG_CHECK(SnapshotIdDifference(32767, 0) == 32767);
+    PONG_CHECK(SnapshotIdDifference(0, 32767) == -32767);
+}
+
+// Usage: WireFormatTest <fixture directory> [--write-fixtures]
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <fixture directory> [--write-fixtures]\n", argv[0]);
+        return 1;
+    }
+
+    TestRoundTrip();
+    TestMalformed();
+    TestSnapshotFixtures(argv[1], argc > 2 && std::string(argv[2]) == "--write-fixtures");
+    TestQuantization();
+    TestVersionLengths();
+    TestSnapshotIdDifference();
+    return test::Finish("WireFormatTest");
+}